@@ -0,0 +1,53 @@
+#ifndef AoSTrackStack_HH
+#define AoSTrackStack_HH
+
+/**
+ * @file    AoSTrackStack.hh
+ * @class   AoSTrackStack
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief The original, array-of-structures version of the `TrackStack` (reference for the benchmarks).
+ *
+ * The tracks are stored as a vector of complete `G4HepEmTrack`-s: a track is pushed
+ * by copying it into the slot obtained by `Insert()` and popped by copying the top
+ * slot into the input track. It is kept (in its own translation unit as the original)
+ * only as a reference for the `TrackStackBenchmark`.
+ */
+
+#include <vector>
+#include <cstddef>
+
+#include "G4HepEmTrack.hh"
+
+class AoSTrackStack {
+public:
+   /** CTR */
+    AoSTrackStack();
+    /** DTR */
+   ~AoSTrackStack() {}
+
+  /** Pops a track from the stack and writes to the input address (returns -1 if the stack is empty).*/
+  int PopInto(G4HepEmTrack& track);
+
+  /** Returns a reference to a (re-set) track that can be used to push a new track into the stack.*/
+  G4HepEmTrack&  Insert();
+
+  /** Copying the content of the `from` to the `to` track.*/
+  void Copy(G4HepEmTrack& from, G4HepEmTrack& to);
+
+  /** Returns the maximum number of tracks that were stored in the stack at the same time.*/
+  int         GetPeakNumTracks()  const { return fPeakNumTracks; }
+  /** Returns the memory (in bytes) used by the tracks of the stack at its current capacity.*/
+  std::size_t GetMemoryInBytes()  const { return fSize*sizeof(G4HepEmTrack); }
+
+
+private:
+
+  int fSize;                             ///< current capacity of the track stack
+  int fCurIndx;                          ///< number of tracks used from the capacity
+  int fPeakNumTracks;                    ///< maximum number of tracks that were stored at the same time
+  std::vector<G4HepEmTrack> fTrackVect;  ///< the stack as a vector of tracks
+};
+
+#endif // AoSTrackStack_HH
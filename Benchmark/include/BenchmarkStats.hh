@@ -0,0 +1,98 @@
+#ifndef BenchmarkStats_HH
+#define BenchmarkStats_HH
+
+/**
+ * @file    BenchmarkStats.hh
+ * @class   BenchmarkStats
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Statistically robust timing of benchmark kernels with machine readable output.
+ *
+ * A kernel (any callable) is first run a few times without timing (warm-up: page
+ * faults, caches, branch predictors and CPU frequency) then timed repetition by
+ * repetition. The per-item times of the repetitions are summarised by their median
+ * and median absolute deviation (MAD) that are insensitive to the outliers caused
+ * by interrupts or other processes (unlike the mean and standard deviation). An
+ * optional set-up callable is invoked before each (warm-up and timed) repetition
+ * outside of the timing, e.g. to bring a container back to its initial state.
+ *
+ * The results are printed as a table and can be written into a JSON file (with the
+ * compiler, target ISA and time stamp) to track the performance over time.
+ */
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+class BenchmarkStats {
+public:
+
+  /** The summary of the timed repetitions of one kernel (times in [ns] per item).*/
+  struct Result {
+    std::string fName;            ///< name of the kernel
+    long        fNumItems;        ///< number of items (e.g. calls, points, numbers) processed by one repetition
+    int         fNumWarmup;       ///< number of warm-up (not timed) repetitions
+    int         fNumRepetitions;  ///< number of timed repetitions
+    double      fMedian;          ///< median of the per-item times of the repetitions
+    double      fMAD;             ///< median absolute deviation of the per-item times from their median
+    double      fMin;             ///< minimum of the per-item times
+    double      fMax;             ///< maximum of the per-item times
+  };
+
+  /** Times the given kernel (see the description).
+   *
+   * @param[in] name           name of the kernel (used in the printout and the JSON file)
+   * @param[in] numItems       number of items processed by one invocation of the kernel (the times are given per item)
+   * @param[in] numWarmup      number of warm-up (not timed) repetitions
+   * @param[in] numRepetitions number of timed repetitions
+   * @param[in] kernel         the callable to be timed
+   * @param[in] setUp          the callable invoked before each repetition outside of the timing
+   */
+  template <typename Kernel, typename SetUp>
+  static Result Measure(const std::string& name, long numItems, int numWarmup, int numRepetitions, Kernel&& kernel, SetUp&& setUp) {
+    for (int iw=0; iw<numWarmup; ++iw) {
+      setUp();
+      kernel();
+    }
+    std::vector<double> theTimes(numRepetitions);
+    for (int ir=0; ir<numRepetitions; ++ir) {
+      setUp();
+      const auto t0 = std::chrono::steady_clock::now();
+      kernel();
+      const auto t1 = std::chrono::steady_clock::now();
+      theTimes[ir] = 1.0E+9*std::chrono::duration<double>(t1-t0).count()/numItems;
+    }
+    return Summarise(name, numItems, numWarmup, theTimes);
+  }
+
+  /** Times the given kernel without set-up (see above).*/
+  template <typename Kernel>
+  static Result Measure(const std::string& name, long numItems, int numWarmup, int numRepetitions, Kernel&& kernel) {
+    return Measure(name, numItems, numWarmup, numRepetitions, kernel, [](){});
+  }
+
+  /** Prevents the compiler from optimising away the computation of the given value.*/
+  template <typename T>
+  static void DoNotOptimize(const T& value) { asm volatile("" : : "r,m"(value) : "memory"); }
+
+  /** Summarises the given per-item times of the repetitions.*/
+  static Result Summarise(const std::string& name, long numItems, int numWarmup, const std::vector<double>& theTimes);
+
+  /** Median of the given values.*/
+  static double GetMedian(std::vector<double> values);
+
+  /** Prints the header of the result table with the given title.*/
+  static void PrintHeader(const std::string& title);
+
+  /** Prints one row of the result table.*/
+  static void Print(const Result& theResult);
+
+  /** Writes the results of the given suite into a JSON file (false if it cannot be written).*/
+  static bool WriteJSON(const std::string& fileName, const std::string& suite, const std::vector<Result>& theResults);
+
+private:
+  BenchmarkStats() = delete;
+};
+
+#endif // BenchmarkStats_HH
@@ -0,0 +1,44 @@
+#ifndef BoxBenchmark_HH
+#define BoxBenchmark_HH
+
+/**
+ * @file    BoxBenchmark.hh
+ * @class   BoxBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the single point and batch `Box::DistanceToOut` methods.
+ *
+ * The distance to out (along a direction) and the safety are computed for a set of
+ * random points (with isotropic directions) inside the `absorber` box of the default
+ * geometry both by the single point methods (in a loop) and by the batch methods.
+ * A given fraction of the points are set to the tolerance edge cases, i.e. placed on
+ * the `surface` (at zero, half tolerance and just inside/outside half tolerance from
+ * a boundary) or having zero direction components (both signed zeros). The per-point
+ * cost of the two are measured after warm-up over several repetitions (see
+ * `BenchmarkStats`) and reported together with the speedup of the batch methods and
+ * the number of points for which the results are not bit-by-bit identical (must be zero).
+ */
+
+#include "BenchmarkStats.hh"
+
+#include <vector>
+
+class BoxBenchmark {
+public:
+
+  /** Runs the benchmark and writes the results to the standard output.
+   *
+   * @param[in]     numPoints       number of random points (with directions)
+   * @param[in]     edgeFraction    fraction of the points that are set to the tolerance edge cases
+   * @param[in]     numWarmup       number of warm-up (not timed) repetitions of each method
+   * @param[in]     numRepetitions  number of timed repetitions of each method
+   * @param[in,out] theResults      the measurements are appended to this
+   */
+  static void Run(int numPoints, double edgeFraction, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults);
+
+private:
+  BoxBenchmark() = delete;
+};
+
+#endif // BoxBenchmark_HH
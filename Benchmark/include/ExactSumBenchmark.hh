@@ -0,0 +1,38 @@
+#ifndef ExactSumBenchmark_HH
+#define ExactSumBenchmark_HH
+
+/**
+ * @file    ExactSumBenchmark.hh
+ * @class   ExactSumBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the cost and reproducibility of the exact (`ExactSum`) histogram accumulation.
+ *
+ * The same random (layer, value) pairs, with a wide range of values as the energy
+ * deposits of the steps, are filled into a per-layer `Hist`:
+ * - with the plain double and with the exact accumulation (see `Hist::SetExact()`)
+ * - in the original order into a single histogram and in a shuffled order split
+ *   into several histograms that are then merged (as the per-thread replicas with
+ *   a dynamic scheduling of the events)
+ *
+ * The cost per fill is reported together with the number of bins that differ (in
+ * any bit) between the single and the shuffled, merged histograms.
+ */
+
+class ExactSumBenchmark {
+public:
+
+  /** Runs the benchmark and writes the results to the standard output.
+   *
+   * @param[in] numLayers number of bins of the histograms (layers)
+   * @param[in] numFills  number of fills
+   * @param[in] numParts  number of histograms the shuffled fills are split into then merged
+   */
+  static void Run(int numLayers, int numFills, int numParts);
+
+private:
+  ExactSumBenchmark() = delete;
+};
+
+#endif // ExactSumBenchmark_HH
@@ -0,0 +1,54 @@
+#ifndef GeometryBenchmark_HH
+#define GeometryBenchmark_HH
+
+/**
+ * @file    GeometryBenchmark.hh
+ * @class   GeometryBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the `Geometry` location and distance to out computations.
+ *
+ * The per-call cost of the default, `Box` based `Geometry::CalculateDistanceToOutByBoxes()`,
+ * the boundary table based `Geometry::CalculateDistanceToOutByTable()` and the (not
+ * located) navigation state based `Geometry::CalculateDistanceToOut()` are measured
+ * after warm-up over several repetitions (see `BenchmarkStats`) on a shower-like point
+ * cloud in the default calorimeter, i.e. longitudinal depths following a gamma
+ * distribution (the average longitudinal profile of an EM shower), exponential radial
+ * distribution around the axis, mostly forward directions (with some isotropic ones of
+ * the low energy tracks) and some of the points on the `absorber`/`gap` boundaries.
+ *
+ * The results of the two locators are compared on a set of random points, uniformly
+ * distributed inside the `calorimeter` with isotropic directions, out of which a
+ * given fraction is placed exactly on one of the `absorber`/`gap` boundaries, i.e.
+ * on the `surface`:
+ * - points that are not on the `surface`: the located volume, the `layer` and `absorber`
+ *   indices, the local coordinates and the distance must be exactly the same
+ * - points on the `surface`: the `Box` based location is repeated with the small push
+ *   (as in the steppers) while the distance is zero. Then the located volume and indices
+ *   must be the same as given by the (direction aware) table based location (while the
+ *   distance must be the same up to the pushes).
+ */
+
+#include "BenchmarkStats.hh"
+
+#include <vector>
+
+class GeometryBenchmark {
+public:
+
+  /** Runs the benchmark and writes the results to the standard output.
+   *
+   * @param[in]     numPoints       number of random points (with directions) both in the check and the timing
+   * @param[in]     surfaceFraction fraction of the points of the check that are placed on a boundary
+   * @param[in]     numWarmup       number of warm-up (not timed) repetitions of each locator
+   * @param[in]     numRepetitions  number of timed repetitions of each locator
+   * @param[in,out] theResults      the measurements are appended to this
+   */
+  static void Run(int numPoints, double surfaceFraction, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults);
+
+private:
+  GeometryBenchmark() = delete;
+};
+
+#endif // GeometryBenchmark_HH
@@ -0,0 +1,58 @@
+#ifndef HistBenchmark_HH
+#define HistBenchmark_HH
+
+/**
+ * @file    HistBenchmark.hh
+ * @class   HistBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the multi-threaded histogram filling and end of run reduction.
+ *
+ * A given number of threads fill the three per-layer histograms of the `Results`
+ * with random (layer, value) pairs:
+ * - into the cache line aligned, per-thread `Results` replicas (as in the `EventLoop`)
+ *   followed by the parallel tree reduction of the replicas (`ReduceResultsStep()`)
+ * - into a single, shared `Results` protected by a mutex (i.e. the naive alternative)
+ *
+ * The cost per fill (wall time over all fills of all threads, including the
+ * reduction) is reported as the function of the number of threads together with
+ * the time of the reduction and the agreement of the final histograms.
+ *
+ * @note The scaling can only be judged when the number of threads does not exceed
+ * the number of available cores (the number of hardware threads is also reported).
+ *
+ * The cost of a single `Hist::Fill` (with and without weight) is also measured on
+ * its own, in one thread, after warm-up over several repetitions (`RunFill()`).
+ */
+
+#include "BenchmarkStats.hh"
+
+#include <vector>
+
+class HistBenchmark {
+public:
+
+  /** Runs the benchmark and writes the results to the standard output.
+   *
+   * @param[in] numLayers       number of bins of the histograms (layers)
+   * @param[in] numFillsPerThread number of fills done by each thread
+   * @param[in] maxNumThreads   maximum number of threads (1, 2, 4, ... up to this)
+   */
+  static void Run(int numLayers, int numFillsPerThread, int maxNumThreads);
+
+  /** Times the single threaded `Hist::Fill` and writes the results to the standard output.
+   *
+   * @param[in]     numLayers      number of bins of the histogram (layers)
+   * @param[in]     numFills       number of fills in one repetition
+   * @param[in]     numWarmup      number of warm-up (not timed) repetitions
+   * @param[in]     numRepetitions number of timed repetitions
+   * @param[in,out] theResults     the measurements (per fill) are appended to this
+   */
+  static void RunFill(int numLayers, int numFills, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults);
+
+private:
+  HistBenchmark() = delete;
+};
+
+#endif // HistBenchmark_HH
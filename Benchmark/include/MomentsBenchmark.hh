@@ -0,0 +1,40 @@
+#ifndef MomentsBenchmark_HH
+#define MomentsBenchmark_HH
+
+/**
+ * @file    MomentsBenchmark.hh
+ * @class   MomentsBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the cost and precision of the `Moments` (Welford) accumulators of the `Results`.
+ *
+ * Random, per-event values (with a large mean compared to their standard deviation,
+ * i.e. the difficult case) are accumulated:
+ * - by the plain sum and sum of squares (i.e. the previous, naive way) with the
+ *   variance computed as \f$ \langle x^2 \rangle - \langle x \rangle^2 \f$
+ * - by the `Moments` accumulators: in a single one and in several ones (as the
+ *   per-thread replicas or the jobs) that are combined by `Moments::Merge()`
+ *
+ * The cost of the end of event update of the 8 accumulators of the `Results` is
+ * reported per event together with the relative errors of the mean and standard
+ * deviation compared to a two-pass, extended precision reference.
+ */
+
+class MomentsBenchmark {
+public:
+
+  /** Runs the benchmark and writes the results to the standard output.
+   *
+   * @param[in] numEvents number of (per-event) values
+   * @param[in] mean      mean of the values
+   * @param[in] stdDev    standard deviation of the values
+   * @param[in] numParts  number of accumulators the values are split into then merged
+   */
+  static void Run(int numEvents, double mean, double stdDev, int numParts);
+
+private:
+  MomentsBenchmark() = delete;
+};
+
+#endif // MomentsBenchmark_HH
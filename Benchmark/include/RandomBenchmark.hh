@@ -0,0 +1,47 @@
+#ifndef RandomBenchmark_HH
+#define RandomBenchmark_HH
+
+/**
+ * @file    RandomBenchmark.hh
+ * @class   RandomBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the engines of the `URandom` uniform random number generator.
+ *
+ * For both engines (`mt19937_64` and the counter based `Philox4x32-10`) measures,
+ * after warm-up over several repetitions (see `BenchmarkStats`):
+ * - the cost per random number of `URandom::flat()` and of the
+ *   `G4HepEmRandomEngine::flatArray()` (with the small arrays used by the physics
+ *   and with the given larger array size)
+ * - the cost of re-seeding, i.e. starting a new stream (done at each event), and
+ *   taking its first number (i.e. including the first refill of the buffer)
+ *
+ * The size of the state (including the heap allocated part) is also reported and
+ * the Philox implementation is checked against the known answers of the reference
+ * (Random123) implementation.
+ */
+
+#include "BenchmarkStats.hh"
+
+#include <vector>
+
+class RandomBenchmark {
+public:
+
+  /** Runs the benchmark and writes the results to the standard output.
+   *
+   * @param[in]     numRandoms     number of random numbers generated in one repetition
+   * @param[in]     arraySize      size of the larger arrays filled by `flatArray()`
+   * @param[in]     numStreams     number of streams started (i.e. re-seeding) in one repetition of the re-seeding
+   * @param[in]     numWarmup      number of warm-up (not timed) repetitions of each measurement
+   * @param[in]     numRepetitions number of timed repetitions of each measurement
+   * @param[in,out] theResults     the measurements (per random number or stream) are appended to this
+   */
+  static void Run(int numRandoms, int arraySize, int numStreams, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults);
+
+private:
+  RandomBenchmark() = delete;
+};
+
+#endif // RandomBenchmark_HH
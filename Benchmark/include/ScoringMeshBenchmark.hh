@@ -0,0 +1,39 @@
+#ifndef ScoringMeshBenchmark_HH
+#define ScoringMeshBenchmark_HH
+
+/**
+ * @file    ScoringMeshBenchmark.hh
+ * @class   ScoringMeshBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the per-step cost and memory use of the `ScoringMesh`.
+ *
+ * A toy, shower like sequence of energy deposits (exponential longitudinal and
+ * Gaussian transverse profiles over the `calorimeter` of the default geometry)
+ * is scored, event by event, into a 3D voxel mesh:
+ * - by the `ScoringMesh`, i.e. sparse per-event hash flushed into the dense run
+ *   level grid at the end of each event
+ * - by a dense per-event grid (i.e. the naive alternative) that is added to the
+ *   run level grid then cleared at the end of each event
+ *
+ * The per-fill (i.e. per-step) cost of the two, including the end of event work,
+ * are reported together with the memory use and the agreement of the final grids.
+ */
+
+class ScoringMeshBenchmark {
+public:
+
+  /** Runs the benchmark and writes the results to the standard output.
+   *
+   * @param[in] numVoxels       number of voxels along each of the 3 axes
+   * @param[in] numEvents       number of toy events
+   * @param[in] numFillsPerEvent number of energy deposits (steps) per event
+   */
+  static void Run(int numVoxels, int numEvents, int numFillsPerEvent);
+
+private:
+  ScoringMeshBenchmark() = delete;
+};
+
+#endif // ScoringMeshBenchmark_HH
@@ -0,0 +1,107 @@
+#ifndef ThroughputBenchmark_HH
+#define ThroughputBenchmark_HH
+
+/**
+ * @file    ThroughputBenchmark.hh
+ * @class   ThroughputBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief End-to-end throughput of the `HepEmShow` simulation over a matrix of scenarios with regression gates.
+ *
+ * A scenario is one full simulation (`EventLoop::ProcessEvents()`) with a given
+ * primary particle, primary energy, `gap` thickness and number of layers. The
+ * scenario matrix is the product of (see `GetScenarios()`):
+ * - primary particles: e-, e+ and gamma
+ * - primary energies : 1 GeV, 10 GeV, 100 GeV and 1 TeV
+ * - `gap` thickness  : thin (1 mm) and thick (5.7 mm, the default)
+ * - number of layers : 10, 50 (the default) and 1000
+ * (a reduced, quick matrix of 10 GeV primaries with 50 layers is also available).
+ * The number of events of a scenario is inversely proportional to the primary
+ * energy (200 events at 1 GeV, at least one) times a scale factor so all
+ * scenarios need similar time.
+ *
+ * All scenarios are simulated in the same process with the same `G4HepEm` state
+ * (loaded once: its time is the start up time). Each scenario is simulated a few
+ * times without timing (warm-up) then timed repetition by repetition (see
+ * `BenchmarkStats`). For each scenario, the median wall time of the event
+ * processing over the repetitions (with its median absolute deviation), the
+ * events/s, the steps/s (based on the number of \f$\gamma\f$ and \f$e^-/e^+\f$
+ * steps collected in the `Results`), the set up time (geometry, primary generator
+ * and results) and the peak resident set size during the scenario are measured and written into a JSON file. The peak resident
+ * set size of the process is reset to the current one before each scenario (see
+ * `ResetPeakRSS()`) so it's the high-water mark of the given scenario (including
+ * the memory that was already in use before, e.g. the `G4HepEm` state).
+ *
+ * The events/s of each scenario is compared to that in a baseline (a result file
+ * written earlier by the same application) and the scenario is marked as regressed
+ * when it's lower by more than the given relative tolerance. A scenario of the
+ * baseline that was not simulated (e.g. the quick matrix compared to a baseline
+ * of the full one) is marked as missing: the gate fails on both.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+
+struct G4HepEmState;
+
+class ThroughputBenchmark {
+public:
+
+  /** One scenario of the matrix.*/
+  struct Scenario {
+    std::string fParticleName;  ///< name of the primary particle (e-, e+ or gamma)
+    double      fEnergy;        ///< primary kinetic energy in [MeV]
+    double      fGapThick;      ///< thickness of the `gap` in [mm]
+    int         fNumLayers;     ///< number of layers
+    int         fNumEvents;     ///< number of events to simulate
+
+    /** Unique name of the scenario (e.g. `e-_10GeV_gap5.7mm_L50`).*/
+    std::string GetName() const;
+  };
+
+  /** The measured quantities of one scenario.*/
+  struct Measurement {
+    Scenario fScenario;         ///< the scenario
+    double   fSetUpTime;        ///< time to set up the geometry, primary generator and results in [s]
+    double   fWallTime;         ///< median wall time of the event processing over the repetitions in [s]
+    double   fWallTimeMAD;      ///< median absolute deviation of the wall times of the repetitions in [s]
+    int      fNumRepetitions;   ///< number of timed repetitions
+    double   fEventsPerSec;     ///< number of events per second
+    double   fNumSteps;         ///< number of (\f$\gamma\f$ and \f$e^-/e^+\f$) steps
+    double   fStepsPerSec;      ///< number of steps per second
+    long     fPeakRSS;          ///< peak resident set size of the process during the scenario in [kB]
+  };
+
+  /** The scenario matrix (see the description) with the number of events multiplied by `eventScale`.*/
+  static std::vector<Scenario> GetScenarios(bool isQuick, double eventScale);
+
+  /** Simulates the given scenario with the given state by `numThreads` workers (`numWarmup` plus `numRepetitions` times) and gives the measured quantities.*/
+  static Measurement RunScenario(G4HepEmState& theState, const Scenario& theScenario, int numThreads, int numWarmup, int numRepetitions);
+
+  /** Resets the peak resident set size of the process to the current one (false if it cannot be reset).*/
+  static bool ResetPeakRSS();
+
+  /** Peak resident set size of the process (since the last `ResetPeakRSS()`) in [kB].*/
+  static long GetPeakRSS();
+
+  /** Writes the measurements (with the start up time) into the given JSON file (false if cannot be written).*/
+  static bool WriteJSON(const std::string& fileName, double startUpTime, int numThreads, const std::vector<Measurement>& theMeasurements);
+
+  /** Reads the events/s of the scenarios from a JSON file written by `WriteJSON()` (false if cannot be read or has no scenarios).*/
+  static bool ReadBaseline(const std::string& fileName, std::map<std::string, double>& theBaseline);
+
+  /** Prints the measurements compared to the baseline (if any) and gives the number of regressed plus missing scenarios.
+   *
+   * @param[in] theMeasurements the measurements of the scenarios
+   * @param[in] theBaseline     the baseline events/s of the scenarios (scenarios not in the baseline are not compared)
+   * @param[in] tolerance       the allowed relative decrease of the events/s compared to the baseline
+   */
+  static int Compare(const std::vector<Measurement>& theMeasurements, const std::map<std::string, double>& theBaseline, double tolerance);
+
+private:
+  ThroughputBenchmark() = delete;
+};
+
+#endif // ThroughputBenchmark_HH
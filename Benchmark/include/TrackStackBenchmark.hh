@@ -0,0 +1,82 @@
+#ifndef TrackStackBenchmark_HH
+#define TrackStackBenchmark_HH
+
+/**
+ * @file    TrackStackBenchmark.hh
+ * @class   TrackStackBenchmark
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Benchmark of the push/pop throughput and memory use of the `TrackStack`.
+ *
+ * The structure-of-arrays `TrackStack` is compared to the original array-of-structures
+ * version (i.e. a vector of complete `G4HepEmTrack`-s, that is reproduced here as a
+ * reference) under the same track load. The load is generated by a simple, `Heitler`
+ * like toy cascade of a primary with a given energy: each popped track that has
+ * energy above the critical energy splits (at a random fraction of its energy) into
+ * two secondaries that are pushed into the stack at once, while the tracks below the
+ * critical energy are simply absorbed. No geometry or physics is involved so the
+ * stack operations dominate the measured time. A given number of cascades (with the
+ * same random sequence) are timed with both stacks after warm-up over several
+ * repetitions (see `BenchmarkStats`) and the push/pop throughput together with the
+ * peak number of stored tracks and the corresponding memory are reported.
+ *
+ * The single and bulk `Push` (insert) and `PopInto` of a toy track population and
+ * the `PushSecondaries` hand-off copy of small groups of secondaries are also timed
+ * one by one (`RunOperations()`).
+ */
+
+#include "BenchmarkStats.hh"
+
+#include <vector>
+#include <cstddef>
+
+class TrackStackBenchmark {
+public:
+
+  /** The results of one benchmark measurement.*/
+  struct Result {
+    double      fNumOperations;   ///< number of push plus pop operations (summed over the cascades)
+    double      fTimeInSec;       ///< time of all the cascades
+    int         fPeakNumTracks;   ///< maximum number of tracks stored in the stack at the same time
+    std::size_t fPeakMemory;      ///< memory required by the track records at their peak number (in bytes)
+    std::size_t fCapacityMemory;  ///< memory allocated for the track records at the end (in bytes)
+    double      fCheckSum;        ///< sum of the absorbed energies (must be the same for both stacks)
+  };
+
+  /** Runs the benchmark with both stacks for the given primary energy and writes the results to the standard output.
+   *
+   * @param[in]     primaryEnergy  energy of the primary of the toy cascade (in [MeV])
+   * @param[in]     numCascades    number of times the cascade is simulated in one repetition
+   * @param[in]     numWarmup      number of warm-up (not timed) repetitions with each stack
+   * @param[in]     numRepetitions number of timed repetitions with each stack
+   * @param[in,out] theResults     the measurements (per push or pop operation) are appended to this
+   */
+  static void Run(double primaryEnergy, int numCascades, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults);
+
+  /** Times the single and bulk stack operations one by one and writes the results to the standard output.
+   *
+   * @param[in]     numTracks      number of tracks pushed or popped in one repetition
+   * @param[in]     numWarmup      number of warm-up (not timed) repetitions of each operation
+   * @param[in]     numRepetitions number of timed repetitions of each operation
+   * @param[in,out] theResults     the measurements (per track) are appended to this
+   */
+  static void RunOperations(int numTracks, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults);
+
+  /** Simulates the toy cascade the given number of times with the (structure-of-arrays) `TrackStack`.*/
+  static Result RunSoA(double primaryEnergy, int numCascades);
+
+  /** Simulates the toy cascade the given number of times with the reference array-of-structures stack.*/
+  static Result RunAoS(double primaryEnergy, int numCascades);
+
+
+private:
+  TrackStackBenchmark() = delete;
+
+  /** Critical energy of the toy cascade (in [MeV]) below which the tracks are absorbed.*/
+  static constexpr double kCriticalEnergy = 10.0;
+  /** Number of tracks pushed or popped at once by the bulk operations.*/
+  static constexpr int    kBulkSize       = 16;
+};
+
+#endif // TrackStackBenchmark_HH
@@ -0,0 +1,47 @@
+#include "AoSTrackStack.hh"
+
+#include <algorithm>
+
+AoSTrackStack::AoSTrackStack()
+: fSize(16),
+  fCurIndx(-1),
+  fPeakNumTracks(0) {
+  fTrackVect.resize(fSize);
+}
+
+
+int AoSTrackStack::PopInto(G4HepEmTrack& track) {
+  // return -1 if the stack is empty
+  if (fCurIndx<0) {
+    return -1;
+  }
+  Copy(fTrackVect[fCurIndx], track);
+  return fCurIndx--;
+}
+
+
+G4HepEmTrack& AoSTrackStack::Insert() {
+  // make sure that the size if fine
+  ++fCurIndx;
+  if (fCurIndx==fSize) {
+    fSize *= 2;
+    fTrackVect.resize(fSize);
+  }
+  fPeakNumTracks = std::max(fPeakNumTracks, fCurIndx+1);
+  fTrackVect[fCurIndx].ReSet();
+  return fTrackVect[fCurIndx];
+}
+
+
+void AoSTrackStack::Copy(G4HepEmTrack& from, G4HepEmTrack& to) {
+  to.ReSet();
+  to.SetPosition(from.GetPosition());
+  to.SetDirection(from.GetDirection());
+  to.SetEKin(from.GetEKin(), from.GetLogEKin());
+  to.SetCharge(from.GetCharge());
+  to.SetSafety(from.GetSafety());
+  to.SetID(from.GetID());
+  to.SetParentID(from.GetParentID());
+  to.SetMCIndex(from.GetMCIndex());
+  to.SetOnBoundary(from.GetOnBoundary());
+}
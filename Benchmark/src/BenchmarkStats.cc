@@ -0,0 +1,82 @@
+#include "BenchmarkStats.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+
+
+BenchmarkStats::Result BenchmarkStats::Summarise(const std::string& name, long numItems, int numWarmup, const std::vector<double>& theTimes) {
+  Result theResult;
+  theResult.fName           = name;
+  theResult.fNumItems       = numItems;
+  theResult.fNumWarmup      = numWarmup;
+  theResult.fNumRepetitions = static_cast<int>(theTimes.size());
+  theResult.fMedian         = GetMedian(theTimes);
+  std::vector<double> theDeviations(theTimes.size());
+  for (std::size_t i=0; i<theTimes.size(); ++i) {
+    theDeviations[i] = std::abs(theTimes[i] - theResult.fMedian);
+  }
+  theResult.fMAD = GetMedian(theDeviations);
+  theResult.fMin = theTimes.empty() ? 0.0 : *std::min_element(theTimes.begin(), theTimes.end());
+  theResult.fMax = theTimes.empty() ? 0.0 : *std::max_element(theTimes.begin(), theTimes.end());
+  return theResult;
+}
+
+
+double BenchmarkStats::GetMedian(std::vector<double> values) {
+  const std::size_t num = values.size();
+  if (num == 0) {
+    return 0.0;
+  }
+  std::sort(values.begin(), values.end());
+  return num % 2 == 1 ? values[num/2] : 0.5*(values[num/2-1] + values[num/2]);
+}
+
+
+void BenchmarkStats::PrintHeader(const std::string& title) {
+  std::printf(" === %s\n", title.c_str());
+  std::printf("     %-32s %12s %10s %8s %12s %12s %6s\n", "kernel", "median [ns]", "MAD [ns]", "MAD [%]", "min [ns]", "max [ns]", "reps");
+}
+
+
+void BenchmarkStats::Print(const Result& theResult) {
+  const double relMAD = theResult.fMedian > 0.0 ? 100.0*theResult.fMAD/theResult.fMedian : 0.0;
+  std::printf("     %-32s %12.3f %10.3f %8.2f %12.3f %12.3f %6d\n", theResult.fName.c_str(), theResult.fMedian, theResult.fMAD,
+              relMAD, theResult.fMin, theResult.fMax, theResult.fNumRepetitions);
+}
+
+
+bool BenchmarkStats::WriteJSON(const std::string& fileName, const std::string& suite, const std::vector<Result>& theResults) {
+  FILE* f = std::fopen(fileName.c_str(), "w");
+  if (!f) {
+    return false;
+  }
+#if defined(__AVX512F__)
+  const char* isa = "AVX-512";
+#elif defined(__AVX2__)
+  const char* isa = "AVX2";
+#else
+  const char* isa = "scalar";
+#endif
+#if defined(__VERSION__)
+  const char* compiler = __VERSION__;
+#else
+  const char* compiler = "unknown";
+#endif
+  std::fprintf(f, "{\n");
+  std::fprintf(f, "  \"suite\": \"%s\",\n", suite.c_str());
+  std::fprintf(f, "  \"compiler\": \"%s\",\n", compiler);
+  std::fprintf(f, "  \"isa\": \"%s\",\n", isa);
+  std::fprintf(f, "  \"timestamp\": %lld,\n", static_cast<long long>(std::time(nullptr)));
+  std::fprintf(f, "  \"unit\": \"ns/item\",\n");
+  std::fprintf(f, "  \"results\": [\n");
+  for (std::size_t i=0; i<theResults.size(); ++i) {
+    const Result& r = theResults[i];
+    std::fprintf(f, "    {\"name\": \"%s\", \"items\": %ld, \"warmup\": %d, \"repetitions\": %d, \"median\": %.6g, \"mad\": %.6g, \"min\": %.6g, \"max\": %.6g}%s\n",
+                 r.fName.c_str(), r.fNumItems, r.fNumWarmup, r.fNumRepetitions, r.fMedian, r.fMAD, r.fMin, r.fMax, i+1 < theResults.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+  std::fclose(f);
+  return true;
+}
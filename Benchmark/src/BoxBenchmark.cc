@@ -0,0 +1,110 @@
+#include "BoxBenchmark.hh"
+
+#include "BenchmarkStats.hh"
+
+#include "Box.hh"
+
+#include <vector>
+#include <random>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+
+void BoxBenchmark::Run(int numPoints, double edgeFraction, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults) {
+  // the absorber box of the default geometry
+  const Box theBox("Abs", 1, 1.15, 200.0, 200.0);
+  const double halfLength[3] = {theBox.GetHalfLength(0), theBox.GetHalfLength(1), theBox.GetHalfLength(2)};
+  const double delta = theBox.GetHalfTolerance();
+  // the offsets from the boundary in case of the tolerance edge cases
+  const double edgeOffsets[] = {0.0, delta, -delta, 0.999*delta, -0.999*delta, 1.001*delta, -1.001*delta, 2.0*delta, -2.0*delta};
+  const int    numOffsets    = sizeof(edgeOffsets)/sizeof(double);
+  // generate the random points (SoA)
+  std::mt19937_64 rng(1234);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::vector<double> rx(numPoints), ry(numPoints), rz(numPoints);
+  std::vector<double> vx(numPoints), vy(numPoints), vz(numPoints);
+  for (int i=0; i<numPoints; ++i) {
+    double r[3], v[3];
+    for (int j=0; j<3; ++j) {
+      r[j] = halfLength[j]*(2.0*uni(rng)-1.0);
+    }
+    const double cost = 2.0*uni(rng)-1.0;
+    const double sint = std::sqrt((1.0-cost)*(1.0+cost));
+    const double phi  = 2.0*M_PI*uni(rng);
+    v[0] = cost;
+    v[1] = sint*std::cos(phi);
+    v[2] = sint*std::sin(phi);
+    if (uni(rng) < edgeFraction) {
+      // on (or around) the surface of one of the boundaries
+      const int    axis   = static_cast<int>(3.0*uni(rng));
+      const double side   = uni(rng) < 0.5 ? -1.0 : 1.0;
+      const int    offset = static_cast<int>(numOffsets*uni(rng));
+      r[axis] = side*(halfLength[axis] + edgeOffsets[offset]);
+      // zero direction components (with both signs)
+      const double what = uni(rng);
+      if (what < 0.2) {
+        v[axis] = 0.0;
+      } else if (what < 0.4) {
+        v[axis] = -0.0;
+      } else if (what < 0.5) {
+        v[(axis+1)%3] = 0.0;
+        v[(axis+2)%3] = -0.0;
+      }
+    }
+    rx[i] = r[0]; ry[i] = r[1]; rz[i] = r[2];
+    vx[i] = v[0]; vy[i] = v[1]; vz[i] = v[2];
+  }
+  // compute with the single point and batch methods (the results of the last repetitions are compared)
+  std::vector<double> distScalar(numPoints), distBatch(numPoints);
+  std::vector<double> safeScalar(numPoints), safeBatch(numPoints);
+  const BenchmarkStats::Result resDistScalar = BenchmarkStats::Measure("Box::DistanceToOut(r,v)", numPoints, numWarmup, numRepetitions, [&]() {
+    for (int i=0; i<numPoints; ++i) {
+      double r[3] = {rx[i], ry[i], rz[i]};
+      double v[3] = {vx[i], vy[i], vz[i]};
+      distScalar[i] = theBox.DistanceToOut(r, v);
+    }
+    BenchmarkStats::DoNotOptimize(distScalar[numPoints-1]);
+  });
+  const BenchmarkStats::Result resDistBatch = BenchmarkStats::Measure("Box::DistanceToOut(r,v) batch", numPoints, numWarmup, numRepetitions, [&]() {
+    theBox.DistanceToOut(rx.data(), ry.data(), rz.data(), vx.data(), vy.data(), vz.data(), distBatch.data(), numPoints);
+    BenchmarkStats::DoNotOptimize(distBatch[numPoints-1]);
+  });
+  const BenchmarkStats::Result resSafeScalar = BenchmarkStats::Measure("Box::DistanceToOut(r)", numPoints, numWarmup, numRepetitions, [&]() {
+    for (int i=0; i<numPoints; ++i) {
+      double r[3] = {rx[i], ry[i], rz[i]};
+      safeScalar[i] = theBox.DistanceToOut(r);
+    }
+    BenchmarkStats::DoNotOptimize(safeScalar[numPoints-1]);
+  });
+  const BenchmarkStats::Result resSafeBatch = BenchmarkStats::Measure("Box::DistanceToOut(r) batch", numPoints, numWarmup, numRepetitions, [&]() {
+    theBox.DistanceToOut(rx.data(), ry.data(), rz.data(), safeBatch.data(), numPoints);
+    BenchmarkStats::DoNotOptimize(safeBatch[numPoints-1]);
+  });
+  // bit-by-bit comparison
+  int numDistMismatch = 0;
+  int numSafeMismatch = 0;
+  int numZeroDist     = 0;
+  for (int i=0; i<numPoints; ++i) {
+    numDistMismatch += std::memcmp(&distScalar[i], &distBatch[i], sizeof(double)) != 0 ? 1 : 0;
+    numSafeMismatch += std::memcmp(&safeScalar[i], &safeBatch[i], sizeof(double)) != 0 ? 1 : 0;
+    numZeroDist     += distScalar[i] == 0.0 ? 1 : 0;
+  }
+#if defined(__AVX512F__)
+  const char* isa = "AVX-512";
+#elif defined(__AVX2__)
+  const char* isa = "AVX2";
+#else
+  const char* isa = "scalar";
+#endif
+  BenchmarkStats::PrintHeader("Box: DistanceToOut of " + std::to_string(numPoints) + " random points ("
+                              + std::to_string(static_cast<int>(100.0*edgeFraction+0.5)) + "% tolerance edge cases, batch: " + isa + ")");
+  for (const BenchmarkStats::Result* theResult : { &resDistScalar, &resDistBatch, &resSafeScalar, &resSafeBatch }) {
+    BenchmarkStats::Print(*theResult);
+    theResults.push_back(*theResult);
+  }
+  std::printf("     %-24s %10s %10s\n", "method", "speedup", "mismatch");
+  std::printf("     %-24s %10.2f %10d\n", "distance to out", resDistScalar.fMedian/resDistBatch.fMedian, numDistMismatch);
+  std::printf("     %-24s %10.2f %10d\n", "safety", resSafeScalar.fMedian/resSafeBatch.fMedian, numSafeMismatch);
+  std::printf("     (%d points with zero distance to out)\n", numZeroDist);
+}
@@ -0,0 +1,78 @@
+#include "ExactSumBenchmark.hh"
+
+#include "Hist.hh"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+// fills all the (layer, value) pairs into the histogram and gives the time in [s]
+double FillAll(Hist& theHist, const std::vector<double>& theData) {
+  const std::size_t numFills = theData.size()/2;
+  auto t0 = std::chrono::steady_clock::now();
+  for (std::size_t i=0; i<numFills; ++i) {
+    theHist.Fill(theData[2*i], theData[2*i+1]);
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+}
+
+// number of bins that differ in any bit
+int NumDifferentBins(const Hist& h1, const Hist& h2) {
+  int num = 0;
+  for (int ib=0; ib<h1.GetNumBins(); ++ib) {
+    num += std::memcmp(&h1.GetY()[ib], &h2.GetY()[ib], sizeof(double)) != 0 ? 1 : 0;
+  }
+  return num;
+}
+
+} // namespace
+
+
+void ExactSumBenchmark::Run(int numLayers, int numFills, int numParts) {
+  std::printf(" === ExactSum: %d fills of a per-layer histogram (%d bins), shuffled and merged from %d parts\n", numFills, numLayers, numParts);
+  // the random (layer, value) pairs: log-uniform values between 1 keV and 10 MeV
+  std::mt19937_64 rng(1234);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::vector<double> theData(2*numFills);
+  for (int i=0; i<numFills; ++i) {
+    theData[2*i]   = numLayers*uni(rng);
+    theData[2*i+1] = 1.0E-3*std::pow(1.0E+4, uni(rng));
+  }
+  // the same pairs in a shuffled order
+  std::vector<int> theOrder(numFills);
+  for (int i=0; i<numFills; ++i) {
+    theOrder[i] = i;
+  }
+  std::shuffle(theOrder.begin(), theOrder.end(), rng);
+  std::vector<std::vector<double> > theShuffledParts(numParts);
+  for (int i=0; i<numFills; ++i) {
+    const int ip = static_cast<int>(static_cast<long>(i)*numParts/numFills);
+    theShuffledParts[ip].push_back(theData[2*theOrder[i]]);
+    theShuffledParts[ip].push_back(theData[2*theOrder[i]+1]);
+  }
+  std::printf("     %-10s %14s %16s\n", "mode", "[ns/fill]", "different bins");
+  for (bool isExact : { false, true }) {
+    // single histogram in the original order
+    Hist theSingle("", 0, numLayers, numLayers);
+    theSingle.SetExact(isExact);
+    const double theTime = FillAll(theSingle, theData);
+    theSingle.Scale(1.0);
+    // the shuffled parts merged
+    Hist theMerged("", 0, numLayers, numLayers);
+    theMerged.SetExact(isExact);
+    for (const std::vector<double>& thePart : theShuffledParts) {
+      Hist theReplica("", 0, numLayers, numLayers);
+      theReplica.SetExact(isExact);
+      FillAll(theReplica, thePart);
+      theMerged.Add(&theReplica);
+    }
+    theMerged.Scale(1.0);
+    std::printf("     %-10s %14.3f %16d\n", isExact ? "exact" : "double", 1.0E+9*theTime/numFills, NumDifferentBins(theSingle, theMerged));
+  }
+}
@@ -0,0 +1,191 @@
+#include "GeometryBenchmark.hh"
+
+#include "Geometry.hh"
+#include "NavigationState.hh"
+#include "Box.hh"
+
+#include <vector>
+#include <random>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// a point with direction as used in the location
+struct Point {
+  double fPos[3];
+  double fDir[3];
+  bool   fOnSurface;
+};
+
+// the result of one location
+struct Location {
+  double fLocalPos[3];
+  double fDistance;
+  Box*   fVolume;
+  int    fIndxLayer;
+  int    fIndxAbs;
+  int    fNumPush;
+};
+
+Location Locate(Geometry& theGeometry, const Point& p, bool byTable, bool doPush) {
+  Location loc;
+  double r[3] = {p.fPos[0], p.fPos[1], p.fPos[2]};
+  double v[3] = {p.fDir[0], p.fDir[1], p.fDir[2]};
+  loc.fNumPush = 0;
+  while (true) {
+    double rLocal[3] = {r[0], r[1], r[2]};
+    loc.fDistance = byTable
+                    ? theGeometry.CalculateDistanceToOutByTable(rLocal, v, &loc.fVolume, &loc.fIndxLayer, &loc.fIndxAbs)
+                    : theGeometry.CalculateDistanceToOutByBoxes(rLocal, v, &loc.fVolume, &loc.fIndxLayer, &loc.fIndxAbs);
+    loc.fLocalPos[0] = rLocal[0];
+    loc.fLocalPos[1] = rLocal[1];
+    loc.fLocalPos[2] = rLocal[2];
+    if (!doPush || loc.fDistance > 0.0 || loc.fNumPush == 10) {
+      break;
+    }
+    // the same small push as in the steppers
+    r[0] += 1.0E-6*v[0];
+    r[1] += 1.0E-6*v[1];
+    r[2] += 1.0E-6*v[2];
+    ++loc.fNumPush;
+  }
+  return loc;
+}
+
+// shower-like point cloud in the calorimeter of the geometry (see the description)
+std::vector<Point> ShowerPoints(const Geometry& theGeometry, int num, std::mt19937_64& rng) {
+  const int    numLayers  = theGeometry.GetNumLayers();
+  const double layerThick = theGeometry.GetAbsThick() + theGeometry.GetGapThick();
+  const double caloStartX = theGeometry.GetCaloStartXposition();
+  const double caloThick  = numLayers*layerThick;
+  const double halfCaloYZ = 0.5*theGeometry.GetCaloSizeYZ();
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  // shower maximum at about one fifth of the calorimeter depth, transverse scale of 20 mm
+  std::gamma_distribution<double>       depth(3.0, 0.1*caloThick);
+  std::exponential_distribution<double> radius(1.0/20.0);
+  std::exponential_distribution<double> angle(10.0);
+  std::vector<Point> thePoints(num);
+  for (Point& p : thePoints) {
+    double x = 0.0;
+    do {
+      x = depth(rng);
+    } while (x >= caloThick);
+    p.fOnSurface = uni(rng) < 0.1;
+    if (p.fOnSurface) {
+      // on the absorber/gap or layer boundary
+      const int iLayer = std::min(numLayers-1, static_cast<int>(x/layerThick));
+      x = iLayer*layerThick + (uni(rng) < 0.5 ? 0.0 : theGeometry.GetAbsThick());
+    }
+    double rho = 0.0;
+    do {
+      rho = radius(rng);
+    } while (rho >= halfCaloYZ);
+    const double phi = 2.0*M_PI*uni(rng);
+    // isotropic for some (low energy) and mostly forward for the others
+    const double cost = uni(rng) < 0.3 ? 2.0*uni(rng)-1.0 : std::max(-1.0, 1.0 - angle(rng));
+    const double sint = std::sqrt((1.0-cost)*(1.0+cost));
+    const double psi  = 2.0*M_PI*uni(rng);
+    p.fPos[0] = caloStartX + x;
+    p.fPos[1] = rho*std::cos(phi);
+    p.fPos[2] = rho*std::sin(phi);
+    p.fDir[0] = cost;
+    p.fDir[1] = sint*std::cos(psi);
+    p.fDir[2] = sint*std::sin(psi);
+  }
+  return thePoints;
+}
+
+} // namespace
+
+
+void GeometryBenchmark::Run(int numPoints, double surfaceFraction, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults) {
+  // the default geometry
+  Geometry theGeometry;
+  const int    numLayers  = theGeometry.GetNumLayers();
+  const double layerThick = theGeometry.GetAbsThick() + theGeometry.GetGapThick();
+  const double caloStartX = theGeometry.GetCaloStartXposition();
+  const double halfCaloYZ = 0.5*theGeometry.GetCaloSizeYZ();
+  // generate the random points (with directions) inside the calorimeter
+  std::mt19937_64 rng(1234);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::vector<Point> thePoints(numPoints);
+  for (Point& p : thePoints) {
+    p.fOnSurface = uni(rng) < surfaceFraction;
+    if (p.fOnSurface) {
+      // on one of the absorber/gap boundaries inside the calorimeter
+      const int iLayer = 1 + static_cast<int>(uni(rng)*(numLayers-1));
+      p.fPos[0] = caloStartX + iLayer*layerThick + (uni(rng) < 0.5 ? 0.0 : theGeometry.GetAbsThick());
+    } else {
+      p.fPos[0] = caloStartX + uni(rng)*numLayers*layerThick;
+    }
+    p.fPos[1] = halfCaloYZ*(2.0*uni(rng)-1.0);
+    p.fPos[2] = halfCaloYZ*(2.0*uni(rng)-1.0);
+    const double cost = 2.0*uni(rng)-1.0;
+    const double sint = std::sqrt((1.0-cost)*(1.0+cost));
+    const double phi  = 2.0*M_PI*uni(rng);
+    p.fDir[0] = cost;
+    p.fDir[1] = sint*std::cos(phi);
+    p.fDir[2] = sint*std::sin(phi);
+  }
+  // compare the results of the two locations
+  int numInside   = 0;
+  int numSurface  = 0;
+  int numMismatch = 0;
+  int numPushed   = 0;
+  for (const Point& p : thePoints) {
+    const Location locTable = Locate(theGeometry, p, true, false);
+    const Location locBoxes = Locate(theGeometry, p, false, p.fOnSurface);
+    bool isSame = locTable.fVolume == locBoxes.fVolume && locTable.fIndxLayer == locBoxes.fIndxLayer && locTable.fIndxAbs == locBoxes.fIndxAbs;
+    if (p.fOnSurface) {
+      ++numSurface;
+      numPushed += locBoxes.fNumPush > 0 ? 1 : 0;
+      isSame = isSame && std::abs(locBoxes.fDistance + 1.0E-6*locBoxes.fNumPush - locTable.fDistance) < 1.0E-9;
+    } else {
+      ++numInside;
+      isSame = isSame && locTable.fDistance == locBoxes.fDistance && locTable.fLocalPos[0] == locBoxes.fLocalPos[0]
+                      && locTable.fLocalPos[1] == locBoxes.fLocalPos[1] && locTable.fLocalPos[2] == locBoxes.fLocalPos[2];
+    }
+    numMismatch += isSame ? 0 : 1;
+  }
+  // measure the per-call time of the locators over the shower-like point cloud
+  const std::vector<Point> theShowerPoints = ShowerPoints(theGeometry, numPoints, rng);
+  const std::string nameBoxes = "Geometry::DistanceToOut boxes";
+  const std::string nameTable = "Geometry::DistanceToOut table";
+  BenchmarkStats::PrintHeader("Geometry: location and distance to out of " + std::to_string(numPoints) + " shower-like points");
+  for (bool byTable : { false, true }) {
+    theResults.push_back(BenchmarkStats::Measure(byTable ? nameTable : nameBoxes, numPoints, numWarmup, numRepetitions, [&]() {
+      Box*   volume;
+      int    indxLayer;
+      int    indxAbs;
+      double sum = 0.0;
+      for (const Point& p : theShowerPoints) {
+        double r[3] = {p.fPos[0], p.fPos[1], p.fPos[2]};
+        double v[3] = {p.fDir[0], p.fDir[1], p.fDir[2]};
+        sum += byTable
+               ? theGeometry.CalculateDistanceToOutByTable(r, v, &volume, &indxLayer, &indxAbs)
+               : theGeometry.CalculateDistanceToOutByBoxes(r, v, &volume, &indxLayer, &indxAbs);
+      }
+      BenchmarkStats::DoNotOptimize(sum);
+    }));
+    BenchmarkStats::Print(theResults.back());
+  }
+  const double tBoxes = theResults[theResults.size()-2].fMedian;
+  const double tTable = theResults.back().fMedian;
+  // the (not located) navigation state based one, i.e. a full `Box` based location and the state update
+  theGeometry.SetUseBoundaryTable(false);
+  theResults.push_back(BenchmarkStats::Measure("Geometry::DistanceToOut navstate", numPoints, numWarmup, numRepetitions, [&]() {
+    double sum = 0.0;
+    for (const Point& p : theShowerPoints) {
+      NavigationState theNavState;
+      double v[3] = {p.fDir[0], p.fDir[1], p.fDir[2]};
+      sum += theGeometry.CalculateDistanceToOut(p.fPos, v, theNavState);
+    }
+    BenchmarkStats::DoNotOptimize(sum);
+  }));
+  BenchmarkStats::Print(theResults.back());
+  std::printf("     speedup (table/Box) = %.2f   check: %d uniform points inside, %d on boundary (%.0f%%, %d required push with Box based) - %d mismatch\n",
+              tBoxes/tTable, numInside, numSurface, 100.0*surfaceFraction, numPushed, numMismatch);
+}
@@ -0,0 +1,169 @@
+#include "HistBenchmark.hh"
+
+#include "BenchmarkStats.hh"
+
+#include "Results.hh"
+#include "Hist.hh"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+namespace {
+
+// fills the three per-layer histograms (as in `SteppingLoop::SteppingAction`)
+void FillOne(Results& theResult, double layer, double val) {
+  theResult.fEdepPerLayer.Fill(layer, val);
+  theResult.fGammaTrackLenghtPerLayer.Fill(layer, val);
+  theResult.fElPosTrackLenghtPerLayer.Fill(layer, val);
+}
+
+// a simple spinning barrier (only used to start and synchronise the threads of the benchmark)
+class SpinBarrier {
+public:
+  SpinBarrier(int numThreads) : fNumThreads(numThreads), fNumArrived(0), fGeneration(0) {}
+  void Wait() {
+    const int generation = fGeneration.load();
+    if (fNumArrived.fetch_add(1) + 1 == fNumThreads) {
+      fNumArrived.store(0);
+      fGeneration.fetch_add(1);
+    } else {
+      while (fGeneration.load() == generation) {
+        std::this_thread::yield();
+      }
+    }
+  }
+private:
+  int              fNumThreads;
+  std::atomic<int> fNumArrived;
+  std::atomic<int> fGeneration;
+};
+
+} // namespace
+
+
+void HistBenchmark::Run(int numLayers, int numFillsPerThread, int maxNumThreads) {
+  Results theTemplate;
+  theTemplate.fEdepPerLayer.ReSet("", 0, numLayers, numLayers);
+  theTemplate.fGammaTrackLenghtPerLayer.ReSet("", 0, numLayers, numLayers);
+  theTemplate.fElPosTrackLenghtPerLayer.ReSet("", 0, numLayers, numLayers);
+  std::printf(" === Hist: %d fills per thread of the 3 per-layer histograms (%d bins), %u hardware threads\n",
+              numFillsPerThread, numLayers, std::thread::hardware_concurrency());
+  std::printf("     %-8s %18s %18s %16s %10s\n", "threads", "replicas [ns/fill]", "shared [ns/fill]", "reduction [us]", "mismatch");
+  for (int numThreads=1; numThreads<=maxNumThreads; numThreads*=2) {
+    // the per-thread random (layer, value) pairs
+    std::vector<std::vector<double> > theData(numThreads);
+    for (int it=0; it<numThreads; ++it) {
+      std::mt19937_64 rng(1234 + it);
+      std::uniform_real_distribution<double> uni(0.0, 1.0);
+      theData[it].resize(2*numFillsPerThread);
+      for (int i=0; i<numFillsPerThread; ++i) {
+        theData[it][2*i]   = numLayers*uni(rng);
+        theData[it][2*i+1] = uni(rng);
+      }
+    }
+    // 1. per-thread replicas with the parallel tree reduction
+    std::vector<Results>  theReplicaStore(numThreads, theTemplate);
+    std::vector<Results*> theReplicas(numThreads);
+    for (int it=0; it<numThreads; ++it) {
+      theReplicas[it] = &theReplicaStore[it];
+    }
+    SpinBarrier theBarrier(numThreads);
+    double tReduction = 0.0;
+    auto theReplicaTask = [&](int it) {
+      theBarrier.Wait();
+      const std::vector<double>& data = theData[it];
+      for (int i=0; i<numFillsPerThread; ++i) {
+        FillOne(*theReplicas[it], data[2*i], data[2*i+1]);
+      }
+      const auto t0 = std::chrono::steady_clock::now();
+      for (int stride=1; stride<numThreads; stride*=2) {
+        theBarrier.Wait();
+        ReduceResultsStep(theReplicas, it, stride);
+      }
+      if (it == 0) {
+        tReduction = 1.0E+6*std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+      }
+    };
+    auto t0 = std::chrono::steady_clock::now();
+    {
+      std::vector<std::thread> theThreads;
+      for (int it=1; it<numThreads; ++it) {
+        theThreads.emplace_back(theReplicaTask, it);
+      }
+      theReplicaTask(0);
+      for (auto& theThread : theThreads) {
+        theThread.join();
+      }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    // 2. a single shared `Results` protected by a mutex
+    Results    theShared(theTemplate);
+    std::mutex theMutex;
+    SpinBarrier theStartBarrier(numThreads);
+    auto theSharedTask = [&](int it) {
+      theStartBarrier.Wait();
+      const std::vector<double>& data = theData[it];
+      for (int i=0; i<numFillsPerThread; ++i) {
+        std::lock_guard<std::mutex> lock(theMutex);
+        FillOne(theShared, data[2*i], data[2*i+1]);
+      }
+    };
+    auto t2 = std::chrono::steady_clock::now();
+    {
+      std::vector<std::thread> theThreads;
+      for (int it=1; it<numThreads; ++it) {
+        theThreads.emplace_back(theSharedTask, it);
+      }
+      theSharedTask(0);
+      for (auto& theThread : theThreads) {
+        theThread.join();
+      }
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    // compare the final histograms (the order of the additions is different)
+    int numMismatch = 0;
+    const auto& yReplica = theReplicas[0]->fEdepPerLayer.GetY();
+    const auto& yShared  = theShared.fEdepPerLayer.GetY();
+    for (int ib=0; ib<numLayers; ++ib) {
+      numMismatch += std::abs(yReplica[ib] - yShared[ib]) > 1.0E-9*std::abs(yShared[ib]) ? 1 : 0;
+    }
+    const double norm = 1.0E+9/(static_cast<double>(numThreads)*numFillsPerThread);
+    std::printf("     %-8d %18.2f %18.2f %16.1f %10d\n", numThreads,
+                norm*std::chrono::duration<double>(t1-t0).count(), norm*std::chrono::duration<double>(t3-t2).count(),
+                tReduction, numMismatch);
+  }
+}
+
+
+void HistBenchmark::RunFill(int numLayers, int numFills, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults) {
+  Hist theHist("hist_Bench", 0, numLayers, numLayers);
+  std::mt19937_64 rng(1234);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  std::vector<double> theValues(numFills), theWeights(numFills);
+  for (int i=0; i<numFills; ++i) {
+    theValues[i]  = numLayers*uni(rng);
+    theWeights[i] = uni(rng);
+  }
+  BenchmarkStats::PrintHeader("Hist: " + std::to_string(numFills) + " fills of a " + std::to_string(numLayers) + " bin histogram per repetition");
+  theResults.push_back(BenchmarkStats::Measure("Hist::Fill(x)", numFills, numWarmup, numRepetitions, [&]() {
+    for (int i=0; i<numFills; ++i) {
+      theHist.Fill(theValues[i]);
+    }
+  }));
+  BenchmarkStats::Print(theResults.back());
+  theResults.push_back(BenchmarkStats::Measure("Hist::Fill(x,w)", numFills, numWarmup, numRepetitions, [&]() {
+    for (int i=0; i<numFills; ++i) {
+      theHist.Fill(theValues[i], theWeights[i]);
+    }
+  }));
+  BenchmarkStats::Print(theResults.back());
+  BenchmarkStats::DoNotOptimize(theHist.GetSum());
+}
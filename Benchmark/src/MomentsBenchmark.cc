@@ -0,0 +1,88 @@
+#include "MomentsBenchmark.hh"
+
+#include "Moments.hh"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// the number of per-event quantities accumulated in the `Results`
+const int kNumQuantities = 8;
+
+// the previous, naive sum and sum of squares accumulator
+struct NaiveMoments {
+  double fSum  { 0.0 };
+  double fSum2 { 0.0 };
+  void Add(double x) { fSum += x; fSum2 += x*x; }
+};
+
+double RelError(double val, double ref) {
+  return ref != 0.0 ? std::abs(val - ref)/std::abs(ref) : std::abs(val);
+}
+
+} // namespace
+
+
+void MomentsBenchmark::Run(int numEvents, double mean, double stdDev, int numParts) {
+  std::printf(" === Moments: %d events with mean = %g and std-dev = %g (merged from %d parts)\n", numEvents, mean, stdDev, numParts);
+  // the per-event values
+  std::vector<double> theData(numEvents);
+  std::mt19937_64 rng(1234);
+  std::normal_distribution<double> gauss(mean, stdDev);
+  for (double& val : theData) {
+    val = gauss(rng);
+  }
+  // the two-pass, extended precision reference
+  long double sum = 0.0L;
+  for (double val : theData) {
+    sum += val;
+  }
+  const long double refMean = sum/numEvents;
+  long double sumDev2 = 0.0L;
+  for (double val : theData) {
+    const long double dev = val - refMean;
+    sumDev2 += dev*dev;
+  }
+  const double refStdDev = static_cast<double>(std::sqrt(sumDev2/numEvents));
+  // 1. the end of event cost of the 8 accumulators (each gets the same value: only the cost matters here)
+  NaiveMoments theNaive[kNumQuantities];
+  Moments      theMoments[kNumQuantities];
+  auto t0 = std::chrono::steady_clock::now();
+  for (double val : theData) {
+    for (int iq=0; iq<kNumQuantities; ++iq) {
+      theNaive[iq].Add(val);
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (double val : theData) {
+    for (int iq=0; iq<kNumQuantities; ++iq) {
+      theMoments[iq].Add(val);
+    }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  // 2. the same with splitting the values into parts and merging them (as the threads or jobs)
+  std::vector<Moments> theParts(numParts);
+  for (int i=0; i<numEvents; ++i) {
+    theParts[static_cast<long>(i)*numParts/numEvents].Add(theData[i]);
+  }
+  Moments theMerged;
+  for (const Moments& part : theParts) {
+    theMerged.Merge(part);
+  }
+  // the naive mean and std-dev
+  const double norm        = 1.0/numEvents;
+  const double naiveMean   = theNaive[0].fSum*norm;
+  const double naiveStdDev = std::sqrt(std::abs(theNaive[0].fSum2*norm - naiveMean*naiveMean));
+  const double normT       = 1.0E+9/numEvents;
+  std::printf("     %-16s %14s %16s %18s\n", "accumulator", "[ns/event]", "rel. err. mean", "rel. err. std-dev");
+  std::printf("     %-16s %14.3f %16.3e %18.3e\n", "sum/sum2", normT*std::chrono::duration<double>(t1-t0).count(),
+              RelError(naiveMean, static_cast<double>(refMean)), RelError(naiveStdDev, refStdDev));
+  std::printf("     %-16s %14.3f %16.3e %18.3e\n", "Welford", normT*std::chrono::duration<double>(t2-t1).count(),
+              RelError(theMoments[0].GetMean(), static_cast<double>(refMean)), RelError(theMoments[0].GetStdDev(), refStdDev));
+  std::printf("     %-16s %14s %16.3e %18.3e\n", "Welford merged", "-",
+              RelError(theMerged.GetMean(), static_cast<double>(refMean)), RelError(theMerged.GetStdDev(), refStdDev));
+}
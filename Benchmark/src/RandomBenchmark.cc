@@ -0,0 +1,84 @@
+#include "RandomBenchmark.hh"
+
+#include "URandom.hh"
+
+#include "G4HepEmRandomEngine.hh"
+
+#include <vector>
+#include <random>
+#include <string>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+
+namespace {
+
+// the known answers of the reference Philox4x32-10 implementation (Random123 kat_vectors)
+bool CheckPhiloxKnownAnswers() {
+  const std::uint32_t ctr[3][4] = { { 0x00000000U, 0x00000000U, 0x00000000U, 0x00000000U },
+                                    { 0xffffffffU, 0xffffffffU, 0xffffffffU, 0xffffffffU },
+                                    { 0x243f6a88U, 0x85a308d3U, 0x13198a2eU, 0x03707344U } };
+  const std::uint32_t key[3][2] = { { 0x00000000U, 0x00000000U },
+                                    { 0xffffffffU, 0xffffffffU },
+                                    { 0xa4093822U, 0x299f31d0U } };
+  const std::uint32_t ref[3][4] = { { 0x6627e8d5U, 0xe169c58dU, 0xbc57ac4cU, 0x9b00dbd8U },
+                                    { 0x408f276dU, 0x41c83b0eU, 0xa20bc7c6U, 0x6d5451fdU },
+                                    { 0xd16cfe09U, 0x94fdccebU, 0x5001e420U, 0x24126ea1U } };
+  bool isOK = true;
+  for (int i=0; i<3; ++i) {
+    std::uint32_t out[4];
+    URandom::Philox4x32(ctr[i], key[i], out);
+    for (int j=0; j<4; ++j) {
+      isOK = isOK && out[j] == ref[i][j];
+    }
+  }
+  return isOK;
+}
+
+} // namespace
+
+
+void RandomBenchmark::Run(int numRandoms, int arraySize, int numStreams, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults) {
+  BenchmarkStats::PrintHeader("URandom: " + std::to_string(numRandoms) + " random numbers and " + std::to_string(numStreams) + " streams per repetition");
+  std::vector<double> theArray(arraySize);
+  std::size_t theStateSize[2];
+  for (URandom::EngineType theType : { URandom::EngineType::kMersenneTwister, URandom::EngineType::kPhilox }) {
+    const bool        isMT   = theType == URandom::EngineType::kMersenneTwister;
+    const std::string engine = isMT ? " mt19937" : " philox";
+    URandom theURnd(1234, theType);
+    theURnd.SetSeed(1234, 1);
+    G4HepEmRandomEngine theRandomEngine(&theURnd);
+    theResults.push_back(BenchmarkStats::Measure("URandom::flat" + engine, numRandoms, numWarmup, numRepetitions, [&]() {
+      double sum = 0.0;
+      for (int i=0; i<numRandoms; ++i) {
+        sum += theURnd.flat();
+      }
+      BenchmarkStats::DoNotOptimize(sum);
+    }));
+    BenchmarkStats::Print(theResults.back());
+    // the small arrays used by the physics and the larger ones
+    for (int theSize : { 4, arraySize }) {
+      const int numArrays = std::max(1, numRandoms/theSize);
+      theResults.push_back(BenchmarkStats::Measure("flatArray(" + std::to_string(theSize) + ")" + engine, static_cast<long>(numArrays)*theSize, numWarmup, numRepetitions, [&]() {
+        for (int i=0; i<numArrays; ++i) {
+          theRandomEngine.flatArray(theSize, theArray.data());
+          BenchmarkStats::DoNotOptimize(theArray[0]);
+        }
+      }));
+      BenchmarkStats::Print(theResults.back());
+    }
+    // starting a new stream and taking its first number
+    theResults.push_back(BenchmarkStats::Measure("URandom::SetSeed" + engine, numStreams, numWarmup, numRepetitions, [&]() {
+      double sum = 0.0;
+      for (int i=0; i<numStreams; ++i) {
+        theURnd.SetSeed(1234, i);
+        sum += theURnd.flat();
+      }
+      BenchmarkStats::DoNotOptimize(sum);
+    }));
+    BenchmarkStats::Print(theResults.back());
+    theStateSize[isMT ? 0 : 1] = sizeof(URandom) + (isMT ? sizeof(std::mt19937_64) : 0);
+  }
+  std::printf("     state [B]: mt19937_64 %zu   Philox4x32-10 %zu   Philox4x32-10 known answers: %s\n",
+              theStateSize[0], theStateSize[1], CheckPhiloxKnownAnswers() ? "OK" : "FAILED");
+}
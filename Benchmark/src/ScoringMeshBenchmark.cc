@@ -0,0 +1,90 @@
+#include "ScoringMeshBenchmark.hh"
+
+#include "ScoringMesh.hh"
+#include "Geometry.hh"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+void ScoringMeshBenchmark::Run(int numVoxels, int numEvents, int numFillsPerEvent) {
+  // the mesh over the calorimeter of the default geometry
+  Geometry theGeometry;
+  const double caloStartX = theGeometry.GetCaloStartXposition();
+  const double halfCaloYZ = 0.5*theGeometry.GetCaloSizeYZ();
+  const int    nv[3]   = { numVoxels, numVoxels, numVoxels };
+  const double min[3]  = { caloStartX, -halfCaloYZ, -halfCaloYZ };
+  const double max[3]  = { -caloStartX, halfCaloYZ,  halfCaloYZ };
+  // generate the toy energy deposits of all events (position and value)
+  std::mt19937_64 rng(1234);
+  std::exponential_distribution<double> longitudinal(1.0/80.0);
+  std::normal_distribution<double>      transverse(0.0, 15.0);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  const std::size_t numFills = static_cast<std::size_t>(numEvents)*numFillsPerEvent;
+  std::vector<double> pos(3*numFills), edep(numFills);
+  for (std::size_t i=0; i<numFills; ++i) {
+    pos[3*i+0] = caloStartX + longitudinal(rng);
+    pos[3*i+1] = transverse(rng);
+    pos[3*i+2] = transverse(rng);
+    edep[i]    = uni(rng);
+  }
+  // the sparse per-event hash with the dense run grid
+  ScoringMesh theMesh;
+  theMesh.ReSet("", nv, min, max);
+  const auto t0 = std::chrono::steady_clock::now();
+  for (int ie=0; ie<numEvents; ++ie) {
+    const std::size_t first = static_cast<std::size_t>(ie)*numFillsPerEvent;
+    for (std::size_t i=first; i<first+numFillsPerEvent; ++i) {
+      theMesh.Fill(&pos[3*i], edep[i]);
+    }
+    theMesh.EndOfEvent();
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  // the dense per-event grid (added to the run grid and cleared at the end of each event)
+  const std::size_t numVoxelsTotal = static_cast<std::size_t>(numVoxels)*numVoxels*numVoxels;
+  std::vector<double> eventGrid(numVoxelsTotal, 0.0), runGrid(numVoxelsTotal, 0.0);
+  double invSize[3];
+  for (int i=0; i<3; ++i) {
+    invSize[i] = numVoxels/(max[i] - min[i]);
+  }
+  const auto t2 = std::chrono::steady_clock::now();
+  for (int ie=0; ie<numEvents; ++ie) {
+    const std::size_t first = static_cast<std::size_t>(ie)*numFillsPerEvent;
+    for (std::size_t i=first; i<first+numFillsPerEvent; ++i) {
+      const double* r = &pos[3*i];
+      const double ux = (r[0] - min[0])*invSize[0];
+      const double uy = (r[1] - min[1])*invSize[1];
+      const double uz = (r[2] - min[2])*invSize[2];
+      if (!(ux >= 0.0 && uy >= 0.0 && uz >= 0.0) || ux > numVoxels || uy > numVoxels || uz > numVoxels) {
+        continue;
+      }
+      const int ix = std::min(static_cast<int>(ux), numVoxels-1);
+      const int iy = std::min(static_cast<int>(uy), numVoxels-1);
+      const int iz = std::min(static_cast<int>(uz), numVoxels-1);
+      eventGrid[(static_cast<std::size_t>(ix)*numVoxels + iy)*numVoxels + iz] += edep[i];
+    }
+    for (std::size_t iv=0; iv<numVoxelsTotal; ++iv) {
+      runGrid[iv]  += eventGrid[iv];
+      eventGrid[iv] = 0.0;
+    }
+  }
+  const auto t3 = std::chrono::steady_clock::now();
+  // compare the final grids (the order of the additions might differ)
+  const std::vector<double>& meshGrid = theMesh.GetGrid();
+  double maxRelDiff = 0.0;
+  for (std::size_t iv=0; iv<numVoxelsTotal; ++iv) {
+    const double diff = std::abs(meshGrid[iv] - runGrid[iv]);
+    maxRelDiff = std::max(maxRelDiff, runGrid[iv] > 0.0 ? diff/runGrid[iv] : diff);
+  }
+  const double norm   = 1.0E+9/static_cast<double>(numFills);
+  const double tSparse = norm*std::chrono::duration<double>(t1-t0).count();
+  const double tDense  = norm*std::chrono::duration<double>(t3-t2).count();
+  std::printf(" === ScoringMesh: %d^3 voxels, %d events with %d fills each\n", numVoxels, numEvents, numFillsPerEvent);
+  std::printf("     %-28s %14s %14s\n", "method", "ns/fill", "memory [MB]");
+  std::printf("     %-28s %14.2f %14.2f\n", "sparse hash + run grid", tSparse, theMesh.GetMemoryInBytes()/1048576.0);
+  std::printf("     %-28s %14.2f %14.2f\n", "dense event grid + run grid", tDense, 2.0*numVoxelsTotal*sizeof(double)/1048576.0);
+  std::printf("     speedup (dense/sparse) = %.2f   max. relative difference of the grids = %.2e\n", tDense/tSparse, maxRelDiff);
+}
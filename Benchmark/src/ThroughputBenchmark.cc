@@ -0,0 +1,206 @@
+#include "ThroughputBenchmark.hh"
+
+#include "Geometry.hh"
+#include "PrimaryGenerator.hh"
+#include "Results.hh"
+#include "EventLoop.hh"
+#include "BenchmarkStats.hh"
+
+#include "G4HepEmState.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <string>
+
+// NOTE: this is Linux specific!
+#include <sys/resource.h>
+
+
+std::string ThroughputBenchmark::Scenario::GetName() const {
+  char energy[32];
+  if (fEnergy >= 1.0E+6) {
+    std::snprintf(energy, sizeof(energy), "%gTeV", fEnergy*1.0E-6);
+  } else {
+    std::snprintf(energy, sizeof(energy), "%gGeV", fEnergy*1.0E-3);
+  }
+  char name[128];
+  std::snprintf(name, sizeof(name), "%s_%s_gap%gmm_L%d", fParticleName.c_str(), energy, fGapThick, fNumLayers);
+  return name;
+}
+
+
+std::vector<ThroughputBenchmark::Scenario> ThroughputBenchmark::GetScenarios(bool isQuick, double eventScale) {
+  const std::vector<std::string> particles = { "e-", "e+", "gamma" };
+  const std::vector<double>      energies  = isQuick ? std::vector<double>{ 1.0E+4 } : std::vector<double>{ 1.0E+3, 1.0E+4, 1.0E+5, 1.0E+6 };
+  const std::vector<double>      gaps      = { 1.0, 5.7 };
+  const std::vector<int>         layers    = isQuick ? std::vector<int>{ 50 } : std::vector<int>{ 10, 50, 1000 };
+  std::vector<Scenario> theScenarios;
+  for (const std::string& particle : particles) {
+    for (double energy : energies) {
+      for (double gap : gaps) {
+        for (int numLayers : layers) {
+          // similar amount of work in all scenarios: 200 events at 1 GeV
+          const int numEvents = std::max(1, static_cast<int>(std::lround(eventScale*200.0*1.0E+3/energy)));
+          theScenarios.push_back(Scenario{particle, energy, gap, numLayers, numEvents});
+        }
+      }
+    }
+  }
+  return theScenarios;
+}
+
+
+ThroughputBenchmark::Measurement ThroughputBenchmark::RunScenario(G4HepEmState& theState, const Scenario& theScenario, int numThreads, int numWarmup, int numRepetitions) {
+  Measurement theMeasurement;
+  theMeasurement.fScenario = theScenario;
+  ResetPeakRSS();
+  const auto t0 = std::chrono::steady_clock::now();
+  // the same set up as in the `HepEmShow` application (without readout, mesh or any output)
+  Geometry theGeometry;
+  theGeometry.SetNumLayers(theScenario.fNumLayers);
+  theGeometry.SetGapThick(theScenario.fGapThick);
+  PrimaryGenerator thePrimaryGenerator;
+  const double charge = theScenario.fParticleName == "e-" ? -1.0 : (theScenario.fParticleName == "gamma" ? 0.0 : +1.0);
+  thePrimaryGenerator.SetCharge(charge);
+  thePrimaryGenerator.SetKinEnergy(theScenario.fEnergy);
+  thePrimaryGenerator.SetPosition(theGeometry.GetPrimaryXposition(), 0.0, 0.0);
+  thePrimaryGenerator.SetDirection(1.0, 0.0, 0.0);
+  Results theResult;
+  theResult.fEdepPerLayer.ReSet("hist_Edep_PerLayer", 0, theGeometry.GetNumLayers(), theGeometry.GetNumLayers());
+  theResult.fGammaTrackLenghtPerLayer.ReSet("hist_GamTrackL_PerLayer", 0, theGeometry.GetNumLayers(), theGeometry.GetNumLayers());
+  theResult.fElPosTrackLenghtPerLayer.ReSet("hist_ElPosTrackL_PerLayer", 0, theGeometry.GetNumLayers(), theGeometry.GetNumLayers());
+  const auto t1 = std::chrono::steady_clock::now();
+  // each (warm-up and timed) repetition starts from the empty results (the copy is not timed)
+  // NOTE: the same events are simulated in each repetition (same seed) so the number of steps is the same
+  const Results thePrototype(theResult);
+  const BenchmarkStats::Result theStats = BenchmarkStats::Measure(theScenario.GetName(), 1, numWarmup, std::max(1, numRepetitions),
+    [&]() { EventLoop::ProcessEvents(theState, thePrimaryGenerator, theGeometry, theResult, theScenario.fNumEvents, 0, numThreads, false, 0, 1234, 0, nullptr, 0); },
+    [&]() { theResult = thePrototype; });
+  //
+  theMeasurement.fSetUpTime      = std::chrono::duration<double>(t1-t0).count();
+  theMeasurement.fWallTime       = 1.0E-9*theStats.fMedian;
+  theMeasurement.fWallTimeMAD    = 1.0E-9*theStats.fMAD;
+  theMeasurement.fNumRepetitions = theStats.fNumRepetitions;
+  theMeasurement.fNumSteps     = theResult.fNumStepsGamma.GetMean()*theResult.fNumStepsGamma.fN + theResult.fNumStepsElPos.GetMean()*theResult.fNumStepsElPos.fN;
+  theMeasurement.fEventsPerSec = theMeasurement.fWallTime > 0.0 ? theScenario.fNumEvents/theMeasurement.fWallTime : 0.0;
+  theMeasurement.fStepsPerSec  = theMeasurement.fWallTime > 0.0 ? theMeasurement.fNumSteps/theMeasurement.fWallTime : 0.0;
+  theMeasurement.fPeakRSS      = GetPeakRSS();
+  return theMeasurement;
+}
+
+
+bool ThroughputBenchmark::ResetPeakRSS() {
+  // NOTE: writing `5` into `clear_refs` resets the `VmHWM` of the process to its current `VmRSS`
+  FILE* f = std::fopen("/proc/self/clear_refs", "w");
+  if (!f) {
+    return false;
+  }
+  const bool isReset = std::fputs("5", f) >= 0;
+  return std::fclose(f) == 0 && isReset;
+}
+
+
+long ThroughputBenchmark::GetPeakRSS() {
+  // NOTE: the `VmHWM` is used since the `ru_maxrss` is not reset by the above (and it
+  //       also keeps the peak of the already completed worker threads)
+  std::ifstream theFile("/proc/self/status");
+  std::string   line;
+  while (std::getline(theFile, line)) {
+    if (line.compare(0, 6, "VmHWM:") == 0) {
+      return std::strtol(line.c_str() + 6, nullptr, 10);
+    }
+  }
+  // the high-water mark of the whole process if the `/proc` is not available
+  struct rusage theUsage;
+  getrusage(RUSAGE_SELF, &theUsage);
+  return theUsage.ru_maxrss;
+}
+
+
+bool ThroughputBenchmark::WriteJSON(const std::string& fileName, double startUpTime, int numThreads, const std::vector<Measurement>& theMeasurements) {
+  FILE* f = std::fopen(fileName.c_str(), "w");
+  if (!f) {
+    return false;
+  }
+  std::fprintf(f, "{\n");
+  std::fprintf(f, "  \"suite\": \"Throughput\",\n");
+  std::fprintf(f, "  \"timestamp\": %lld,\n", static_cast<long long>(std::time(nullptr)));
+  std::fprintf(f, "  \"threads\": %d,\n", numThreads);
+  std::fprintf(f, "  \"startup_s\": %.6g,\n", startUpTime);
+  std::fprintf(f, "  \"scenarios\": [\n");
+  // NOTE: one scenario per line (`ReadBaseline()` relies on this)
+  for (std::size_t i=0; i<theMeasurements.size(); ++i) {
+    const Measurement& m = theMeasurements[i];
+    const Scenario&    s = m.fScenario;
+    std::fprintf(f, "    {\"name\": \"%s\", \"particle\": \"%s\", \"energy_MeV\": %g, \"gap_mm\": %g, \"layers\": %d, \"events\": %d, "
+                    "\"setup_s\": %.6g, \"repetitions\": %d, \"wall_s\": %.6g, \"wall_mad_s\": %.6g, \"events_per_s\": %.6g, \"steps\": %.0f, \"steps_per_s\": %.6g, \"peak_rss_kB\": %ld}%s\n",
+                 s.GetName().c_str(), s.fParticleName.c_str(), s.fEnergy, s.fGapThick, s.fNumLayers, s.fNumEvents,
+                 m.fSetUpTime, m.fNumRepetitions, m.fWallTime, m.fWallTimeMAD, m.fEventsPerSec, m.fNumSteps, m.fStepsPerSec, m.fPeakRSS, i+1 < theMeasurements.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+  std::fclose(f);
+  return true;
+}
+
+
+bool ThroughputBenchmark::ReadBaseline(const std::string& fileName, std::map<std::string, double>& theBaseline) {
+  theBaseline.clear();
+  std::ifstream theFile(fileName);
+  if (!theFile.is_open()) {
+    return false;
+  }
+  std::string   line;
+  const std::string nameKey  = "\"name\": \"";
+  const std::string valueKey = "\"events_per_s\": ";
+  while (std::getline(theFile, line)) {
+    const std::size_t iName  = line.find(nameKey);
+    const std::size_t iValue = line.find(valueKey);
+    if (iName == std::string::npos || iValue == std::string::npos) {
+      continue;
+    }
+    const std::size_t iStart = iName + nameKey.size();
+    const std::size_t iEnd   = line.find('"', iStart);
+    if (iEnd == std::string::npos) {
+      continue;
+    }
+    theBaseline[line.substr(iStart, iEnd - iStart)] = std::strtod(line.c_str() + iValue + valueKey.size(), nullptr);
+  }
+  return !theFile.bad() && !theBaseline.empty();
+}
+
+
+int ThroughputBenchmark::Compare(const std::vector<Measurement>& theMeasurements, const std::map<std::string, double>& theBaseline, double tolerance) {
+  int numRegressed = 0;
+  std::printf(" === Throughput: %zu scenarios (tolerance %.1f%% of the baseline events/s)\n", theMeasurements.size(), 100.0*tolerance);
+  std::printf("     %-28s %7s %10s %8s %12s %14s %12s %10s %9s\n", "scenario", "events", "wall [s]", "MAD [%]", "events/s", "steps/s", "RSS [MB]", "vs base", "status");
+  for (const Measurement& m : theMeasurements) {
+    const std::string name = m.fScenario.GetName();
+    const auto        itr  = theBaseline.find(name);
+    char        change[32] = "-";
+    const char* status     = "new";
+    if (itr != theBaseline.end() && itr->second > 0.0) {
+      const double ratio = m.fEventsPerSec/itr->second;
+      std::snprintf(change, sizeof(change), "%+.1f%%", 100.0*(ratio - 1.0));
+      status = ratio < 1.0 - tolerance ? "REGRESSED" : "ok";
+      numRegressed += ratio < 1.0 - tolerance ? 1 : 0;
+    }
+    const double relMAD = m.fWallTime > 0.0 ? 100.0*m.fWallTimeMAD/m.fWallTime : 0.0;
+    std::printf("     %-28s %7d %10.3f %8.2f %12.4g %14.4g %12.1f %10s %9s\n", name.c_str(), m.fScenario.fNumEvents, m.fWallTime,
+                relMAD, m.fEventsPerSec, m.fStepsPerSec, m.fPeakRSS/1024.0, change, status);
+  }
+  // the scenarios of the baseline that were not simulated
+  int numMissing = 0;
+  for (const auto& theEntry : theBaseline) {
+    const bool isSimulated = std::any_of(theMeasurements.begin(), theMeasurements.end(), [&](const Measurement& m) { return m.fScenario.GetName() == theEntry.first; });
+    if (!isSimulated) {
+      std::printf("     %-28s %7s %10s %8s %12.4g %14s %12s %10s %9s\n", theEntry.first.c_str(), "-", "-", "-", theEntry.second, "-", "-", "-", "MISSING");
+      ++numMissing;
+    }
+  }
+  return numRegressed + numMissing;
+}
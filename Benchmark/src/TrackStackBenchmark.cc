@@ -0,0 +1,223 @@
+#include "TrackStackBenchmark.hh"
+
+#include "TrackStack.hh"
+#include "AoSTrackStack.hh"
+
+#include "G4HepEmTrack.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace {
+
+// A cheap (xorshift64*) generator so that the random numbers do not dominate the measured time.
+struct ToyRandom {
+  std::uint64_t fState;
+  double flat() {
+    fState ^= fState >> 12;
+    fState ^= fState << 25;
+    fState ^= fState >> 27;
+    return ((fState * 0x2545F4914F6CDD1DULL) >> 11) * 0x1.0p-53;
+  }
+};
+
+
+// Generates the two secondaries of the toy cascade when the `track` (with energy above the
+// critical energy) splits: pair production for gamma and bremsstrahlung for e-/e+.
+void Split(G4HepEmTrack& track, G4HepEmTrack* secondaries, ToyRandom& rng, int& trackID) {
+  const double ekin = track.GetEKin();
+  const double frac = 0.1 + 0.8*rng.flat();
+  const bool   isGamma = track.GetCharge() == 0.0;
+  for (int is=0; is<2; ++is) {
+    G4HepEmTrack& sec = secondaries[is];
+    sec.ReSet();
+    sec.SetPosition(track.GetPosition());
+    sec.SetDirection(track.GetDirection());
+    sec.SetEKin(is == 0 ? frac*ekin : (1.0-frac)*ekin);
+    sec.SetCharge(isGamma ? (is == 0 ? -1.0 : 1.0) : (is == 0 ? track.GetCharge() : 0.0));
+    sec.SetID(trackID++);
+    sec.SetParentID(track.GetID());
+    sec.SetMCIndex(track.GetMCIndex());
+  }
+}
+
+
+void SetPrimary(G4HepEmTrack& primary, double primaryEnergy) {
+  primary.ReSet();
+  primary.SetPosition(0.0, 0.0, 0.0);
+  primary.SetDirection(1.0, 0.0, 0.0);
+  primary.SetEKin(primaryEnergy);
+  primary.SetCharge(-1.0);
+  primary.SetID(0);
+  primary.SetMCIndex(1);
+}
+
+} // namespace
+
+
+TrackStackBenchmark::Result TrackStackBenchmark::RunSoA(double primaryEnergy, int numCascades) {
+  TrackStack theStack;
+  ToyRandom rng{0x9E3779B97F4A7C15ULL};
+  G4HepEmTrack theTrack;
+  G4HepEmTrack theSecondaries[2];
+  G4HepEmTrack* theSecondaryPtrs[2] = {&theSecondaries[0], &theSecondaries[1]};
+  Result res = {0.0, 0.0, 0, 0, 0, 0.0};
+  const auto start = std::chrono::steady_clock::now();
+  for (int ic=0; ic<numCascades; ++ic) {
+    int trackID = 1;
+    SetPrimary(theTrack, primaryEnergy);
+    theStack.Push(theTrack);
+    res.fNumOperations += 1.0;
+    while (theStack.PopInto(theTrack) > -1) {
+      res.fNumOperations += 1.0;
+      if (theTrack.GetEKin() < kCriticalEnergy) {
+        res.fCheckSum += theTrack.GetEKin();
+        continue;
+      }
+      Split(theTrack, theSecondaries, rng, trackID);
+      theStack.Push(theSecondaryPtrs, 2);
+      res.fNumOperations += 2.0;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  res.fTimeInSec      = std::chrono::duration<double>(end-start).count();
+  res.fPeakNumTracks  = theStack.GetPeakNumTracks();
+  res.fPeakMemory     = res.fPeakNumTracks*TrackStack::kRecordSize;
+  res.fCapacityMemory = theStack.GetMemoryInBytes();
+  return res;
+}
+
+
+TrackStackBenchmark::Result TrackStackBenchmark::RunAoS(double primaryEnergy, int numCascades) {
+  AoSTrackStack theStack;
+  ToyRandom rng{0x9E3779B97F4A7C15ULL};
+  G4HepEmTrack theTrack;
+  G4HepEmTrack theSecondaries[2];
+  Result res = {0.0, 0.0, 0, 0, 0, 0.0};
+  const auto start = std::chrono::steady_clock::now();
+  for (int ic=0; ic<numCascades; ++ic) {
+    int trackID = 1;
+    SetPrimary(theTrack, primaryEnergy);
+    theStack.Copy(theTrack, theStack.Insert());
+    res.fNumOperations += 1.0;
+    while (theStack.PopInto(theTrack) > -1) {
+      res.fNumOperations += 1.0;
+      if (theTrack.GetEKin() < kCriticalEnergy) {
+        res.fCheckSum += theTrack.GetEKin();
+        continue;
+      }
+      Split(theTrack, theSecondaries, rng, trackID);
+      theStack.Copy(theSecondaries[0], theStack.Insert());
+      theStack.Copy(theSecondaries[1], theStack.Insert());
+      res.fNumOperations += 2.0;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  res.fTimeInSec      = std::chrono::duration<double>(end-start).count();
+  res.fPeakNumTracks  = theStack.GetPeakNumTracks();
+  res.fPeakMemory     = res.fPeakNumTracks*sizeof(G4HepEmTrack);
+  res.fCapacityMemory = theStack.GetMemoryInBytes();
+  return res;
+}
+
+
+void TrackStackBenchmark::Run(double primaryEnergy, int numCascades, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults) {
+  // a first (not timed) simulation with both stacks gives the number of operations and the memory use
+  const Result resAoS = RunAoS(primaryEnergy, numCascades);
+  const Result resSoA = RunSoA(primaryEnergy, numCascades);
+  const long   numOperations = static_cast<long>(resSoA.fNumOperations);
+  char energy[32];
+  std::snprintf(energy, sizeof(energy), "%g MeV", primaryEnergy);
+  BenchmarkStats::PrintHeader("TrackStack: toy cascade of E0 = " + std::string(energy) + " primary ("
+                              + std::to_string(numCascades) + " cascades, " + std::to_string(numOperations) + " push+pop per repetition)");
+  double checkSum[2] = {0.0, 0.0};
+  const BenchmarkStats::Result timeAoS = BenchmarkStats::Measure("TrackStack cascade " + std::string(energy) + " AoS", numOperations, numWarmup, numRepetitions, [&]() {
+    checkSum[0] = RunAoS(primaryEnergy, numCascades).fCheckSum;
+  });
+  const BenchmarkStats::Result timeSoA = BenchmarkStats::Measure("TrackStack cascade " + std::string(energy) + " SoA", numOperations, numWarmup, numRepetitions, [&]() {
+    checkSum[1] = RunSoA(primaryEnergy, numCascades).fCheckSum;
+  });
+  BenchmarkStats::Print(timeAoS);
+  BenchmarkStats::Print(timeSoA);
+  theResults.push_back(timeAoS);
+  theResults.push_back(timeSoA);
+  std::printf("     %-8s %14s %12s %16s %16s\n", "stack", "Mops/s", "peak #tracks", "peak mem. [B]", "capacity [B]");
+  const Result* results[2] = {&resAoS, &resSoA};
+  const double  times[2]   = {timeAoS.fMedian, timeSoA.fMedian};
+  const char*   names[2]   = {"AoS", "SoA"};
+  for (int i=0; i<2; ++i) {
+    const Result& r = *results[i];
+    std::printf("     %-8s %14.2f %12d %16zu %16zu\n", names[i], 1.0E+3/times[i], r.fPeakNumTracks, r.fPeakMemory, r.fCapacityMemory);
+  }
+  const bool isSame = resAoS.fCheckSum == resSoA.fCheckSum && checkSum[0] == resAoS.fCheckSum && checkSum[1] == resSoA.fCheckSum;
+  std::printf("     speedup (SoA/AoS) = %.2f   memory ratio (SoA/AoS) = %.2f   check-sum %s\n",
+              timeAoS.fMedian/timeSoA.fMedian, static_cast<double>(resSoA.fPeakMemory)/resAoS.fPeakMemory,
+              isSame ? "OK" : "MISMATCH");
+}
+
+
+void TrackStackBenchmark::RunOperations(int numTracks, int numWarmup, int numRepetitions, std::vector<BenchmarkStats::Result>& theResults) {
+  // a toy track population
+  ToyRandom rng{0x9E3779B97F4A7C15ULL};
+  std::vector<G4HepEmTrack> theTracks(numTracks);
+  for (int i=0; i<numTracks; ++i) {
+    G4HepEmTrack& t = theTracks[i];
+    t.SetPosition(100.0*rng.flat(), 100.0*rng.flat(), 100.0*rng.flat());
+    t.SetDirection(1.0, 0.0, 0.0);
+    t.SetEKin(1.0E+4*rng.flat());
+    t.SetCharge(static_cast<double>(static_cast<int>(3.0*rng.flat()) - 1));
+    t.SetID(i);
+  }
+  std::vector<G4HepEmTrack*> theTrackPtrs(numTracks);
+  for (int i=0; i<numTracks; ++i) {
+    theTrackPtrs[i] = &theTracks[i];
+  }
+  std::vector<G4HepEmTrack>  thePoppedBulk(kBulkSize);
+  std::vector<G4HepEmTrack*> thePoppedPtrs(kBulkSize);
+  for (int i=0; i<kBulkSize; ++i) {
+    thePoppedPtrs[i] = &thePoppedBulk[i];
+  }
+  TrackStack   theStack;
+  G4HepEmTrack thePopped;
+  auto EmptyStack = [&]() {
+    while (theStack.PopInto(thePoppedPtrs.data(), kBulkSize) > 0) {}
+  };
+  auto FillStack = [&]() {
+    EmptyStack();
+    for (int i=0; i<numTracks; ++i) {
+      theStack.Push(theTracks[i]);
+    }
+  };
+  BenchmarkStats::PrintHeader("TrackStack: single and bulk (" + std::to_string(kBulkSize) + ") operations on " + std::to_string(numTracks) + " tracks");
+  theResults.push_back(BenchmarkStats::Measure("TrackStack::Push", numTracks, numWarmup, numRepetitions, [&]() {
+    for (int i=0; i<numTracks; ++i) {
+      theStack.Push(theTracks[i]);
+    }
+  }, EmptyStack));
+  BenchmarkStats::Print(theResults.back());
+  theResults.push_back(BenchmarkStats::Measure("TrackStack::Push bulk", numTracks, numWarmup, numRepetitions, [&]() {
+    for (int i=0; i+kBulkSize<=numTracks; i+=kBulkSize) {
+      theStack.Push(&theTrackPtrs[i], kBulkSize);
+    }
+  }, EmptyStack));
+  BenchmarkStats::Print(theResults.back());
+  theResults.push_back(BenchmarkStats::Measure("TrackStack::PushSecondaries", numTracks, numWarmup, numRepetitions, [&]() {
+    for (int i=0; i+2<=numTracks; i+=2) {
+      theStack.PushSecondaries(&theTrackPtrs[i], 2, theTracks[i]);
+    }
+  }, EmptyStack));
+  BenchmarkStats::Print(theResults.back());
+  theResults.push_back(BenchmarkStats::Measure("TrackStack::PopInto", numTracks, numWarmup, numRepetitions, [&]() {
+    while (theStack.PopInto(thePopped) > -1) {}
+    BenchmarkStats::DoNotOptimize(thePopped);
+  }, FillStack));
+  BenchmarkStats::Print(theResults.back());
+  theResults.push_back(BenchmarkStats::Measure("TrackStack::PopInto bulk", numTracks, numWarmup, numRepetitions, [&]() {
+    while (theStack.PopInto(thePoppedPtrs.data(), kBulkSize) > 0) {}
+    BenchmarkStats::DoNotOptimize(thePoppedBulk[0]);
+  }, FillStack));
+  BenchmarkStats::Print(theResults.back());
+  EmptyStack();
+}
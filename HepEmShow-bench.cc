@@ -0,0 +1,123 @@
+/**
+ * @file    HepEmShow-bench.cc
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief The main funtion of the `HepEmShow-bench` benchmark application.
+ *
+ * Auxiliary application that measures the performance of some of the components
+ * of the `HepEmShow` simulation in isolation (i.e. without running the full
+ * simulation). The available benchmarks:
+ * - `TrackStackBenchmark`: push/pop throughput and memory use of the `TrackStack`
+ *   under the load of a toy cascade of 10 GeV and 1 TeV primaries and the cost of
+ *   its single and bulk operations.
+ * - `BoxBenchmark`: per-point cost (and bit-by-bit agreement) of the single point
+ *   and batch `Box::DistanceToOut` methods.
+ * - `GeometryBenchmark`: per-call cost (and agreement) of the `Box` and boundary
+ *   table based location and distance to out computations of the `Geometry`.
+ * - `HistBenchmark`: multi-threaded filling of the per-thread `Results` histogram
+ *   replicas with their parallel tree reduction compared to a shared, locked one
+ *   and the cost of a single `Hist::Fill`.
+ * - `ScoringMeshBenchmark`: per-step cost and memory use of the sparse per-event
+ *   accumulation of the `ScoringMesh` compared to a dense per-event grid.
+ * - `MomentsBenchmark`: per-event cost and precision of the `Moments` (Welford)
+ *   accumulators of the `Results` compared to the plain sum and sum of squares.
+ * - `ExactSumBenchmark`: per-fill cost and order independence of the exact
+ *   (reproducible) histogram accumulation compared to the plain double one.
+ * - `RandomBenchmark`: per-number cost, re-seeding cost and state size of the `mt19937_64`
+ *   and the counter based `Philox4x32-10` engines of `URandom`.
+ *
+ * The kernels of the `TrackStack`, `Box`, `Geometry`, `Hist` and `Random` benchmarks
+ * are timed after warm-up over several repetitions and summarised by the median and
+ * MAD of their per-item time (see `BenchmarkStats`). These measurements are also
+ * written into the machine readable `bench_Kernels.json` file.
+ *
+ * All benchmarks are run when executed without input arguments while only the
+ * given ones otherwise (e.g. `./HepEmShow-bench Box Geometry` runs the `BoxBenchmark`
+ * and the `GeometryBenchmark`).
+ */
+
+// Local includes:
+#include "TrackStackBenchmark.hh"
+#include "BoxBenchmark.hh"
+#include "GeometryBenchmark.hh"
+#include "HistBenchmark.hh"
+#include "ScoringMeshBenchmark.hh"
+#include "MomentsBenchmark.hh"
+#include "ExactSumBenchmark.hh"
+#include "RandomBenchmark.hh"
+#include "BenchmarkStats.hh"
+
+#include <string>
+#include <vector>
+#include <cstdio>
+
+
+/** The main function of the `HepEmShow-bench` application (see more in the description). */
+int main(int argc, char* argv[]) {
+
+  // the benchmarks given as input arguments are run (all if none was given)
+  auto IsSelected = [&](const std::string& name) {
+    bool isSelected = argc < 2;
+    for (int i=1; i<argc; ++i) {
+      isSelected = isSelected || name == argv[i];
+    }
+    return isSelected;
+  };
+  // the kernels are timed with 3 warm-up and 15 timed repetitions
+  const int numWarmup      = 3;
+  const int numRepetitions = 15;
+  std::vector<BenchmarkStats::Result> theResults;
+
+  // `TrackStack` push/pop throughput and memory (energies in [MeV]) and its operations on 1M tracks
+  if (IsSelected("TrackStack")) {
+    TrackStackBenchmark::Run(1.0E+4, 200, numWarmup, numRepetitions, theResults);
+    TrackStackBenchmark::Run(1.0E+6,   2, numWarmup, numRepetitions, theResults);
+    TrackStackBenchmark::RunOperations(1000000, numWarmup, numRepetitions, theResults);
+  }
+
+  // `Box` single point and batch distance to out: 1M random points with 20% edge cases
+  if (IsSelected("Box")) {
+    BoxBenchmark::Run(1000000, 0.2, numWarmup, numRepetitions, theResults);
+  }
+
+  // `Geometry` location: 1M shower-like points (and 1M random points with 10% on a boundary in the check)
+  if (IsSelected("Geometry")) {
+    GeometryBenchmark::Run(1000000, 0.1, numWarmup, numRepetitions, theResults);
+  }
+
+  // `Hist` per-thread replicas: 1M fills per thread with up to 128 threads and 1M single fills
+  if (IsSelected("Hist")) {
+    HistBenchmark::Run(50, 1000000, 128);
+    HistBenchmark::RunFill(50, 1000000, numWarmup, numRepetitions, theResults);
+  }
+
+  // `ScoringMesh` sparse per-event accumulation: 200 events with 10k steps each
+  if (IsSelected("ScoringMesh")) {
+    ScoringMeshBenchmark::Run( 50, 200, 10000);
+    ScoringMeshBenchmark::Run(200, 200, 10000);
+  }
+
+  // `Moments` accumulators: 100M events (large mean to std-dev ratio) merged from 64 parts
+  if (IsSelected("Moments")) {
+    MomentsBenchmark::Run(100000000, 1.0E+4, 1.0, 64);
+  }
+
+  // `ExactSum` reproducible histograms: 10M fills shuffled and merged from 64 parts
+  if (IsSelected("ExactSum")) {
+    ExactSumBenchmark::Run(50, 10000000, 64);
+  }
+
+  // `URandom` engines: 1M numbers (arrays of 4 and 256) and 100k streams
+  if (IsSelected("Random")) {
+    RandomBenchmark::Run(1000000, 256, 100000, numWarmup, numRepetitions, theResults);
+  }
+
+  // write all the kernel measurements
+  if (!theResults.empty()) {
+    const char* fileName = "bench_Kernels.json";
+    std::printf(" === Kernel measurements %s %s\n", BenchmarkStats::WriteJSON(fileName, "Kernels", theResults) ? "written into" : "cannot be written into", fileName);
+  }
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file    HepEmShow-combine.cc
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief The main funtion of the `HepEmShow-combine` auxiliary application.
+ *
+ * Combines the `results_Moments` files, written by independent `HepEmShow` jobs
+ * (e.g. the events split across jobs by the `--first-event-id` input argument),
+ * into a single one:
+ * - the raw state of the accumulators is read from each file (see `Moments::Read()`)
+ * - the accumulators of the same quantity are merged by `Moments::Merge()`: exactly,
+ *   i.e. independently from the order of the files, if the jobs were run in the
+ *   reproducible mode (all files need to be written in the same mode)
+ * - the combined raw states are written into the output file (the same format
+ *   so it can be combined further) and the mean and standard deviation of each
+ *   quantity is reported on the screen
+ *
+ * Run as `./HepEmShow-combine [-o output] file1 file2 ...` (the output file is
+ * `results_Moments_Combined` by default).
+ */
+
+// Local includes:
+#include "Moments.hh"
+
+// System includes:
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// NOTE: this is Unix specific!
+#include <unistd.h>
+
+
+// a quantity with its accumulator combined over the files
+struct NamedMoments {
+  std::string fName;
+  Moments     fMoments;
+};
+
+static void Help() {
+  std::cout << "\n === Usage: HepEmShow-combine [-o output] file1 file2 ... \n" << std::endl;
+  std::cout << "\t-o  output file of the combined results_Moments   - default: results_Moments_Combined" << std::endl;
+  std::cout << "\t-h  help" << std::endl;
+}
+
+// reads all accumulators of the file and merges them into the combined ones
+// (the quantities are taken from the first file then must be the same in all)
+static bool CombineFile(const std::string& fileName, std::vector<NamedMoments>& theCombined, bool isFirst) {
+  FILE* f = fopen(fileName.c_str(), "r");
+  if (!f) {
+    std::cerr << "\n ***** ERROR in HepEmShow-combine: cannot open the file = " << fileName << std::endl;
+    return false;
+  }
+  char    name[64];
+  Moments theMoments;
+  std::size_t numRead = 0;
+  bool isOK = true;
+  while (isOK && theMoments.Read(f, name)) {
+    if (isFirst) {
+      theCombined.push_back({ name, theMoments });
+    } else if (numRead >= theCombined.size() || theCombined[numRead].fName != name) {
+      std::cerr << "\n ***** ERROR in HepEmShow-combine: unexpected quantity " << name << " in the file = " << fileName << std::endl;
+      isOK = false;
+    } else if (theCombined[numRead].fMoments.fIsExact != theMoments.fIsExact) {
+      std::cerr << "\n ***** ERROR in HepEmShow-combine: exact and not exact results cannot be combined (file = " << fileName << ")" << std::endl;
+      isOK = false;
+    } else {
+      theCombined[numRead].fMoments.Merge(theMoments);
+    }
+    ++numRead;
+  }
+  // the whole file must have been read and all quantities must be there
+  if (isOK && (!feof(f) || numRead != theCombined.size())) {
+    std::cerr << "\n ***** ERROR in HepEmShow-combine: cannot interpret the file = " << fileName << std::endl;
+    isOK = false;
+  }
+  fclose(f);
+  return isOK;
+}
+
+
+int main(int argc, char *argv[]) {
+  std::string outputFile = "results_Moments_Combined";
+  int c;
+  while ((c = getopt(argc, argv, "ho:")) != -1) {
+    switch (c) {
+    case 'o':
+      outputFile = optarg;
+      break;
+    default:
+      Help();
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    Help();
+    return 1;
+  }
+  //
+  // read and merge the accumulators of all input files
+  std::vector<NamedMoments> theCombined;
+  for (int i=optind; i<argc; ++i) {
+    if (!CombineFile(argv[i], theCombined, i == optind)) {
+      return 1;
+    }
+  }
+  //
+  // write the combined raw states and report the mean and standard deviation
+  FILE* f = fopen(outputFile.c_str(), "w");
+  if (!f) {
+    std::cerr << "\n ***** ERROR in HepEmShow-combine: cannot create the file = " << outputFile << std::endl;
+    return 1;
+  }
+  for (const NamedMoments& theNamed : theCombined) {
+    theNamed.fMoments.Write(f, theNamed.fName.c_str());
+  }
+  fclose(f);
+  std::cout << " === HepEmShow-combine: " << argc-optind << " files combined into " << outputFile
+            << (!theCombined.empty() && theCombined[0].fMoments.fIsExact ? " (exact)" : "") << std::endl;
+  std::cout << std::setprecision(8);
+  for (const NamedMoments& theNamed : theCombined) {
+    std::cout << "   " << std::setw(16) << std::left << theNamed.fName << std::right
+              << " N = " << std::setw(10) << theNamed.fMoments.fN
+              << "  mean = " << std::setw(14) << theNamed.fMoments.GetMean()
+              << "  std-dev = " << theNamed.fMoments.GetStdDev() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file    HepEmShow-throughput.cc
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief The main funtion of the `HepEmShow-throughput` end-to-end benchmark application.
+ *
+ * Auxiliary application that measures the end-to-end throughput (events/s and
+ * steps/s) of the `HepEmShow` simulation over a matrix of scenarios (primary
+ * particle, energy, `gap` thickness and number of layers) in a single process
+ * (see `ThroughputBenchmark`):
+ * - the `G4HepEm` state is loaded (the start up time) as in `HepEmShow`
+ * - all scenarios of the matrix are simulated one after the other (after warm-up,
+ *   repeatedly) while their median wall time, events/s, steps/s, set up time and
+ *   the peak resident set size are measured
+ * - the results are written into a JSON file and compared to a baseline (i.e. a
+ *   result file written earlier): the application exits with a non-zero code if
+ *   the events/s of any scenario is lower than the baseline by more than the
+ *   given tolerance, if any scenario of the baseline was not simulated or if the
+ *   required baseline cannot be read (i.e. it can be used as a regression gate).
+ *
+ * Run as `./HepEmShow-throughput --help` to see the input arguments. A baseline
+ * can be recorded by `./HepEmShow-throughput -o baseline.json` and used later by
+ * `./HepEmShow-throughput -b baseline.json`.
+ */
+
+// Local includes:
+#include "ThroughputBenchmark.hh"
+#include "HepEmStateImage.hh"
+
+// G4HepEm includes:
+#include "G4HepEmState.hh"
+
+// System includes:
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// NOTE: this is Unix specific!
+#include <getopt.h>
+
+
+// the input arguments of the `HepEmShow-throughput` application
+static struct option options[] = {
+  {"g4hepem-data-file     (the pre-generated data file with its path)     - default: ../data/hepem_data" , required_argument, 0, 'd'},
+  {"threads               (number of worker threads for the event loop)   - default: 1"      , required_argument, 0, 'j'},
+  {"quick                 (reduced scenario matrix if 1)                  - default: 0"      , required_argument, 0, 'q'},
+  {"event-scale           (number of events of all scenarios scaled by)   - default: 1"      , required_argument, 0, 's'},
+  {"warmup                (number of not timed runs of each scenario)     - default: 1"      , required_argument, 0, 'w'},
+  {"repetitions           (number of timed runs of each scenario)         - default: 5"      , required_argument, 0, 'r'},
+  {"output                (JSON file the results are written to)          - default: throughput.json" , required_argument, 0, 'o'},
+  {"baseline              (JSON file of earlier results to compare with)  - default: none"   , required_argument, 0, 'b'},
+  {"tolerance             (allowed relative decrease of the events/s)     - default: 0.1"    , required_argument, 0, 't'},
+  {"help"                                                                                    , no_argument      , 0, 'h'},
+  {0, 0, 0, 0}
+};
+
+static void Help() {
+  std::cout<<"\n === Usage: HepEmShow-throughput [OPTIONS] \n"<<std::endl;
+  for (int i = 0; options[i].name != NULL; i++) {
+    printf("\t-%c  --%s\n", options[i].val, options[i].name);
+  }
+}
+
+
+/** The main function of the `HepEmShow-throughput` application (see more in the description). */
+int main(int argc, char* argv[]) {
+
+  std::string dataFile     = "../data/hepem_data";
+  std::string outputFile   = "throughput.json";
+  std::string baselineFile = "";
+  int         numThreads   = 1;
+  int         isQuick      = 0;
+  double      eventScale   = 1.0;
+  double      tolerance    = 0.1;
+  int         numWarmup    = 1;
+  int         numReps      = 5;
+  while (true) {
+    int c, optidx = 0;
+    c = getopt_long(argc, argv, "hd:j:q:s:w:r:o:b:t:", options, &optidx);
+    if (c == -1)
+      break;
+    switch (c) {
+    case 0:
+       c = options[optidx].val;
+       /* fall through */
+    case 'd':
+       dataFile = optarg;
+       break;
+    case 'j':
+       numThreads = std::max(1, std::stoi(optarg));
+       break;
+    case 'q':
+       isQuick = std::stoi(optarg);
+       break;
+    case 's':
+       eventScale = std::stod(optarg);
+       break;
+    case 'w':
+       numWarmup = std::max(0, std::stoi(optarg));
+       break;
+    case 'r':
+       numReps = std::max(1, std::stoi(optarg));
+       break;
+    case 'o':
+       outputFile = optarg;
+       break;
+    case 'b':
+       baselineFile = optarg;
+       break;
+    case 't':
+       tolerance = std::stod(optarg);
+       break;
+    case 'h':
+       Help();
+       exit(-1);
+       break;
+    default:
+      printf("\n *** Unknown input argument: %c\n",c);
+      Help();
+      exit(-1);
+    }
+  }
+
+  // the same convention as in `HepEmShow`: the `.json` extension is added if missing
+  if (dataFile.find(".json") == std::string::npos) {
+    dataFile += ".json";
+  }
+  // the baseline (if any) must be readable: a gate that cannot compare must not pass
+  std::map<std::string, double> theBaseline;
+  if (!baselineFile.empty() && !ThroughputBenchmark::ReadBaseline(baselineFile, theBaseline)) {
+    std::cerr << "\n ***** ERROR in HepEmShow-throughput: cannot read the baseline (or it has no scenarios) = " << baselineFile << std::endl;
+    return 2;
+  }
+  // load the `G4HepEm` state once for all scenarios: this is the start up time
+  const auto start = std::chrono::steady_clock::now();
+  G4HepEmState* theState = HepEmStateImage::Load(dataFile, true, 0);
+  const double startUpTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // simulate all scenarios of the matrix
+  const std::vector<ThroughputBenchmark::Scenario> theScenarios = ThroughputBenchmark::GetScenarios(isQuick > 0, eventScale);
+  std::vector<ThroughputBenchmark::Measurement> theMeasurements;
+  for (const ThroughputBenchmark::Scenario& theScenario : theScenarios) {
+    theMeasurements.push_back(ThroughputBenchmark::RunScenario(*theState, theScenario, numThreads, numWarmup, numReps));
+  }
+
+  // write the results and compare them to the baseline (if any)
+  std::printf(" === Start up (G4HepEm state loading) time = %.4f [s]\n", startUpTime);
+  const int numRegressed = ThroughputBenchmark::Compare(theMeasurements, theBaseline, tolerance);
+  if (!ThroughputBenchmark::WriteJSON(outputFile, startUpTime, numThreads, theMeasurements)) {
+    std::cerr << "\n ***** ERROR in HepEmShow-throughput: cannot write the results to = " << outputFile << std::endl;
+    return 2;
+  }
+  std::printf("     (written into %s)\n", outputFile.c_str());
+  if (numRegressed > 0) {
+    std::printf(" *** %d scenario(s) regressed or missing compared to the baseline = %s\n", numRegressed, baselineFile.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -11,17 +11,29 @@
  *   into an `InputParameters` object. (Note, these arguments provide
  *   configuration options).
  * - loading the `G4HepEm` data and parameters from file into a `G4HepEmState`
- *   (see the note below)
- * - constructing a `G4HepEmTLData` (also required by `G4HepEm` and encapsulates
- *   the random number generator and some track buffers) with its random number
- *   generator (utilising the local `URandom` generator)
+ *   (see the note below), by mapping its binary image (`HepEmStateImage`) that
+ *   is built next to the data file at the first use (or from the data file
+ *   embedded into the executable when built with `-DHepEmShow_EMBED_DATA=ON`)
  * - constructing and setting up the application `Geometry` according to the
  *   provided configuration input arguments (in `InputParameters`)
  * - constructing and setting up the `PrimaryGenerator` of the application according
  *   to the provided configuration input arguments (in `InputParameters`)
+ * - optionally pruning the `G4HepEmState` to the material-cuts couples used by
+ *   the `Geometry` and to the energy range of the primary (`HepEmStatePruner`)
+ * - optionally relayouting the tables of the `G4HepEmState` into one contiguous,
+ *   huge page backed arena (`HepEmStateArena`)
  * - constructing and setting up a `Results` structure that will be used to collect
  *   some data during the simulation
  * - the `EventLoop::ProcessEvents` method is invoked then to **perform the simulation**
+ *   by the required number of worker threads (processing different events or
+ *   sharing the tracks of each event in the sub-event parallel mode). Each
+ *   worker constructs its own `G4HepEmTLData` (also required by `G4HepEm` and
+ *   encapsulates the random number generator and some track buffers) with its
+ *   random number generator
+ *   (utilising the local `URandom` generator), while the `G4HepEmState`, the
+ *   `Geometry` and the `PrimaryGenerator` are shared by all workers (optionally,
+ *   the workers are pinned and use a replica of the `G4HepEmState` per NUMA
+ *   node, see `NumaPlacement`)
  * - the simulation results are witten to file (and to the standard output) by
  *   invoking `WriteResults()` (from the `Results`)
  *
@@ -42,16 +54,15 @@
 #include "G4HepEmParameters.hh"
 #include "G4HepEmMatCutData.hh"
 
-// - from G4HepEm/G4HepEmDataJsonIO: data IO (i.e. to load the pre-generated data)
-#include "G4HepEmDataJsonIO.hh"
-
-// - for plugging in our local (`URandom`) random number generator
-#include "G4HepEmTLData.hh"
-#include "G4HepEmRandomEngine.hh"
-#include "URandom.hh"
-
 // Local includes:
 #include "InputParameters.hh"
+#include "HepEmStateImage.hh"
+#include "HepEmStatePruner.hh"
+#include "HepEmStateArena.hh"
+#include "NumaPlacement.hh"
+#ifdef HEPEMSHOW_EMBED_DATA
+#include "EmbeddedData.hh"
+#endif
 #include "Geometry.hh"
 #include "PrimaryGenerator.hh"
 #include "Results.hh"
@@ -60,9 +71,9 @@
 
 // System includes:
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <string>
+#include <memory>
 
 #include "sys/time.h"
 #include <ctime>
@@ -79,21 +90,15 @@ int main(int argc, char* argv[]) {
 
   // `G4HepEmState` encapsulates G4HepEm (physics related) `data` and `parameters`
   // here we load the generated/delivered G4HepEm data from the file given as an input argument
-  std::ifstream jsonIS{ theInputParameters.fG4HepEmDataFile.c_str() };
-  G4HepEmState* theState = G4HepEmStateFromJson(jsonIS);
-
-
-  // `G4HepEmTLData` encapsulates "thread-local" (i.e. TL) data like:
-  // - the random number generator (will be constructed and set below)
-  // - the primary/secondary tracks used to provide/receive tracks to/from the
-  //   G4HepEm run-time functioinalities
-  G4HepEmTLData*  theTLData = new G4HepEmTLData();
-  // construct a HepEm random number generator, using our local uniform `URandom`
-  // generator, then set it to be used in the above TLdata
-  // NOTE: seed can be set as input argument
-  URandom*             theURnd         = new URandom(theInputParameters.fPrimaryAndEvents.fRandomSeed);
-  G4HepEmRandomEngine* theRandomEngine = new G4HepEmRandomEngine(theURnd);
-  theTLData->SetRandomEngine(theRandomEngine);
+  // (or from its binary image, built at the first use, that is mapped directly from the page cache)
+#ifdef HEPEMSHOW_EMBED_DATA
+  // NOTE: the data file embedded at build time is used (without any file I/O) unless one was given explicitly
+  G4HepEmState* theState = theInputParameters.fG4HepEmDataFile.empty()
+                           ? HepEmStateImage::LoadFromMemory(EmbeddedData::GetData(), EmbeddedData::GetSize(), EmbeddedData::GetFileName(), theInputParameters.fRunVerbosity)
+                           : HepEmStateImage::Load(theInputParameters.fG4HepEmDataFile, theInputParameters.fStateImage > 0, theInputParameters.fRunVerbosity);
+#else
+  G4HepEmState* theState = HepEmStateImage::Load(theInputParameters.fG4HepEmDataFile, theInputParameters.fStateImage > 0, theInputParameters.fRunVerbosity);
+#endif
 
 
   // `Geometry` describes the application geometry (i.e. the simplified sampling calorimeter)
@@ -104,6 +109,9 @@ int main(int argc, char* argv[]) {
   theGeometry.SetAbsThick(theInputParameters.fGeometry.fThicknessAbsorber);
   theGeometry.SetGapThick(theInputParameters.fGeometry.fThicknessGap);
   theGeometry.SetCaloSizeYZ(theInputParameters.fGeometry.fSizeTransverse);
+  theGeometry.SetUseBoundaryTable(theInputParameters.fGeometry.fBoundaryTable > 0);
+  theGeometry.SetExactCrossing(theInputParameters.fGeometry.fExactCrossing > 0);
+  theGeometry.SetReadoutCells(theInputParameters.fGeometry.fNumCellsY, theInputParameters.fGeometry.fNumCellsZ, theInputParameters.fGeometry.fReadoutAbsorber > 0);
 
 
   // `PrimaryGenerator` is used to produce primary particle/track when starting a new event
@@ -119,6 +127,16 @@ int main(int argc, char* argv[]) {
   thePrimaryGenerator.SetDirection(1.0, 0.0, 0.0);
 
 
+  // the `G4HepEm` state can be pruned to the material-cuts couples used by the geometry and to the energy
+  // range of the primary (a compact, per-run copy of the tables that shares the rest with the loaded state)
+  if (theInputParameters.fPruneData > 0) {
+    theState = HepEmStatePruner::Prune(*theState, theGeometry.GetMaterialIndices(), theInputParameters.fPrimaryAndEvents.fParticleEnergy, theInputParameters.fRunVerbosity);
+  }
+  // the tables of the (pruned) state can be relayouted into one contiguous arena (optionally huge page
+  // backed) to reduce the number of pages (i.e. TLB entries) touched by the physics
+  theState = HepEmStateArena::Relayout(theState, theInputParameters.fTableArena, theInputParameters.fRunVerbosity);
+
+
   // `Results` encapsulates the data that we record during the simulation
   // here we construct one and set the properties of its histograms (as thery are used
   // to collect data per-layer and the number of layer is configurable input argument)
@@ -126,20 +144,37 @@ int main(int argc, char* argv[]) {
   theResult.fEdepPerLayer.ReSet("hist_Edep_PerLayer", 0, theGeometry.GetNumLayers(), theGeometry.GetNumLayers());
   theResult.fGammaTrackLenghtPerLayer.ReSet("hist_GamTrackL_PerLayer", 0, theGeometry.GetNumLayers(), theGeometry.GetNumLayers());
   theResult.fElPosTrackLenghtPerLayer.ReSet("hist_ElPosTrackL_PerLayer", 0, theGeometry.GetNumLayers(), theGeometry.GetNumLayers());
+  // the flat per-cell accumulator is sized here (empty if no readout segmentation)
+  theResult.fEdepPerCell.assign(theGeometry.GetNumReadoutCellsTotal(), 0.0);
+  theResult.fNumCellsY           = theGeometry.GetNumCellsY();
+  theResult.fNumCellsZ           = theGeometry.GetNumCellsZ();
+  theResult.fIsAbsorberSegmented = theGeometry.GetIsAbsorberSegmented();
+  // the 3D scoring mesh over the calorimeter (not active if no voxels)
+  const double halfCaloYZ = 0.5*theGeometry.GetCaloSizeYZ();
+  const double meshMin[3] = { theGeometry.GetCaloStartXposition(), -halfCaloYZ, -halfCaloYZ };
+  const double meshMax[3] = { -theGeometry.GetCaloStartXposition(), halfCaloYZ,  halfCaloYZ };
+  theResult.fEdepMesh.ReSet("hist_Edep_Mesh.bin", theInputParameters.fMeshVoxels, meshMin, meshMax);
+  // exact, order independent accumulation of all run scope data if required
+  SetReproducible(theResult, theInputParameters.fReproducible > 0);
 
 
   // here we start the event processing: generate the required number of event and simulte each event.
-  EventLoop::ProcessEvents(*theTLData, *theState, thePrimaryGenerator, theGeometry, theResult, theInputParameters.fPrimaryAndEvents.fNumEvents, theInputParameters.fRunVerbosity);
+  // NOTE: each worker thread constructs its own `G4HepEmTLData` with its own `URandom` based random
+  //       engine (seed can be set as input argument), that is re-seeded at the beginning of each event
+  //       based on the event ID, while `theState` and `theGeometry` are shared
+  // NOTE: the workers can be pinned to CPUs (filling up one NUMA node after the other) each using the
+  //       replica of `theState` made for its NUMA node (see `NumaPlacement`)
+  std::unique_ptr<NumaPlacement> theNumaPlacement;
+  if (theInputParameters.fNumaPlacement > 0) {
+    theNumaPlacement.reset(new NumaPlacement(*theState, theInputParameters.fNumThreads, theInputParameters.fTableArena));
+  }
+  EventLoop::ProcessEvents(*theState, thePrimaryGenerator, theGeometry, theResult, theInputParameters.fPrimaryAndEvents.fNumEvents,
+                           theInputParameters.fPrimaryAndEvents.fFirstEventID, theInputParameters.fNumThreads, theInputParameters.fSubEventParallel > 0, theInputParameters.fBasketSize, theInputParameters.fPrimaryAndEvents.fRandomSeed, theInputParameters.fPrimaryAndEvents.fRandomEngine, theNumaPlacement.get(), theInputParameters.fRunVerbosity);
 
 
   // here we summarise the results and write them to file (the histograms) or to the screen
   WriteResults(theResult, theInputParameters.fPrimaryAndEvents.fNumEvents);
 
 
-  // delete objects
-  delete theRandomEngine;
-  delete theURnd;
-  delete theTLData;
-
   return 0;
 }
@@ -0,0 +1,40 @@
+#ifndef EMBEDDEDDATA_HH
+#define EMBEDDEDDATA_HH
+
+/**
+ * @file    EmbeddedData.hh
+ * @class   EmbeddedData
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief The `G4HepEm` data file embedded into the executable at build time (only with `-DHepEmShow_EMBED_DATA=ON`).
+ *
+ * The data file (either the JSON file or its binary image, see `HepEmStateImage`)
+ * given by the `HepEmShow_EMBED_DATA_FILE` CMake variable is linked into the
+ * read-only data of the `HepEmShow` executable (by the assembler `.incbin` in
+ * the `EmbeddedData.cc` generated from `Simulation/src/EmbeddedData.cc.in`).
+ * So the `G4HepEmState` can be built directly from the memory, without any
+ * file I/O at start up (see `HepEmStateImage::LoadFromMemory()`), and the
+ * data pages are shared by all processes running the same executable.
+ *
+ * @note The `.incbin` section directives are for ELF (e.g. Linux) targets.
+ */
+
+#include <cstddef>
+
+class EmbeddedData {
+
+public:
+
+  /** Start of the embedded data file (64 bytes aligned).*/
+  static const char* GetData();
+
+  /** Size of the embedded data file in [bytes].*/
+  static std::size_t GetSize();
+
+  /** Name of the data file that was embedded at build time (only for reporting).*/
+  static const char* GetFileName();
+
+};
+
+#endif // EMBEDDEDDATA_HH
@@ -15,6 +15,9 @@
  */
 
 
+#include <atomic>
+#include <vector>
+
 class G4HepEmTLData;
 class G4HepEmState;
 class G4HepEmTrack;
@@ -22,6 +25,10 @@ class G4HepEmTrack;
 class PrimaryGenerator;
 class Geometry;
 class Results;
+class TrackStack;
+class TrackBasket;
+class NumaPlacement;
+struct SubEventTeam;
 
 class EventLoop {
 
@@ -39,19 +46,106 @@ public:
    * In order to be able to collect some infomation during the event processing, the `BeginOfEventAction()`/`EndOfEventAction()` methods are invoked before/after each event processing
    * while the `BeginOfTrackingAction()`/`EndOfTrackingAction()` methods are invoked before/after tracking each new track.
    *
-   * @param theTLData a `G4HepEm` specific (thread local) object primarily used to obtain all physics related information from `G4HepEm` needed to compute a simulation step
+   * The events are processed by `numThreads` workers (the calling thread is the first of them). The read-only `G4HepEmState`, `PrimaryGenerator` and
+   * `Geometry` are shared by all workers, while each worker has its own `G4HepEmTLData` (with its own `URandom` based random engine), `TrackStack` and
+   * `Results` (all allocated by the worker itself). Workers take the next event to simulate from a common event counter and the `Results` of the workers are reduced into `theResult` at the end (by a parallel tree reduction done by the workers).
+   *
+   * The random number generator of the worker is re-seeded at the beginning of each event with a seed derived from the (run) `randomSeed` and the
+   * event ID (see `URandom::SetSeed()`). Therefore, the simulation of a given event is independent from the number of workers, from the order in
+   * which the events are processed and from the way the events are split across jobs (by using the `firstEventID`).
+   *
+   * When `theNumaPlacement` is given, each worker is pinned to a CPU first and uses the replica of the `G4HepEmState` that was made for its NUMA
+   * node (while all its own data are allocated, i.e. first touched, after the pinning) so the workers read the tables from their local memory.
+   *
+   * When `isSubEventParallel` is set (and more than one worker is used), the workers process the events one after the other, all of them working on
+   * the same event by sharing its tracks: each worker has its own `TrackStack` that is used as a work-stealing deque, i.e. the worker simulates the
+   * tracks from its own stack (including the secondaries it produces) and steals the oldest track from the stack of an other worker when its own became
+   * empty. The event is completed when all the tracks of the event are finished by the workers, the data collected by the individual workers during the
+   * event are then merged before invoking the `EndOfEventAction()`. This mode helps to use many workers even when only a few (but high energy) events
+   * are simulated. Note, that the results of a given event depend on the scheduling of its tracks in this mode (i.e. not reproducible).
+   *
+   * When `basketSize` is positive, the tracks are simulated by the basket based stepping engine (see `BasketStepper`) instead of the history based
+   * `SteppingLoop`: each worker keeps a basket of in-flight \f$\gamma\f$ and \f$e^-/e^+\f$ tracks (filled from its `TrackStack`) and simulates one step
+   * with all tracks of the baskets at once till both the stack and the baskets become empty (see `SimulateTracksInBaskets()`). This is available
+   * only when the workers process different events (i.e. not in the sub-event parallel mode).
+   *
    * @param theState a `G4HepEm` specific object that stores pointers to the top level `G4HepEm` data structure and parameters that are used by `G4HepEm` to provide all physics related infomation needed to compute a simulation step
    * @param thePrimaryGenerator the primary generator that is used to generate primary track(s) at the beginning of each event (only one primary track per event in our case now)
    * @param theGeometry the geometry of the application in which the input track history is simulated
    * @param theResult the data structure that holds all the infomation needs to be collected during the simulation.
    * @param numEventToSimulate number of events required to be simulated
+   * @param firstEventID ID of the first event (the IDs of the simulated events are `[firstEventID, firstEventID+numEventToSimulate)`)
+   * @param numThreads number of worker threads used to simulate the events
+   * @param isSubEventParallel the workers share the tracks of each event instead of processing different events (see above)
+   * @param basketSize number of tracks per basket in the basket based stepping engine (history based stepping when < 1)
+   * @param randomSeed seed of the random number generator(s)
+   * @param randomEngine the engine of the random number generator(s) (see `URandom::EngineType`)
+   * @param theNumaPlacement the workers are pinned and use the state replica of their NUMA node if given (see `NumaPlacement`), nothing if `nullptr`
    * @param verbosity to control the verbosity of printouts reporting progress and state of the event processing
    */
-  static void ProcessEvents(G4HepEmTLData& theTLData, G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, Results& theResult, int numEventToSimulate, int verbosity);
+  static void ProcessEvents(G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, Results& theResult, int numEventToSimulate, int firstEventID, int numThreads, bool isSubEventParallel, int basketSize, int randomSeed, int randomEngine, NumaPlacement* theNumaPlacement, int verbosity);
 
 private:
   EventLoop() = delete;
 
+  /** The event loop of one worker: takes the next event from `theEventCounter` and simulates it till all the required events are taken.
+   *
+   * @param theState the shared `G4HepEm` state (data and parameters)
+   * @param thePrimaryGenerator the shared primary generator
+   * @param theGeometry the shared geometry
+   * @param theResult the data structure of this worker in which the infomation is collected during the simulation
+   * @param theEventCounter the event counter shared by all workers that provides the index of the next event to simulate
+   * @param numEventToSimulate number of events required to be simulated (by all workers)
+   * @param firstEventID ID of the first event (the ID of an event is its index plus `firstEventID`)
+   * @param basketSize number of tracks per basket in the basket based stepping engine (history based stepping when < 1)
+   * @param randomSeed seed of the random number generator(s)
+   * @param randomEngine the engine of the random number generator(s) (see `URandom::EngineType`)
+   * @param reportProgress report progress after each `reportProgress` events (nothing when < 1)
+   */
+  static void Worker(G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, Results& theResult, std::atomic<int>& theEventCounter, int numEventToSimulate, int firstEventID, int basketSize, int randomSeed, int randomEngine, int reportProgress);
+
+  /** The event loop of one worker in the sub-event parallel mode: all workers of `theTeam` simulate the tracks of the same event then move to the next.
+   *
+   * @param threadID index of the worker (0 for the calling thread, that generates the primary track and invokes the event actions)
+   * @param theTeam the data shared by the workers (track stacks, results, the counter of the pending tracks and the barrier to synchronise at events)
+   * @param theState the shared `G4HepEm` state (data and parameters)
+   * @param thePrimaryGenerator the shared primary generator
+   * @param theGeometry the shared geometry
+   * @param numEventToSimulate number of events required to be simulated
+   * @param firstEventID ID of the first event (the ID of an event is its index plus `firstEventID`)
+   * @param randomSeed seed of the random number generator(s)
+   * @param randomEngine the engine of the random number generator(s) (see `URandom::EngineType`)
+   * @param reportProgress report progress, with an intermediate snapshot of the results (see `ReportSnapshot()`), after each `reportProgress` events (nothing when < 1)
+   */
+  static void SubEventWorker(int threadID, SubEventTeam& theTeam, G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, int numEventToSimulate, int firstEventID, int randomSeed, int randomEngine, int reportProgress);
+
+  /** Reports an intermediate snapshot of the results (the mean energy deposits) collected by the workers so far.
+   *
+   * The replicas of the workers are reduced into a snapshot (see `ReduceResults()`) without changing them, so this can be
+   * invoked only while they are not updated, i.e. by the first worker at the end of an event in the sub-event parallel mode.
+   *
+   * @param theResults the results of the workers
+   * @param numEvents  number of events completed so far
+   */
+  static void ReportSnapshot(const std::vector<Results*>& theResults, int numEvents);
+
+  /** Simulates one event: the primary track(s) and all their secondaries (see `ProcessEvents()` above).
+   *
+   * The basket based stepping engine is used when the baskets are given (`nullptr` otherwise).*/
+  static void ProcessEvent(G4HepEmTLData& theTLData, G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, TrackStack& theTrackStack, TrackBasket* theGammaBasket, TrackBasket* theElectronBasket, Results& theResult, int eventID);
+
+  /** Simulates all tracks of the stack (including their secondaries) by the basket based stepping engine.
+   *
+   * The baskets are filled with tracks from the stack then one step is simulated with all tracks of the baskets (see `BasketStepper`),
+   * the tracks with terminated history are removed from the baskets and these are repeated till both the stack and the baskets become empty.*/
+  static void SimulateTracksInBaskets(G4HepEmState& theState, Geometry& theGeometry, TrackStack& theTrackStack, TrackBasket& theGammaBasket, TrackBasket& theElectronBasket, Results& theResult, int eventID);
+
+  /** Prepares the primary track of `theTLData`, that belongs to the given track type, for a new track and returns its address.*/
+  static G4HepEmTrack* PrepareTrack(G4HepEmTLData& theTLData, int trackType);
+
+  /** Simulates the entire history of the given track (that is already in `theTLData`, see `PrepareTrack()`) by invoking the appropriate stepper.*/
+  static void SimulateTrack(G4HepEmTLData& theTLData, G4HepEmState& theState, Geometry& theGeometry, TrackStack& theTrackStack, Results& theResult, G4HepEmTrack& theTrack, int trackType, int eventID);
+
   /** Method invoked at the beginning of each event by passing the (single) primary track of the event.*/
   static void BeginOfEventAction(Results& theResult, int eventID, const G4HepEmTrack& thePrimaryTrack);
   /** Method invoked at the end of each event.*/
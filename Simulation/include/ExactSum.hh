@@ -0,0 +1,58 @@
+#ifndef EXACTSUM_HH
+#define EXACTSUM_HH
+
+/**
+ * @file    ExactSum.hh
+ * @struct  ExactSum
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Exact, order independent (fixed-point) accumulator of double values.
+ *
+ * Floating point additions are not associative: the sum of the same values
+ * depends (in its last bits) on the order of the additions, i.e. on the number
+ * of threads and on the dynamic scheduling of the events between them.
+ *
+ * Each value is rounded here to the nearest integer multiple of the resolution
+ * \f$ 2^{-32} \f$ (i.e. \f$ \sim 2.3 \times 10^{-10} \f$ in the units of the value)
+ * and these integers are summed exactly in a 128 bit integer. The integer sum,
+ * hence its (correctly rounded) double value, is independent of the order of
+ * the additions so the merged results are bit-by-bit identical regardless the
+ * number of threads. The range (\f$ \sim 4 \times 10^{28} \f$) is far above any
+ * sum that can appear in the application (e.g. energy deposits in [MeV]).
+ *
+ * @note The 128 bit integer type is a GCC/Clang extension (available on all
+ * 64 bit targets of these compilers).
+ */
+
+#include <cmath>
+#include <cstdint>
+
+struct ExactSum {
+  /** The inverse of the resolution (multiplication by a power of 2 is exact).*/
+  static constexpr double kScale = 4294967296.0;
+
+  __int128 fValue { 0 };  ///< the sum in units of the resolution
+
+  /** Adds a value (rounded to the nearest multiple of the resolution).*/
+  void Add(double x) {
+    const double y = std::nearbyint(x*kScale);
+    // NOTE: the (much cheaper) 64 bit conversion is used whenever possible
+    if (std::abs(y) < 9.0E+18) {
+      fValue += static_cast<int64_t>(y);
+    } else {
+      fValue += static_cast<__int128>(y);
+    }
+  }
+
+  /** Adds an other sum (exact).*/
+  void Add(const ExactSum& other) { fValue += other.fValue; }
+
+  /** The sum (the nearest double).*/
+  double GetValue() const { return static_cast<double>(fValue)/kScale; }
+
+  /** The sum in extended precision (used in the derived quantities, e.g. the variance).*/
+  long double GetLongValue() const { return static_cast<long double>(fValue)/kScale; }
+};
+
+#endif // EXACTSUM_HH
@@ -124,8 +124,62 @@
  * of the boundary between volume A and B. Then, the point is calulated to be in
  * volume B now when relocating and as the direction is pointing inside volume B,
  * the expected distance to the next boundary of volume B is computed.
+ *
+ * The geometry can also be set to use a **boundary table** based locator instead
+ * (by `SetUseBoundaryTable(true)`). The translations of all `layer`s along the `x`
+ * axis (i.e. the positions of all `absorber`/`gap` boundaries together with their
+ * half thicknesses) are pre-computed in `UpdateParameters()` whenever the geometry
+ * changes. The `layer` is then found by a single multiplication, the `absorber` or
+ * `gap` by a single comparison and the distance to the next boundary plane and to
+ * the transverse walls are computed at once (i.e. without going through the `Box`
+ * objects of the `calorimeter`, `layer` and `absorber` or `gap`). This locator is
+ * also direction aware: a point that is on the `surface` of an `absorber`/`gap`
+ * boundary, while moving through that boundary, is located directly in the volume
+ * on the other side so the zero distance (and the consequent small push in the
+ * steppers) is not needed. Otherwise, it gives exactly the same volume, indices,
+ * local coordinates and distance to out as the default, `Box` based location.
+ *
+ * Tracks that have already been located do not need to be located again from
+ * scratch at each step. The `NavigationState`, carried with each track, stores
+ * the result of the last location that is used in
+ * `CalculateDistanceToOut(const double*, double*, NavigationState&)` to transform
+ * the point directly into the local system of the current volume (if the previous
+ * step ended inside) or of the neighbouring volume (if the previous step ended on
+ * the boundary and the track is moving through). This gives exactly the same
+ * as the full location in the first case and the same as the (direction aware)
+ * boundary table based location in the second.
+ *
+ * This **exact boundary crossing** mode is used by default (can be switched off
+ * by `SetExactCrossing(false)`): the steppers learn the volume entered on a
+ * boundary crossing from the crossing itself so the zero distance, the small push
+ * and the consequent extra relocation are not needed. This includes the very first
+ * location of a track: when the full location gives zero distance (the point is on
+ * the boundary of the located volume while moving out), the point is located
+ * directly in the volume on the other side by the direction aware locator. When
+ * the mode is switched off, the full location is done at each step (with the small
+ * push in the steppers whenever the distance is zero) as described above. The number
+ * of such zero distance steps is recorded in the `Results` in both cases.
+ *
+ * The `gap` (and optionally the `absorber`) can be segmented transversely into
+ * a grid of `N x M` **readout cells** along the `y` and `z` axes (by
+ * `SetReadoutCells(int, int, bool)`). The index of the cell, in which the point
+ * is located, is computed by the same
+ * `CalculateDistanceToOut(const double*, double*, NavigationState&)` call (from
+ * the local `yz` position by two multiplications, i.e. without any extra pass
+ * over the geometry) and stored in the `NavigationState` as a global index
+ * \f$ ((s\times N) + i_y)\times M + i_z \f$ where \f$ s \f$ is the index of
+ * the segmented volume i.e. the `layer` index if only the `gap` is segmented
+ * (\f$ 2 \times \f$ `layer` index + 0/1 for `absorber`/`gap` otherwise). This
+ * index can be used directly in a flat, per-cell accumulator with the size of
+ * `GetNumReadoutCellsTotal()`, set up before the simulation.
  */
 
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "NavigationState.hh"
+
 // forward
 class Box;
 
@@ -238,6 +292,16 @@ public:
     */
   double GetCaloStartXposition() const { return fCaloStartX; }
 
+  /** Provides the indices of the materials used by the volumes of the geometry.
+    *
+    * These are the `world`, `calorimeter`, `layer`, `absorber` and the `gap` (only at
+    * non-zero thickness) materials (without duplicates) that are also the `Geant4`
+    * material-cuts couple indices (see the note in the description).
+    *
+    * @return the sorted indices of the used materials.
+    */
+  std::vector<int> GetMaterialIndices() const;
+
 
   /**
     * Locates a point in the geometry and calculates the distance till the next boundary.
@@ -309,7 +373,85 @@ public:
     *         calculated to be located. It might be zero (the step actually shouldn't be done in the located volume) or 1E+20 [mm] (the particle
     *         about leaving the `calorimeter`).
     */
-  double CalculateDistanceToOut(double* r, double *v, Box** currentVolume, int* indxLayer, int* indxAbs);
+  double CalculateDistanceToOut(double* r, double *v, Box** currentVolume, int* indxLayer, int* indxAbs) {
+    return fUseBoundaryTable
+           ? CalculateDistanceToOutByTable(r, v, currentVolume, indxLayer, indxAbs)
+           : CalculateDistanceToOutByBoxes(r, v, currentVolume, indxLayer, indxAbs);
+  }
+
+  /** The default, `Box` based location and distance to out computation (see `CalculateDistanceToOut()`).*/
+  double CalculateDistanceToOutByBoxes(double* r, double *v, Box** currentVolume, int* indxLayer, int* indxAbs);
+
+  /** The boundary table based, direction aware location and distance to out computation (see the description and `CalculateDistanceToOut()`).
+    *
+    * Gives the same as `CalculateDistanceToOutByBoxes()` except when the point is on the `surface` of an `absorber`/`gap` boundary
+    * while moving through that boundary: the point is located directly in the volume on the other side (instead of returning zero).
+    */
+  double CalculateDistanceToOutByTable(double* r, double *v, Box** currentVolume, int* indxLayer, int* indxAbs);
+
+  /** Locates a point by using (and updating) the navigation state of the track and calculates the distance till the next boundary.
+    *
+    * A full location is done (by `CalculateDistanceToOut(double*, double*, Box**, int*, int*)`) if the track has not been located
+    * yet. Otherwise, the point is transformed directly to the local system of the volume given by the navigation state or to
+    * that of its neighbour when the point is on the boundary of that volume while moving through (see the description).
+    *
+    * @param[in]     r global position of the point (pre-step point)
+    * @param[in]     v normalised direction
+    * @param[in,out] theNavState the navigation state of the track: the result of the previous location at input, updated at output
+    *                (the local position is set to the position of the point in the local system of the volume in which it was located)
+    * @return the distance, from the given position along the given direction, to the boundary of the volume in which the given point was
+    *         located or 1E+20 [mm] (the particle about leaving the `calorimeter`).
+    */
+  double CalculateDistanceToOut(const double* r, double* v, NavigationState& theNavState);
+
+  /** Batch version of the above that also computes the pre-step point safeties (used by the `BasketStepper`).
+    *
+    * The points (with directions) are given in structure-of-arrays form with their navigation states. The tracks that have
+    * already been located are relocated, and their distance to out and safety are computed, in the loop without any further
+    * function calls while the full location (as above) is used for the others. Gives the same (bit-by-bit) as calling the
+    * above for each point followed by `Box::DistanceToOut(double*)` with the local position in the located volume.
+    *
+    * @param[in]     rx, ry, rz   global positions of the points
+    * @param[in]     vx, vy, vz   normalised directions
+    * @param[in,out] theNavStates navigation states of the tracks (see above)
+    * @param[out]    dist         distances to out (1E+20 [mm] for the points about leaving the `calorimeter`)
+    * @param[out]    safety       safeties in the located volumes (zero for the points about leaving the `calorimeter`)
+    * @param[in]     num          number of points
+    */
+  void   CalculateDistanceToOut(const double* rx, const double* ry, const double* rz, const double* vx, const double* vy, const double* vz, NavigationState* theNavStates, double* dist, double* safety, int num);
+
+  /** Sets the exact boundary crossing mode to be used in `CalculateDistanceToOut(const double*, double*, NavigationState&)` (see the description).*/
+  void   SetExactCrossing(bool val) { fExactCrossing = val;  }
+  /** Indicates if the exact boundary crossing mode is used.*/
+  bool   GetExactCrossing() const   { return fExactCrossing; }
+
+  /** Sets the transverse readout segmentation of the `gap` (and optionally the `absorber`) into cells (see the description).
+    *
+    * @param[in] numCellsY number of readout cells along the `y`-axis (no segmentation if < 1)
+    * @param[in] numCellsZ number of readout cells along the `z`-axis (no segmentation if < 1)
+    * @param[in] isAbsorberSegmented the `absorber` is also segmented if true (only the `gap` otherwise)
+    */
+  void   SetReadoutCells(int numCellsY, int numCellsZ, bool isAbsorberSegmented) {
+    fNumCellsY            = numCellsY;
+    fNumCellsZ            = numCellsZ;
+    fIsAbsorberSegmented  = isAbsorberSegmented;
+    UpdateParameters();
+  }
+  /** Number of readout cells along the `y`-axis in a segmented volume (0 if no segmentation).*/
+  int    GetNumCellsY() const { return fIsSegmented ? fNumCellsY : 0; }
+  /** Number of readout cells along the `z`-axis in a segmented volume (0 if no segmentation).*/
+  int    GetNumCellsZ() const { return fIsSegmented ? fNumCellsZ : 0; }
+  /** Indicates if the `absorber` is also segmented into readout cells.*/
+  bool   GetIsAbsorberSegmented() const { return fIsSegmented && fIsAbsorberSegmented; }
+  /** Total number of readout cells in the `calorimeter` (0 if no segmentation), i.e. the required size of a flat per-cell accumulator.*/
+  int    GetNumReadoutCellsTotal() const {
+    return fIsSegmented ? (fIsAbsorberSegmented ? 2 : 1)*fNumLayers*fNumCellsY*fNumCellsZ : 0;
+  }
+
+  /** Sets the boundary table based locator to be used in `CalculateDistanceToOut()` (the `Box` based is used otherwise).*/
+  void   SetUseBoundaryTable(bool val) { fUseBoundaryTable = val;  }
+  /** Indicates if the boundary table based locator is used in `CalculateDistanceToOut()`.*/
+  bool   GetUseBoundaryTable() const   { return fUseBoundaryTable; }
 
 
 
@@ -319,6 +461,50 @@ private:
   /** Privite method that clculates the apropriate positions and volume/shape sizes whever any related parameters is updated.*/
   void   UpdateParameters();
 
+  /** Locates the point by using the navigation state and computes the distance to out (without the readout cell index).*/
+  double LocateAndDistanceToOut(const double* r, double* v, NavigationState& theNavState);
+
+  /** Sets the global index of the readout cell in the navigation state (-1 if not in a segmented volume).*/
+  void   SetReadoutCell(NavigationState& theNavState) const {
+    theNavState.fIndxCell = -1;
+    const int iAbs = theNavState.fIndxAbs;
+    if (!fIsSegmented || iAbs < 0 || (iAbs == 0 && !fIsAbsorberSegmented)) {
+      return;
+    }
+    const double* r  = theNavState.fLocalPosition;
+    const int     iy = std::min(std::max(int( (r[1] + 0.5*fCaloSizeYZ)*fInvCellSizeY ), 0), fNumCellsY-1);
+    const int     iz = std::min(std::max(int( (r[2] + 0.5*fCaloSizeYZ)*fInvCellSizeZ ), 0), fNumCellsZ-1);
+    const int     is = fIsAbsorberSegmented ? 2*theNavState.fIndxLayer + iAbs : theNavState.fIndxLayer;
+    theNavState.fIndxCell = (is*fNumCellsY + iy)*fNumCellsZ + iz;
+  }
+
+  /** Transforms the point into the local system of the given `absorber`/`gap` volume (or to that of the next volume if on its
+    * boundary while moving through) and computes the distance to out (1E+20 [mm] if leaving the `calorimeter` through a layer).*/
+  double DistanceToOutInVolume(double* r, const double* v, int iLayer, int iAbs, Box** currentVolume, int* indxLayer, int* indxAbs);
+
+  /** Transforms the point as above without computing the distance to out (false if leaving the `calorimeter` through a layer).*/
+  bool   RelocateInVolume(double* r, const double* v, int iLayer, int iAbs, Box** currentVolume, int* indxLayer, int* indxAbs);
+
+  /** Distance to the next `x`-plane or to the transverse walls from the given local point of an `absorber`/`gap` volume (as in `Box::DistanceToOut`).*/
+  double DistanceToOutLocal(const double* r, const double* v, double halfX) const {
+    const double halfCaloYZ = 0.5*fCaloSizeYZ;
+    const double vx  = v[0];
+    const double tx  = (vx == 0) ? 1.0E+20 : (std::copysign(halfX, vx) - r[0])/vx;
+    const double vy  = v[1];
+    const double ty  = (vy == 0) ? tx : (std::copysign(halfCaloYZ, vy) - r[1])/vy;
+    const double txy = std::min(tx, ty);
+    const double vz  = v[2];
+    const double tz  = (vz == 0) ? txy : (std::copysign(halfCaloYZ, vz) - r[2])/vz;
+    return std::min(txy, tz);
+  }
+
+  /** Indicates if the point is on the transverse walls of the `calorimeter` (shared by all volumes) while moving out.*/
+  bool   IsLeavingThroughWalls(const double* r, const double* v) const {
+    const double halfCaloYZ = 0.5*fCaloSizeYZ;
+    return ((std::abs(r[1]) - halfCaloYZ) >= -fHalfTolerance && r[1]*v[1] > 0)
+        || ((std::abs(r[2]) - halfCaloYZ) >= -fHalfTolerance && r[2]*v[2] > 0);
+  }
+
 
 // data members
 private:
@@ -359,6 +545,38 @@ private:
   double fPrimaryXPosition;
 
 
+  /** Indicates if the boundary table based locator should be used (the `Box` based otherwise).*/
+  bool   fUseBoundaryTable;
+
+  /** Indicates if the navigation state is used to cross the boundaries exactly (full relocation at each step otherwise).*/
+  bool   fExactCrossing;
+
+  /** Number of transverse readout cells along the `y` and `z` axes (in each segmented volume) and the corresponding inverse cell sizes.*/
+  int    fNumCellsY;
+  int    fNumCellsZ;
+  double fInvCellSizeY;
+  double fInvCellSizeZ;
+
+  /** Indicates if the `absorber` is also segmented and if any segmentation is active (i.e. both number of cells are positive).*/
+  bool   fIsAbsorberSegmented;
+  bool   fIsSegmented;
+
+  /** Inverse of the `layer` thickness (for computing the `layer` index by a multiplication).*/
+  double fInvLayerThick;
+
+  /** Half of the tolerance, i.e. thickness of the `surface` on each side of the boundaries.*/
+  double fHalfTolerance;
+
+  /** The translations of the `absorber` (0) and `gap` (1) inside the `layer` along the `x`-axis.
+    * Computed automatically (whenever the related parameters are updated) */
+  double fInLayerCenterX[2];
+
+  /** The boundary table, i.e. the translations of all `layer`s along the `x`-axis (the `layer` boundaries
+    * are at half `layer` thickness from these on both sides).
+    * Computed automatically (whenever the related parameters are updated) */
+  std::vector<double> fLayerCenterX;
+
+
   // pointers to box shape objects representing each elements of the geometry
   /** Pointer to the `Box` shape representing the `world` volume.*/
   Box*   fBoxWorld;
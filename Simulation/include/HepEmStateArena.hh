@@ -0,0 +1,70 @@
+#ifndef HEPEMSTATEARENA_HH
+#define HEPEMSTATEARENA_HH
+
+/**
+ * @file    HepEmStateArena.hh
+ * @class   HepEmStateArena
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Relayouts the `G4HepEm` state into one contiguous, optionally huge page backed arena.
+ *
+ * The tables of a `G4HepEm` state loaded from the JSON file are scattered over
+ * the heap (hundreds of separate allocations) while the physics of each step
+ * touches several of them (energy loss, macroscopic cross sections, element
+ * selectors, Seltzer-Berger tables, etc.). `Relayout()` copies all the data
+ * structures and tables of the state into one, 2 MB aligned arena (using the
+ * same layout as the payload of the binary image, see `HepEmStateImage`, with
+ * each array 64 bytes aligned) and resolves the pointers in place. The arena can
+ * be backed by:
+ * - ordinary pages (`kArena`)
+ * - transparent huge pages (`kTransparentHugePages`): the arena is advised
+ *   (`madvise(MADV_HUGEPAGE)`) so the kernel can use huge pages when the system
+ *   allows it (i.e. `always` or `madvise` in `/sys/kernel/mm/transparent_hugepage/enabled`)
+ * - explicit huge pages (`kExplicitHugePages`): the arena is allocated from the
+ *   pre-reserved huge page pool (`MAP_HUGETLB`, see `/proc/sys/vm/nr_hugepages`)
+ *   falling back to transparent huge pages when the pool is empty.
+ *
+ * The tables of a typical run (a few hundreds of kB) then fit into a single huge
+ * page, i.e. they are covered by a single TLB entry. The number of (4 kB and
+ * 2 MB) pages spanned by the tables before and after the relayout is reported.
+ *
+ * @note The arena is kept until the end of the job: the relayouted state must
+ * not be freed by `FreeG4HepEmData` (the original state is not changed).
+ */
+
+#include <cstddef>
+
+struct G4HepEmState;
+
+class HepEmStateArena {
+
+public:
+
+  /** The possible backings of the arena (the values of the `--table-arena` input argument).*/
+  enum Backing {
+    kNone                 = 0, ///< no relayout
+    kArena                = 1, ///< contiguous arena with ordinary pages
+    kTransparentHugePages = 2, ///< contiguous arena advised for transparent huge pages
+    kExplicitHugePages    = 3  ///< contiguous arena from the explicit huge page pool (transparent if not available)
+  };
+
+  /** Size of a huge page (the alignment of the arena) in [bytes].*/
+  static constexpr std::size_t kHugePageSize = 2*1024*1024;
+
+  /** Gives a copy of the state relayouted into one contiguous arena with the given backing (see the description).
+    *
+    * @param state     the `G4HepEm` state to relayout (not changed)
+    * @param backing   the backing of the arena (see `Backing`), the state itself is given back when `kNone`
+    * @param verbosity the size, backing and pages of the arena are reported when > 0
+    */
+  static G4HepEmState* Relayout(G4HepEmState* state, int backing, int verbosity);
+
+private:
+
+  /** Allocates a 2 MB aligned arena of (at least) the given size with the required backing and gives back the obtained one.*/
+  static char* Allocate(std::size_t& size, int& backing);
+
+};
+
+#endif // HEPEMSTATEARENA_HH
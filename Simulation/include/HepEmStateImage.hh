@@ -0,0 +1,132 @@
+#ifndef HEPEMSTATEIMAGE_HH
+#define HEPEMSTATEIMAGE_HH
+
+/**
+ * @file    HepEmStateImage.hh
+ * @class   HepEmStateImage
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief A binary, memory mappable image of the `G4HepEm` state (data and parameters) to cut the start up time.
+ *
+ * Parsing the `G4HepEm` JSON data file (i.e. converting MBs of text to doubles
+ * and allocating the tables) dominates the start up of short jobs. The image
+ * keeps the very same data in its native, binary form so it can be used after
+ * mapping the file and copying a few, small data structures.
+ *
+ * The image file (`GetImageFileName()`, i.e. next to the JSON file) is built
+ * from the JSON file at the first use and it's mapped (read-only) by the later
+ * jobs. Its layout:
+ * - a fixed, 64 bytes header (see `HepEmStateImage::Header`) with a magic, the
+ *   format version, the signature of the layout of the `G4HepEm` data structures
+ *   the image was written with, the size and modification time of the JSON file
+ *   the image was built from and the size and checksum of the payload
+ * - the payload: the `G4HepEm` data structures and all their arrays (each 64 bytes
+ *   aligned) with each pointer replaced by the `offset + 1` of the pointed data
+ *   in the payload (0 for null pointers).
+ *
+ * When loading the image, only the data structures are copied to the heap (with
+ * their pointers resolved) while all the tables are used directly from the
+ * read-only, shared mapping, i.e. from the page cache that is shared by all the
+ * jobs (processes) on the node that use the same image.
+ *
+ * An image that cannot be validated (written by a different format version or
+ * for different `G4HepEm` data structures, built from an other or modified JSON
+ * file or corrupted) is ignored and rebuilt. The image is written into a temporary
+ * file that is renamed at the end so concurrent jobs never see a partial image.
+ * If the image cannot be written (e.g. read-only data directory), the state is
+ * simply loaded from the JSON file at each job.
+ *
+ * The state can also be loaded from a data file (either JSON or image) that is
+ * in the memory (see `LoadFromMemory()`), e.g. when the data file is embedded into
+ * the executable at build time (see `EmbeddedData`). An image is then used in
+ * place (it must be 64 bytes aligned in the memory).
+ *
+ * @note The state obtained from an image must not be freed by `FreeG4HepEmData`
+ * since its tables are in the mapping (that is kept until the end of the job).
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct G4HepEmState;
+
+class HepEmStateImage {
+
+public:
+
+  /** The header of the binary image file (64 bytes, the payload starts right after).*/
+  struct Header {
+    char     fMagic[8];     ///< the `HEPEMIMG` magic
+    uint32_t fVersion;      ///< version of the format (1)
+    uint32_t fHeaderSize;   ///< size of this header (64)
+    uint64_t fLayout;       ///< signature of the layout of the `G4HepEm` data structures (see `GetLayoutSignature()`)
+    uint64_t fSourceSize;   ///< size of the JSON file the image was built from in [bytes]
+    int64_t  fSourceMTime;  ///< modification time of the JSON file the image was built from in [ns] since the epoch
+    uint64_t fPayloadSize;  ///< size of the payload in [bytes]
+    uint64_t fStateOffset;  ///< offset of the `G4HepEmState` in the payload
+    uint64_t fChecksum;     ///< checksum of the payload (see `Checksum()`)
+  };
+  static_assert(sizeof(Header) == 64, "HepEmStateImage::Header must be 64 bytes");
+
+  /** Loads the `G4HepEm` state from the image of the given JSON file (if required and valid) or from the JSON file.
+    *
+    * The image is built from the JSON file if it was required but it's not there or not valid.
+    * Errors and exits if the state cannot be loaded from the JSON file.
+    *
+    * @param jsonFileName name of the `G4HepEm` JSON data file (with path)
+    * @param useImage     the image is used (built if needed) when true, only the JSON file otherwise
+    * @param verbosity    the source, load time and page faults of loading the state are reported when > 0
+    */
+  static G4HepEmState* Load(const std::string& jsonFileName, bool useImage, int verbosity);
+
+  /** Loads the `G4HepEm` state from a data file that is in the memory: an image (used in place) or JSON (parsed).
+    *
+    * Errors and exits if the state cannot be loaded (e.g. not valid image).
+    *
+    * @param data      start of the data file in the memory (64 bytes aligned if it's an image)
+    * @param size      size of the data file in [bytes]
+    * @param name      name of the data file (only for reporting)
+    * @param verbosity the source, load time and page faults of loading the state are reported when > 0
+    */
+  static G4HepEmState* LoadFromMemory(const char* data, std::size_t size, const std::string& name, int verbosity);
+
+  /** Name of the image of the given JSON data file (its `.json` extension replaced by `.bin`).*/
+  static std::string GetImageFileName(const std::string& jsonFileName);
+
+  /** Maps the image of the given JSON file and gives the state (nullptr if the image is not there or not valid).*/
+  static G4HepEmState* MapImage(const std::string& jsonFileName);
+
+  /** Indicates if the given image (header plus payload) is valid, i.e. format, layout, size and checksum (the source is not checked).*/
+  static bool IsValidImage(const char* image, std::size_t imageSize);
+
+  /** Writes the image of the given state that was loaded from the given JSON file (false if cannot be written).*/
+  static bool WriteImage(const G4HepEmState& state, const std::string& jsonFileName);
+
+  /** Appends the given state into the payload and gives back its offset (the pointers encoded as described above).*/
+  static uint64_t Serialise(const G4HepEmState& state, std::vector<char>& payload);
+
+  /** Gives the state stored at the given offset of the (64 bytes aligned) payload: the data structures are copied, the tables used in place.*/
+  static G4HepEmState* Deserialise(const char* payload, uint64_t stateOffset);
+
+  /** Gives the state stored at the given offset of the (64 bytes aligned, writable) payload with all its pointers resolved in place (nothing is copied).*/
+  static G4HepEmState* Relocate(char* payload, uint64_t stateOffset);
+
+  /** Number of distinct, `pageSize` bytes pages the data structures and tables of the given state span.*/
+  static std::size_t GetNumPages(const G4HepEmState& state, std::size_t pageSize);
+
+  /** A 64 bit, word-wise FNV-1a checksum of the given data.*/
+  static uint64_t Checksum(const char* data, std::size_t size);
+
+  /** A signature of the layout (sizes) of the `G4HepEm` data structures stored in the image.*/
+  static uint64_t GetLayoutSignature();
+
+private:
+
+  /** Resolves the pointers of the state stored at the given offset of the payload (in place or on copies of the data structures).*/
+  static G4HepEmState* ResolveState(char* payload, uint64_t stateOffset, bool inPlace);
+
+};
+
+#endif // HEPEMSTATEIMAGE_HH
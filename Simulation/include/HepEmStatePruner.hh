@@ -0,0 +1,66 @@
+#ifndef HEPEMSTATEPRUNER_HH
+#define HEPEMSTATEPRUNER_HH
+
+/**
+ * @file    HepEmStatePruner.hh
+ * @class   HepEmStatePruner
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Prunes the `G4HepEm` state to the material-cuts couples and energy range used by the run.
+ *
+ * The `G4HepEm` data file contains tables for all the material-cuts couples
+ * (of the `Geant4` geometry it was generated for) over the full energy range
+ * of the tables (up to 100 TeV). A run uses only the couples of the materials
+ * of its `Geometry` and energies below the primary energy. `Prune()` makes a
+ * compact, per-run copy of the state:
+ * - the couples that are not used by the geometry are dropped: the per-couple
+ *   tables of the e-/e+ (energy loss, restricted macroscopic cross sections and
+ *   element selectors) and the Seltzer-Berger bremsstrahlung (gamma cut indices)
+ *   are compacted, the `Geant4` to `G4HepEm` couple index map gives `-1` for
+ *   the dropped couples
+ * - the tables on energy grids (energy loss, restricted and first transport
+ *   macroscopic cross sections of e-/e+ and the conversion and Compton
+ *   macroscopic cross sections of gamma) are truncated above the maximum
+ *   kinetic energy that can occur in the run (primary energy plus the rest
+ *   mass of an e-/e+ pair for the annihilation in flight) times a safety
+ *   factor (see `kSafetyFactor`), keeping the lower part of the grids
+ *   (the interpolations use the same `log` grid parameters).
+ *
+ * The material, element, Seltzer-Berger table data and the parameters are not
+ * copied, they are shared with the original state (so it must be kept).
+ *
+ * @note The pruning follows the layouts of the `G4HepEm` tables: interleaved
+ * `(value, second derivative)` pairs on the energy grids, the restricted
+ * macroscopic cross sections as `[N, E_max, xsec_max, log(E_min), 1/log-delta]`
+ * headers followed by `N` `(E, xsec, second derivative)` triplets for ionisation
+ * then bremsstrahlung. A couple whose restricted macroscopic cross section
+ * data doesn't have the above (self describing) size is copied without truncation.
+ */
+
+#include <vector>
+
+struct G4HepEmState;
+
+class HepEmStatePruner {
+
+public:
+
+  /** Factor applied to the maximum kinetic energy of the run to get the upper limit of the truncated tables.*/
+  static constexpr double kSafetyFactor = 2.0;
+
+  /** Gives a compact, per-run copy of the state (see the description).
+    *
+    * @param state          the original `G4HepEm` state (shares some data with the pruned one)
+    * @param g4MatCutIndices the `Geant4` material-cuts couple indices used by the geometry
+    * @param primaryEnergy  the primary kinetic energy in [MeV]
+    * @param verbosity      the memory of the tables before and after the pruning is reported when > 0
+    */
+  static G4HepEmState* Prune(const G4HepEmState& state, const std::vector<int>& g4MatCutIndices, double primaryEnergy, int verbosity);
+
+  /** Number of points of the `log` grid (with the given parameters) that needs to be kept to cover the kinetic energies up to `maxEkin`.*/
+  static int GetNumGridPoints(int numPoints, double logMinEkin, double invLogDelta, double maxEkin);
+
+};
+
+#endif // HEPEMSTATEPRUNER_HH
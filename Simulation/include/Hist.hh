@@ -10,11 +10,52 @@
  * @date    July 2023
  *
  * @brief A simple histogram only to collect some data during the simulation.
+ *
+ * Each worker thread fills its own replica of the histograms (i.e. its own copy
+ * of the `Results`) without any locks or atomics. The bin contents are stored in
+ * cache line aligned memory, padded to full cache lines, so the replicas of the
+ * different threads never share a cache line (no false sharing). The replicas
+ * are combined by a parallel tree reduction at the end of the run (see `Add()`
+ * and `ReduceResultsStep()`) and, in the sub-event parallel mode, also at the
+ * progress reports for intermediate snapshots (see `ReduceResults()`).
+ *
+ * The bin contents can also be accumulated exactly (see `SetExact()` and `ExactSum`)
+ * which makes them independent of the order of the fills and the merges, i.e.
+ * bit-by-bit reproducible regardless the number of threads.
  */
 
 
 #include <vector>
 #include <string>
+#include <cstdlib>
+#include <new>
+
+#include "ExactSum.hh"
+
+/** Size of the cache line in bytes (used to align and pad the per-thread data).*/
+constexpr std::size_t kCacheLineSize = 64;
+
+/** Minimal allocator that gives cache line aligned memory, padded to full cache lines (used for the per-thread replicas).*/
+template <typename T>
+struct CacheLineAllocator {
+  using value_type = T;
+  CacheLineAllocator() = default;
+  template <typename U>
+  CacheLineAllocator(const CacheLineAllocator<U>&) {}
+  T* allocate(std::size_t n) {
+    const std::size_t bytes = ((n*sizeof(T) + kCacheLineSize - 1)/kCacheLineSize)*kCacheLineSize;
+    void* p = std::aligned_alloc(kCacheLineSize, bytes);
+    if (p == nullptr) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T*>(p);
+  }
+  void deallocate(T* p, std::size_t) { std::free(p); }
+  template <typename U>
+  bool operator==(const CacheLineAllocator<U>&) const { return true;  }
+  template <typename U>
+  bool operator!=(const CacheLineAllocator<U>&) const { return false; }
+};
 
 class Hist {
 
@@ -56,6 +97,16 @@ public:
     */
   void ReSet(const std::string& filename, double min, double max, int numbins);
 
+  /** Sets the histogram to accumulate the bin contents exactly (see `ExactSum`) or by plain doubles (default).
+    *
+    * The bin contents are reset. In the exact mode, `GetY()` gives the exact sums only after `Scale()`
+    * (that converts them to doubles) so that needs to be invoked before writing (e.g. by 1).
+    *
+    * @param isExact Indicates if the exact accumulation is required.
+    */
+  void SetExact(bool isExact);
+  bool IsExact() const { return fIsExact; }
+
   /** Method to populate the histogram with data: the corresponding bin content is increased by 1.
     *
     * @param x Value to add.
@@ -84,7 +135,7 @@ public:
   double  GetMax()     const { return fMax;     }
   double  GetSum()     const { return fSum;     }
   const std::vector<double>& GetX() const { return fx; }
-  const std::vector<double>& GetY() const { return fy; }
+  const std::vector<double, CacheLineAllocator<double> >& GetY() const { return fy; }
 
   // write result to file without (default) or after normalising
   void WriteToFile(bool isNorm=false);
@@ -99,13 +150,16 @@ public:
 private:
   std::string         fFileName;
   std::vector<double> fx;
-  std::vector<double> fy;
+  std::vector<double, CacheLineAllocator<double> > fy;
+  std::vector<ExactSum, CacheLineAllocator<ExactSum> > fyExact;
+  ExactSum            fSumExact;
   double              fMin;
   double              fMax;
   double              fDelta;
   double              fInvDelta;
   double              fSum;
   int                 fNumBins;
+  bool                fIsExact;
 };
 
 #endif
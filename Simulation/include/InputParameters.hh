@@ -12,16 +12,28 @@
  */
 
 #include <iostream>
+#include <cstdio>
 
 // NOTE: this is Unix specific!
 #include <getopt.h>
 
+#include "ScoringMesh.hh"
+
+
+// NOTE: the data file embedded at build time (see `EmbeddedData`) is used unless one is given explicitly
+#ifdef HEPEMSHOW_EMBED_DATA
+static const char* kDefaultG4HepEmDataFile = "";
+#else
+static const char* kDefaultG4HepEmDataFile = "../data/hepem_data";
+#endif
+
 
 struct InputParameters {
 
   /** CTR with default values: default geometry, primary and event configuirations (see below) with
-    * pre-generated data files expected at `../data/hepem_data` relative to the `HepEmShow` executable.*/
-  InputParameters() : fG4HepEmDataFile("../data/hepem_data"), fRunVerbosity(1) {}
+    * pre-generated data files expected at `../data/hepem_data` relative to the `HepEmShow` executable
+    * (or embedded into the executable when built with `-DHepEmShow_EMBED_DATA=ON`).*/
+  InputParameters() : fG4HepEmDataFile(kDefaultG4HepEmDataFile), fStateImage(1), fPruneData(0), fTableArena(0), fNumThreads(1), fSubEventParallel(0), fNumaPlacement(0), fBasketSize(0), fMeshVoxels{0, 0, 0}, fReproducible(0), fRunVerbosity(1) {}
 
 
   /** The geometry related input arguments.*/
@@ -32,13 +44,23 @@ struct InputParameters {
       fThicknessAbsorber(2.3),
       fThicknessGap(5.7),
       fThicknessCalo(0),
-      fSizeTransverse(400.0) {}
+      fSizeTransverse(400.0),
+      fBoundaryTable(0),
+      fExactCrossing(1),
+      fNumCellsY(0),
+      fNumCellsZ(0),
+      fReadoutAbsorber(0) {}
 
     int    fNumLayers;         ///< number of layers in the calorimeter
     double fThicknessAbsorber; ///< absorber thickness along X in [mm]
     double fThicknessGap;      ///< gap thickness along X in [mm]
     double fThicknessCalo;     ///< calorimeter thickness along X [mm] ONLY if number of layers is zero
     double fSizeTransverse;    ///< calorimeter full size along YZ in [mm]
+    int    fBoundaryTable;     ///< the boundary table based (direction aware) locator is used if > 0
+    int    fExactCrossing;     ///< boundaries are crossed exactly, using the navigation state of the tracks, if > 0 (small push otherwise)
+    int    fNumCellsY;         ///< number of transverse readout cells along Y (no readout segmentation if < 1)
+    int    fNumCellsZ;         ///< number of transverse readout cells along Z (no readout segmentation if < 1)
+    int    fReadoutAbsorber;   ///< the absorber is also segmented into readout cells if > 0 (only the gap otherwise)
   };
 
 
@@ -49,18 +71,31 @@ struct InputParameters {
     : fParticleName("e-"),
       fParticleEnergy(10000.0),
       fNumEvents(1000),
-      fRandomSeed(1234) {}
+      fFirstEventID(0),
+      fRandomSeed(1234),
+      fRandomEngine(0) {}
 
     std::string  fParticleName;   ///< primary particle name: {"e-", "e+" or "gamma"}
     double       fParticleEnergy; ///< primary particle energy in [MeV]
     int          fNumEvents;      ///< number of events to simulate (each will start with a single primary)
+    int          fFirstEventID;   ///< ID of the first event (events can be split across jobs)
     double       fRandomSeed;     ///< seed for the random number generator
+    int          fRandomEngine;   ///< engine of the random number generator: 0 for `mt19937_64` and 1 for `Philox4x32-10`
   };
 
   // all members
   Geometry         fGeometry;         ///< the geometry related configuration
   PrimaryAndEvents fPrimaryAndEvents; ///< the primary partcile and events related configuration
-  std::string      fG4HepEmDataFile;  ///< the pre-generated data file (with path)
+  std::string      fG4HepEmDataFile;  ///< the pre-generated data file (with path): the embedded one if empty
+  int              fStateImage;       ///< the `G4HepEm` state is loaded from (built into) its binary image next to the data file when > 0
+  int              fPruneData;        ///< the `G4HepEm` state is pruned to the couples and energy range used by the run when > 0
+  int              fTableArena;       ///< the `G4HepEm` tables are relayouted into a contiguous arena when > 0: 1 ordinary, 2 transparent, 3 explicit huge pages
+  int              fNumThreads;       ///< number of worker threads used for the event processing
+  int              fSubEventParallel; ///< the workers share the tracks of each event (instead of processing different events) when > 0
+  int              fNumaPlacement;    ///< the workers are pinned and use a replica of the `G4HepEm` state per NUMA node when > 0
+  int              fBasketSize;       ///< number of tracks per basket in the basket based stepping (history based stepping when 0)
+  int              fMeshVoxels[3];    ///< number of voxels of the 3D scoring mesh along X, Y and Z (no mesh when 0)
+  int              fReproducible;     ///< exact, order independent (bit-by-bit reproducible) accumulation of the results when > 0
   int              fRunVerbosity;     ///< level of printout verbosity duing setting up: nothing when < 1.
 };
 
@@ -73,15 +108,31 @@ void PrintParameters (const struct InputParameters& theParam) {
   std::cout << "         - absorber-thickness    : "     << theParam.fGeometry.fThicknessAbsorber << " [mm]" << std::endl;
   std::cout << "         - gap-thickness         : "     << theParam.fGeometry.fThicknessGap      << " [mm]" << std::endl;
   std::cout << "         - transverse-size       : "     << theParam.fGeometry.fSizeTransverse    << " [mm]" << std::endl;
+  std::cout << "         - boundary-table        : "     << theParam.fGeometry.fBoundaryTable     << std::endl;
+  std::cout << "         - exact-crossing        : "     << theParam.fGeometry.fExactCrossing     << std::endl;
+  std::cout << "         - readout-cells-y       : "     << theParam.fGeometry.fNumCellsY         << std::endl;
+  std::cout << "         - readout-cells-z       : "     << theParam.fGeometry.fNumCellsZ         << std::endl;
+  std::cout << "         - readout-absorber      : "     << theParam.fGeometry.fReadoutAbsorber   << std::endl;
 
   std::cout << "     --- Primary and Event configuration: " << std::endl;
   std::cout << "         - primary-particle      : "     << theParam.fPrimaryAndEvents.fParticleName   << std::endl;
   std::cout << "         - primary-energy        : "     << theParam.fPrimaryAndEvents.fParticleEnergy << " [MeV]" << std::endl;
   std::cout << "         - number-of-events      : "     << theParam.fPrimaryAndEvents.fNumEvents      <<  std::endl;
+  std::cout << "         - first-event-id        : "     << theParam.fPrimaryAndEvents.fFirstEventID   <<  std::endl;
   std::cout << "         - random-seed           : "     << theParam.fPrimaryAndEvents.fRandomSeed     <<  std::endl;
+  std::cout << "         - random-engine         : "     << theParam.fPrimaryAndEvents.fRandomEngine   <<  std::endl;
 
   std::cout << "     --- Additional configuration: " << std::endl;
-  std::cout << "         - g4hepem-data-file    : "     << theParam.fG4HepEmDataFile  << std::endl;
+  std::cout << "         - g4hepem-data-file    : "     << (theParam.fG4HepEmDataFile.empty() ? "(embedded)" : theParam.fG4HepEmDataFile) << std::endl;
+  std::cout << "         - state-image          : "     << theParam.fStateImage       << std::endl;
+  std::cout << "         - prune-data           : "     << theParam.fPruneData        << std::endl;
+  std::cout << "         - table-arena          : "     << theParam.fTableArena       << std::endl;
+  std::cout << "         - threads              : "     << theParam.fNumThreads       << std::endl;
+  std::cout << "         - sub-event-parallel   : "     << theParam.fSubEventParallel << std::endl;
+  std::cout << "         - numa-placement       : "     << theParam.fNumaPlacement    << std::endl;
+  std::cout << "         - basket-size          : "     << theParam.fBasketSize       << std::endl;
+  std::cout << "         - mesh-voxels          : "     << theParam.fMeshVoxels[0] << "," << theParam.fMeshVoxels[1] << "," << theParam.fMeshVoxels[2] << std::endl;
+  std::cout << "         - reproducible         : "     << theParam.fReproducible     << std::endl;
   std::cout << "         - run-verbosity        : "     << theParam.fRunVerbosity     << std::endl;
 
 }
@@ -94,13 +145,29 @@ static struct option options[] = {
   {"absorber-thickness    (in [mm] units)                                 - default: 2.3"    , required_argument, 0, 'a'},
   {"gap-thickness         (in [mm] units)                                 - default: 5.7"    , required_argument, 0, 'g'},
   {"transverse-size       (of the calorimeter in [mm] units)              - default: 400"    , required_argument, 0, 't'},
+  {"boundary-table        (boundary table based locator if 1)             - default: 0"      , required_argument, 0, 'u'},
+  {"exact-crossing        (no push and relocation at boundaries if 1)     - default: 1"      , required_argument, 0, 'x'},
+  {"readout-cells-y       (number of gap readout cells along Y if > 0)    - default: 0"      , required_argument, 0, 'y'},
+  {"readout-cells-z       (number of gap readout cells along Z if > 0)    - default: 0"      , required_argument, 0, 'z'},
+  {"readout-absorber      (absorber is also segmented into cells if 1)    - default: 0"      , required_argument, 0, 'r'},
 
   {"primary-particle      (possible particle names: e-, e+ and gamma)     - default: e-"     , required_argument, 0, 'p'},
   {"primary-energy        (in [MeV] units)                                - default: 10 000" , required_argument, 0, 'e'},
   {"number-of-events      (number of primary events to simulate)          - default: 1000"   , required_argument, 0, 'n'},
+  {"first-event-id        (events are split across jobs by this)          - default: 0"      , required_argument, 0, 'f'},
   {"random-seed                                                           - default: 1234"   , required_argument, 0, 's'},
+  {"random-engine         (0: mt19937_64, 1: Philox4x32-10 counter based) - default: 0"      , required_argument, 0, 'k'},
 
   {"g4hepem-data-file     (the pre-generated data file with its path)     - default: ../data/hepem_data" , required_argument, 0, 'd'},
+  {"state-image           (binary image of the data file is used if 1)    - default: 1"      , required_argument, 0, 'i'},
+  {"prune-data            (only the used couples and energy range if 1)   - default: 0"      , required_argument, 0, 'o'},
+  {"table-arena           (contiguous tables: 1 4kB, 2 THP, 3 huge pages) - default: 0"      , required_argument, 0, 'q'},
+  {"threads               (number of worker threads for the event loop)   - default: 1"      , required_argument, 0, 'j'},
+  {"sub-event-parallel    (workers share the tracks of each event if 1)   - default: 0"      , required_argument, 0, 'w'},
+  {"numa-placement        (pinned workers, state replica per NUMA node)   - default: 0"      , required_argument, 0, 'N'},
+  {"basket-size           (basket based stepping if > 0: tracks/basket)   - default: 0"      , required_argument, 0, 'b'},
+  {"mesh-voxels           (3D scoring mesh if > 0: NX,NY,NZ or N voxels)  - default: 0"      , required_argument, 0, 'm'},
+  {"reproducible          (exact, thread independent accumulation if 1)   - default: 0"      , required_argument, 0, 'c'},
   {"run-verbosity         (verbosity of run information: nothing when 0)  - default: 1"      , required_argument, 0, 'v'},
   {"help"                                                                                    , no_argument      , 0, 'h'},
   {0, 0, 0, 0}
@@ -119,7 +186,7 @@ void Help() {
 void GetOpt(int argc, char *argv[], InputParameters& param) {
   while (true) {
     int c, optidx = 0;
-    c = getopt_long(argc, argv, "hl:a:g:t:p:e:n:s:d:v:", options, &optidx);
+    c = getopt_long(argc, argv, "hl:a:g:t:u:x:y:z:r:p:e:n:f:s:k:d:i:o:q:j:w:N:b:m:c:v:", options, &optidx);
     if (c == -1)
       break;
     switch (c) {
@@ -139,6 +206,21 @@ void GetOpt(int argc, char *argv[], InputParameters& param) {
     case 't':
        param.fGeometry.fSizeTransverse = std::stod(optarg);
        break;
+    case 'u':
+       param.fGeometry.fBoundaryTable = std::stoi(optarg);
+       break;
+    case 'x':
+       param.fGeometry.fExactCrossing = std::stoi(optarg);
+       break;
+    case 'y':
+       param.fGeometry.fNumCellsY = std::stoi(optarg);
+       break;
+    case 'z':
+       param.fGeometry.fNumCellsZ = std::stoi(optarg);
+       break;
+    case 'r':
+       param.fGeometry.fReadoutAbsorber = std::stoi(optarg);
+       break;
 
     case 'p':
        param.fPrimaryAndEvents.fParticleName = optarg;
@@ -154,13 +236,65 @@ void GetOpt(int argc, char *argv[], InputParameters& param) {
     case 'n':
        param.fPrimaryAndEvents.fNumEvents = std::stoi(optarg);
        break;
+    case 'f':
+       param.fPrimaryAndEvents.fFirstEventID = std::stoi(optarg);
+       break;
     case 's':
        param.fPrimaryAndEvents.fRandomSeed = std::stod(optarg);
        break;
+    case 'k':
+       param.fPrimaryAndEvents.fRandomEngine = std::stoi(optarg);
+       if (param.fPrimaryAndEvents.fRandomEngine < 0 || param.fPrimaryAndEvents.fRandomEngine > 1) {
+         std::cout << "\n *** Unknown random engine -k: " << optarg << std::endl;
+         Help();
+         exit(-1);
+       }
+       break;
 
     case 'd':
        param.fG4HepEmDataFile = optarg;
        break;
+    case 'i':
+       param.fStateImage = std::stoi(optarg);
+       break;
+    case 'o':
+       param.fPruneData = std::stoi(optarg);
+       break;
+    case 'q':
+       param.fTableArena = std::stoi(optarg);
+       break;
+    case 'j':
+       param.fNumThreads = std::stoi(optarg);
+       break;
+    case 'w':
+       param.fSubEventParallel = std::stoi(optarg);
+       break;
+    case 'N':
+       param.fNumaPlacement = std::stoi(optarg);
+       break;
+    case 'b':
+       param.fBasketSize = std::stoi(optarg);
+       break;
+    case 'm': {
+       // either `NX,NY,NZ` or a single `N` for all
+       const int numRead = sscanf(optarg, "%d,%d,%d", &param.fMeshVoxels[0], &param.fMeshVoxels[1], &param.fMeshVoxels[2]);
+       if (numRead == 1) {
+         param.fMeshVoxels[1] = param.fMeshVoxels[2] = param.fMeshVoxels[0];
+       } else if (numRead != 3) {
+         std::cout << "\n *** Wrong scoring mesh voxels -m: " << optarg << std::endl;
+         Help();
+         exit(-1);
+       }
+       if (ScoringMesh::GetNumVoxelsTotal(param.fMeshVoxels) > ScoringMesh::kMaxNumVoxels) {
+         std::cout << "\n *** Too many scoring mesh voxels -m: " << optarg << " (at most " << ScoringMesh::kMaxNumVoxels << " in total)" << std::endl;
+         Help();
+         exit(-1);
+       }
+       break;
+     }
+    case 'c':
+       param.fReproducible = std::stoi(optarg);
+       break;
     case 'v':
        param.fRunVerbosity = std::stoi(optarg);
        break;
@@ -182,8 +316,20 @@ void GetOpt(int argc, char *argv[], InputParameters& param) {
      Help();
      exit(-1);
    }
+   // number of threads must be >= 1
+   if (param.fNumThreads < 1 ) {
+     printf("\n *** Number of threads must be >= 1! \n");
+     Help();
+     exit(-1);
+   }
+   // the basket based stepping is not available in the sub-event parallel mode
+   if (param.fBasketSize > 0 && param.fSubEventParallel > 0 && param.fNumThreads > 1) {
+     printf("\n *** Basket based stepping cannot be used in the sub-event parallel mode! \n");
+     Help();
+     exit(-1);
+   }
    // check if the data file was given with/without extension
-   if (param.fG4HepEmDataFile.find(".json")==std::string::npos) {
+   if (!param.fG4HepEmDataFile.empty() && param.fG4HepEmDataFile.find(".json")==std::string::npos) {
      param.fG4HepEmDataFile += ".json";
    }
    // print parameters if the verbosity > 0
@@ -0,0 +1,172 @@
+#ifndef MOMENTS_HH
+#define MOMENTS_HH
+
+/**
+ * @file    Moments.hh
+ * @struct  Moments
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Numerically robust accumulator of the mean and variance of a quantity over the events.
+ *
+ * Accumulating the sum and the sum of the squares of a quantity, then computing
+ * the variance as \f$ \langle x^2 \rangle - \langle x \rangle^2 \f$ loses most of
+ * the significant digits when the mean is large compared to the standard deviation
+ * or over very large number of events (rounding of the sums grows with the number
+ * of additions while the two terms cancel).
+ *
+ * The Welford update is used instead: the running mean and the sum of the squared
+ * deviations from the mean (\f$ M_2 \f$) are updated by each new value as
+ * \f[
+ *   \delta = x - \bar{x}_{n-1}, \quad
+ *   \bar{x}_n = \bar{x}_{n-1} + \delta/n, \quad
+ *   M_{2,n} = M_{2,n-1} + \delta (x - \bar{x}_n)
+ * \f]
+ * that never subtracts two large, nearly equal numbers. Two accumulators (e.g. of
+ * different threads or jobs) are combined by the pairwise formula of Chan et al.
+ * \f[
+ *   \delta = \bar{x}_B - \bar{x}_A, \quad
+ *   \bar{x} = \bar{x}_A + \delta\, n_B/n, \quad
+ *   M_2 = M_{2,A} + M_{2,B} + \delta^2 n_A n_B/n
+ * \f]
+ * which gives the same (up to rounding) as if all values were added to a single
+ * accumulator. The number of values is an integer so it's always exact.
+ *
+ * The result of the above still depends (in its last bits) on the order of the
+ * additions and merges. In the exact mode (see `SetExact()`), the sum of the
+ * values and their squares are accumulated exactly instead (see `ExactSum`) so
+ * the mean and variance, computed from these in extended precision, are bit-by-bit
+ * reproducible regardless the order (i.e. the number of threads).
+ *
+ * The raw state of an accumulator can be written into (and read back from) a line
+ * of a text file by `Write()` (and `Read()`) without any loss: the number of values,
+ * the mean and \f$ M_2 \f$ (with 17 significant digits) or, in the exact mode, the
+ * number of values and the two exact sums (as 128 bit hexadecimal integers). This is
+ * used to combine the results of independent jobs the same way (see `HepEmShow-combine`).
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+
+#include "ExactSum.hh"
+
+struct Moments {
+  int64_t fN    { 0 };    ///< number of values added so far
+  double  fMean { 0.0 };  ///< the running mean
+  double  fM2   { 0.0 };  ///< the running sum of the squared deviations from the mean
+  //
+  bool     fIsExact { false }; ///< exact, order independent accumulation (the Welford members are not used then)
+  ExactSum fSum;               ///< the exact sum of the values (only in the exact mode)
+  ExactSum fSum2;              ///< the exact sum of the squared values (only in the exact mode)
+
+  /** Sets the exact (order independent) accumulation mode (should be set before any value is added).*/
+  void SetExact(bool isExact) { *this = Moments(); fIsExact = isExact; }
+
+  /** Adds a new value (Welford update).*/
+  void Add(double x) {
+    ++fN;
+    if (fIsExact) {
+      fSum.Add(x);
+      fSum2.Add(x*x);
+      return;
+    }
+    const double delta = x - fMean;
+    fMean += delta/fN;
+    fM2   += delta*(x - fMean);
+  }
+
+  /** Adds the values accumulated in an other one (pairwise combination).*/
+  void Merge(const Moments& other) {
+    if (fIsExact) {
+      fN += other.fN;
+      fSum.Add(other.fSum);
+      fSum2.Add(other.fSum2);
+      return;
+    }
+    if (other.fN == 0) {
+      return;
+    }
+    if (fN == 0) {
+      *this = other;
+      return;
+    }
+    const double nA    = static_cast<double>(fN);
+    const double nB    = static_cast<double>(other.fN);
+    const double n     = nA + nB;
+    const double delta = other.fMean - fMean;
+    fMean += delta*(nB/n);
+    fM2   += other.fM2 + delta*delta*(nA*nB/n);
+    fN    += other.fN;
+  }
+
+  /** The mean of the values.*/
+  double GetMean() const {
+    if (fIsExact) {
+      return fN > 0 ? static_cast<double>(fSum.GetLongValue()/fN) : 0.0;
+    }
+    return fMean;
+  }
+  /** The (population) variance of the values.*/
+  double GetVariance() const {
+    if (fN == 0) {
+      return 0.0;
+    }
+    if (fIsExact) {
+      const long double mean = fSum.GetLongValue()/fN;
+      const long double var  = fSum2.GetLongValue()/fN - mean*mean;
+      return var > 0.0L ? static_cast<double>(var) : 0.0;
+    }
+    return fM2/fN;
+  }
+  /** The (population) standard deviation of the values.*/
+  double GetStdDev() const { return std::sqrt(GetVariance()); }
+
+  /** Writes the raw state into one line of the file: `name W N mean M2` or, in the exact mode, `name X N sum sum2`.*/
+  void Write(FILE* f, const char* name) const {
+    if (fIsExact) {
+      fprintf(f, "%s\tX\t%lld\t", name, static_cast<long long>(fN));
+      WriteHex(f, fSum);
+      fprintf(f, "\t");
+      WriteHex(f, fSum2);
+      fprintf(f, "\n");
+    } else {
+      fprintf(f, "%s\tW\t%lld\t%.17g\t%.17g\n", name, static_cast<long long>(fN), fMean, fM2);
+    }
+  }
+
+  /** Reads the raw state from the next line of the file written by `Write()` (the name, at most 63 characters, is returned in `name`).
+    *
+    * @return false if there is no more line or the line cannot be interpreted.
+    */
+  bool Read(FILE* f, char* name) {
+    char mode = 0;
+    long long num = 0;
+    if (fscanf(f, "%63s %c %lld", name, &mode, &num) != 3) {
+      return false;
+    }
+    SetExact(mode == 'X');
+    fN = static_cast<int64_t>(num);
+    if (fIsExact) {
+      return ReadHex(f, fSum) && ReadHex(f, fSum2);
+    }
+    return mode == 'W' && fscanf(f, "%lf %lf", &fMean, &fM2) == 2;
+  }
+
+private:
+  // the 128 bit exact sums are written (and read) as two 64 bit hexadecimal halves
+  static void WriteHex(FILE* f, const ExactSum& sum) {
+    const unsigned __int128 val = static_cast<unsigned __int128>(sum.fValue);
+    fprintf(f, "%016llx%016llx", static_cast<unsigned long long>(val >> 64), static_cast<unsigned long long>(val));
+  }
+  static bool ReadHex(FILE* f, ExactSum& sum) {
+    unsigned long long hi = 0, lo = 0;
+    if (fscanf(f, " %16llx%16llx", &hi, &lo) != 2) {
+      return false;
+    }
+    sum.fValue = static_cast<__int128>((static_cast<unsigned __int128>(hi) << 64) | lo);
+    return true;
+  }
+};
+
+#endif // MOMENTS_HH
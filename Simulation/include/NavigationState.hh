@@ -0,0 +1,50 @@
+#ifndef NAVIGATIONSTATE_HH
+#define NAVIGATIONSTATE_HH
+
+/**
+ * @file    NavigationState.hh
+ * @struct  NavigationState
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief The result of the last location of a track in the `Geometry`.
+ *
+ * A navigation state is carried with each track while its history is simulated
+ * (in the `SteppingLoop` or in the `TrackBasket` of the `BasketStepper`). It is
+ * re-set (i.e. not located) at the beginning of the history and it is updated
+ * at each pre-step point by `Geometry::CalculateDistanceToOut(const double*, double*, NavigationState&)`.
+ * This uses the state to skip the full location of the point whenever the track
+ * has already been located:
+ * - the point is transformed directly to the local system of the current volume
+ *   if the previous step ended inside the volume (e.g. on a physics interaction)
+ * - the point is transformed directly to the local system of the neighbouring
+ *   volume if the previous step ended on the boundary of the current volume (and
+ *   the track is moving through that boundary)
+ */
+
+class Box;
+
+struct NavigationState {
+  /** CTR: not located state.*/
+  NavigationState() { ReSet(); }
+
+  /** Re-sets the state to be not located (the next location will be a full one).*/
+  void ReSet() {
+    fVolume    = nullptr;
+    fIndxLayer = -1;
+    fIndxAbs   = -1;
+    fIndxCell  = -1;
+    fLocalPosition[0] = fLocalPosition[1] = fLocalPosition[2] = 0.0;
+  }
+
+  /** Indicates if the track has already been located inside the `calorimeter`.*/
+  bool IsLocated() const { return fIndxLayer > -1; }
+
+  Box*   fVolume;            ///< the volume in which the track was located (`nullptr` if not located yet)
+  int    fIndxLayer;         ///< index of the `layer` in which the track was located (-1 if not located or not in the `calorimeter`)
+  int    fIndxAbs;           ///< 0/1 if the track was located in the `absorber`/`gap` (-1 if not located or not in the `calorimeter`)
+  int    fIndxCell;          ///< global index of the readout cell in which the track was located (-1 if not in a segmented volume)
+  double fLocalPosition[3];  ///< the position of the track in the local system of the volume at the last location
+};
+
+#endif // NAVIGATIONSTATE_HH
@@ -0,0 +1,110 @@
+#ifndef NUMAPLACEMENT_HH
+#define NUMAPLACEMENT_HH
+
+/**
+ * @file    NumaPlacement.hh
+ * @class   NumaPlacement
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief NUMA aware placement of the workers: thread pinning and per-node replicas of the read-only `G4HepEm` state.
+ *
+ * On multi-socket nodes, a single `G4HepEmState` is in the memory of one of the
+ * NUMA nodes so the workers running on the other node(s) would read all the
+ * tables through the interconnect. When the placement is used by the `EventLoop`:
+ * - each worker pins itself to one CPU (see `SetUpWorker()`): the CPUs, the process
+ *   is allowed to run on, are ordered by their NUMA node so the workers fill up
+ *   the CPUs of one node before moving to the next one (i.e. the first socket
+ *   before the second)
+ * - the first worker that arrives to a given NUMA node makes the replica of the
+ *   state for that node: a copy of the state in one contiguous arena (see
+ *   `HepEmStateArena`) that is allocated and first touched by the pinned worker,
+ *   i.e. it's placed into the local memory of the node (first-touch policy)
+ * - all data of the worker (`G4HepEmTLData`, `TrackStack` and `Results`) are
+ *   also allocated (first touched) by the pinned worker
+ * - the original affinity of a worker is restored by `TearDownWorker()`: the
+ *   first worker is the thread that calls `EventLoop::ProcessEvents`, it gets
+ *   back its original affinity at the end of the event loop (so the rest of the
+ *   job is not confined to the single CPU it was pinned to).
+ *
+ * The NUMA topology is read from `/sys/devices/system/node/` (a single node with
+ * all the allowed CPUs is assumed if not available). Memory-only nodes (without
+ * CPUs) are skipped: the nodes with CPUs are indexed consecutively internally but
+ * the kernel NUMA node ID is kept for each of them. `Report()` shows the CPU and
+ * node (kernel ID) used by each worker and the node of the state replica it used.
+ *
+ * @note The replicas are kept till the end of the job (see `HepEmStateArena`).
+ */
+
+#include <mutex>
+#include <memory>
+#include <vector>
+
+// NOTE: this is Linux specific!
+#include <sched.h>
+
+struct G4HepEmState;
+
+class NumaPlacement {
+
+public:
+
+  /** CTR: reads the NUMA topology and the CPUs allowed for the process.
+    *
+    * @param theState   the (read-only) `G4HepEm` state that is replicated per NUMA node
+    * @param numThreads number of workers that are placed
+    * @param backing    backing of the state replicas (see `HepEmStateArena::Backing`, contiguous arena at least)
+    */
+  NumaPlacement(G4HepEmState& theState, int numThreads, int backing);
+
+  /** Pins the calling worker to its CPU and gives the replica of the state for its NUMA node (made by the first worker of the node).*/
+  G4HepEmState& SetUpWorker(int threadID);
+
+  /** Restores the affinity the calling worker had before it was pinned by `SetUpWorker()`.*/
+  void TearDownWorker(int threadID);
+
+  /** Number of NUMA nodes.*/
+  int GetNumNodes() const { return static_cast<int>(fReplicas.size()); }
+
+  /** Reports the CPU and NUMA node used by each worker (and where the workers actually were at the end).*/
+  void Report() const;
+
+private:
+
+  /** The CPUs of a NUMA node with its kernel ID (as read from the `sysfs`).*/
+  struct NodeCPUs {
+    int              fNodeID; ///< kernel ID of the node (i.e. `N` of `nodeN` in the `sysfs`)
+    std::vector<int> fCPUs;   ///< CPUs of the node
+  };
+
+  /** NUMA node (index) of the given CPU.*/
+  int GetNode(int cpu) const;
+
+  /** Reads the NUMA topology, i.e. the nodes with CPUs, from the `sysfs` ordered by their ID (an empty list if not available).*/
+  static std::vector<NodeCPUs> ReadNodeCPUs();
+
+  /** Parses a `sysfs` CPU list like `0-3,8-11`.*/
+  static std::vector<int> ParseCPUList(const char* list);
+
+private:
+
+  /** Placement of one worker (as reported).*/
+  struct WorkerPlacement {
+    int       fCPU;              ///< CPU the worker was pinned to (-1 if pinning failed)
+    int       fNode;             ///< NUMA node (index) of that CPU
+    int       fReplicaNode;      ///< NUMA node (index) of the state replica used by the worker
+    int       fActualCPU;        ///< CPU the worker was running on after the pinning
+    cpu_set_t fOriginalAffinity; ///< affinity of the worker before the pinning (restored by `TearDownWorker()`)
+  };
+
+  G4HepEmState&                             fState;       ///< the original state
+  int                                       fBacking;     ///< backing of the replicas
+  std::vector<int>                          fCPUs;        ///< the allowed CPUs ordered by their NUMA node
+  std::vector<int>                          fCPUToNode;   ///< NUMA node index of each CPU
+  std::vector<int>                          fNodeIDs;     ///< kernel ID of each NUMA node (by index)
+  std::vector<G4HepEmState*>                fReplicas;    ///< the state replica of each NUMA node (nullptr if not made yet)
+  std::unique_ptr<std::once_flag[]>         fReplicaOnce; ///< each replica is made once (by the first worker of the node)
+  std::vector<WorkerPlacement>              fWorkers;     ///< placement of each worker
+};
+
+#endif // NUMAPLACEMENT_HH
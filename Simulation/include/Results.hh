@@ -15,10 +15,19 @@
  *  - mean number of energy deposited in the `absorber` and `gap`
  *  - mean number of secondary gamma, electron and positrons produced
  *  - mean number of neutral (gamma) and charged (electron/positron)
+ *  - mean number of zero distance stepping loop iterations (i.e. the small
+ *    pushes at boundary crossings, see `Geometry`)
+ *  - mean energy deposit in the individual transverse readout cells (only if
+ *    the readout segmentation is set in the `Geometry`)
+ *  - mean energy deposit in the voxels of a 3D `ScoringMesh` over the `calorimeter`
+ *    (only if the mesh is set up; written into the binary `hist_Edep_Mesh.bin` file)
  *
  * Quantities, recorded in the individual layers are stored in histograms and
  * written to files at the end of the simulation while the others are reported
- * in the screen. An example looks like
+ * in the screen. The per-cell energy deposits are written into the `hist_Edep_PerCell`
+ * file (only the cells with non-zero energy deposit, one line per cell with the global
+ * cell index, `layer` index, 0/1 for `absorber`/`gap`, `y` and `z` cell indices and
+ * the mean energy deposit). An example looks like
  * ```
  *       --- Results::WriteResults ----------------------------------
  *
@@ -31,11 +40,16 @@
  *
  *       Mean number of e-/e+ steps 36097
  *       Mean number of gamma steps 40436.2
+ *       Mean number of zero steps  0
  *       ------------------------------------------------------------
  * ```
  */
 
 #include "Hist.hh"
+#include "ScoringMesh.hh"
+#include "Moments.hh"
+
+#include <vector>
 
 /**
  * Data that needs to be accumulated during one `event` (the scope is one event):
@@ -53,6 +67,7 @@ struct ResultsPerEvent {
   //
   double fNumStepsGamma { 0.0 }; ///< number of \f$\gamma\f$ simulation steps during one event
   double fNumStepsElPos { 0.0 }; ///< number of \f$e^-/e^+\f$ simulation steps during one event
+  double fNumZeroSteps  { 0.0 }; ///< number of zero distance (pushed) stepping loop iterations during one event
 };
 
 
@@ -60,29 +75,50 @@ struct ResultsPerEvent {
  * Data that are collected during the entire `run` of the simulation:
  * - at the beginning of the `ru`n: need to be initialised
  * - at the end of an `run`: written out (to file or to the std output)
- * Mean quantities are computed over the simulated events.
+ * Mean quantities are computed over the simulated events by numerically robust
+ * (Welford) accumulators that are combined exactly across threads (see `Moments`).
+ * Their raw state is also written into the `results_Moments` file (full precision)
+ * so the results of independent jobs can be combined the same way (by the
+ * `HepEmShow-combine` application, exactly in the reproducible mode).
+ *
+ * All the run scope accumulators (histograms, per-cell and mesh energy deposits
+ * and the `Moments`) can be set to accumulate exactly (see `SetReproducible()` and
+ * `ExactSum`): their results are then independent of the order of the events and
+ * merges, i.e. bit-by-bit reproducible regardless the number of threads.
+ * The per-event sums don't need this: the steps of an event are always done in
+ * the same order in the event level parallel mode (while the simulation itself
+ * depends on the scheduling in the sub-event parallel mode).
+ *
+ * Each worker thread collects data into its own replica that is aligned (and
+ * padded) to cache lines so the replicas, even if stored next to each other,
+ * never share a cache line. The replicas are combined at the end of the run by
+ * a parallel tree reduction (see `ReduceResultsStep()`).
  */
-struct Results {
+struct alignas(kCacheLineSize) Results {
   Hist fEdepPerLayer;              ///< mean energy deposit per-layer histogram
   Hist fGammaTrackLenghtPerLayer;  ///< mean number of \f$\gamma\f$ steps per-layer histogram
   Hist fElPosTrackLenghtPerLayer;  ///< mean number of \f$e^-/e^+\f$ steps per-layer histogram
   //
-  double fEdepAbs        { 0.0 };  ///< mean energy deposit in the `absorber`
-  double fEdepAbs2       { 0.0 };  ///< mean of the squared energy deposit in the `absorber`
-  double fEdepGap        { 0.0 };  ///< mean energy deposit in the `gap`
-  double fEdepGap2       { 0.0 };  ///< mean of the squared energy deposit in the `gap`
+  std::vector<double> fEdepPerCell;///< mean energy deposit per readout cell (flat, indexed by the global cell index of the `Geometry`)
+  std::vector<ExactSum> fEdepPerCellExact; ///< exact sums of the energy deposit per readout cell (only in the reproducible mode)
+  int  fNumCellsY          { 0 };  ///< number of readout cells along `y` in a segmented volume
+  int  fNumCellsZ          { 0 };  ///< number of readout cells along `z` in a segmented volume
+  bool fIsAbsorberSegmented{ false }; ///< the `absorber` is also segmented (only the `gap` otherwise)
+  //
+  ScoringMesh fEdepMesh;           ///< mean energy deposit per voxel of the 3D scoring mesh (if active)
+  //
+  bool fIsReproducible     { false }; ///< all run scope data are accumulated exactly (see `SetReproducible()`)
+  //
+  Moments fEdepAbs;                ///< mean and variance of the energy deposit in the `absorber`
+  Moments fEdepGap;                ///< mean and variance of the energy deposit in the `gap`
   //
-  double fNumSecGamma    { 0.0 };  ///< mean number of the produced secondary \f$\gamma\f$ particles
-  double fNumSecGamma2   { 0.0 };  ///< mean of the squared number of produced secondary \f$\gamma\f$ particles
-  double fNumSecElectron { 0.0 };  ///< mean number of the produced secondary \f$e^-\f$ particles
-  double fNumSecElectron2{ 0.0 };  ///< mean of the squared number of produced secondary \f$e^-\f$ particles
-  double fNumSecPositron { 0.0 };  ///< mean number of the produced secondary \f$e^+\f$ particles
-  double fNumSecPositron2{ 0.0 };  ///< mean of the squared number of produced secondary \f$e^+\f$ particles
+  Moments fNumSecGamma;            ///< mean and variance of the number of the produced secondary \f$\gamma\f$ particles
+  Moments fNumSecElectron;         ///< mean and variance of the number of the produced secondary \f$e^-\f$ particles
+  Moments fNumSecPositron;         ///< mean and variance of the number of the produced secondary \f$e^+\f$ particles
   //
-  double fNumStepsGamma  { 0.0 };  ///< mean number of \f$\gamma\f$ steps in the entire calorimeter
-  double fNumStepsGamma2 { 0.0 };  ///< mean of the squared number of \f$\gamma\f$ steps in the entire calorimeter
-  double fNumStepsElPos  { 0.0 };  ///< mean number of \f$e^-/e^+\f$ steps in the entire calorimeter
-  double fNumStepsElPos2 { 0.0 };  ///< mean of the squared number of \f$e^-/e^+\f$ steps in the entire calorimeter
+  Moments fNumStepsGamma;          ///< mean and variance of the number of \f$\gamma\f$ steps in the entire calorimeter
+  Moments fNumStepsElPos;          ///< mean and variance of the number of \f$e^-/e^+\f$ steps in the entire calorimeter
+  Moments fNumZeroSteps;           ///< mean and variance of the number of zero distance (pushed) stepping loop iterations
   ResultsPerEvent fPerEventRes;    ///< data structure to accumulate results during a single event
 };
 
@@ -92,4 +128,59 @@ struct Results {
  * while all the other collected data to the screen.*/
 void WriteResults(struct Results& res, int numEvents=1);
 
+/** Sets all the run scope accumulators to the exact, order independent (reproducible) or to the plain (default) mode.
+ *
+ * Needs to be invoked after the histograms, the per-cell accumulator and the mesh
+ * are set up (all are reset).*/
+void SetReproducible(struct Results& res, bool isReproducible);
+
+/** Writes the raw state of all the `Moments` into the `results_Moments` file (see `Moments::Write()`).
+ *
+ * The number of events, mean and \f$ M_2 \f$ are written or, in the reproducible mode, the number of events and the
+ * exact sums. The files of independent jobs can be combined by the `HepEmShow-combine` application.*/
+void WriteMoments(const struct Results& res);
+
+/** Writes the mean energy deposit per readout cell into the `hist_Edep_PerCell` file (see the description).*/
+void WriteEdepPerCell(const struct Results& res, double norm);
+
+/** Adds the run scope data, collected in an other `Results`, to the given one.
+ *
+ * Used to merge the `Results` of the individual worker threads (each collected
+ * data over their own events) into the single `Results` before `WriteResults`.*/
+void MergeResults(struct Results& res, const struct Results& other);
+
+/** Sets `replica` to be a copy of the given `Results` but sharing the run level grid of its scoring mesh.
+ *
+ * Used to make the prototype of the per-thread replicas: the run level grid of the scoring
+ * mesh is not copied, the replicas flush their events directly into that of `res` (see
+ * `ScoringMesh::ShareRunGrid()`) so the memory of the mesh doesn't grow with the number of threads.*/
+void CopyResultsForReplica(struct Results& replica, struct Results& res);
+
+/** One round of the parallel tree reduction of the per-thread `Results` replicas.
+ *
+ * In the round with the given `stride` (1, 2, 4, ...), the replica of thread `threadID`
+ * (if it is a multiple of `2*stride`) takes the replica of `threadID+stride` (if any).
+ * All threads call this with the same `stride` then synchronise before the next round
+ * so all replicas are reduced into the first within \f$ \lceil \log_2(N) \rceil \f$ rounds.
+ *
+ * @param replicas the per-thread replicas (the first, i.e. thread 0, holds the final result)
+ * @param threadID index of the calling thread
+ * @param stride   distance of the replicas merged in this round
+ */
+void ReduceResultsStep(const std::vector<Results*>& replicas, int threadID, int stride);
+
+/** Gives the tree reduction of the given replicas in `snapshot` without changing them.
+ *
+ * Used to take intermediate snapshots while the replicas are not updated, i.e. at the synchronisation
+ * point at the end of an event in the sub-event parallel mode (see `EventLoop::SubEventWorker()`).
+ * The run level grid of the scoring mesh is not copied: the mesh of the snapshot shares that of the
+ * first replica (see `CopyResultsForReplica()`).*/
+void ReduceResults(Results& snapshot, const std::vector<Results*>& replicas);
+
+/** Adds the event scope data, collected in an other `ResultsPerEvent`, to the given one.
+ *
+ * Used to merge the data collected by the individual worker threads during the
+ * same event in the sub-event parallel mode.*/
+void MergeResultsPerEvent(struct ResultsPerEvent& res, const struct ResultsPerEvent& other);
+
 #endif // RESULTS_HH
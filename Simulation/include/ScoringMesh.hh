@@ -0,0 +1,215 @@
+#ifndef SCORINGMESH_HH
+#define SCORINGMESH_HH
+
+/**
+ * @file    ScoringMesh.hh
+ * @class   ScoringMesh
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief A 3D voxel mesh to collect energy deposit maps during the simulation.
+ *
+ * The mesh is a regular `Nx x Ny x Nz` voxel grid over a given box (the
+ * `calorimeter` in the application). The voxels are indexed by the global
+ * index \f$ (i_x \times N_y + i_y) \times N_z + i_z \f$.
+ *
+ * A dense per-event grid would be touched only at a tiny fraction of its
+ * voxels by a single event while it would need to be cleared at each event
+ * (and would blow the caches at fine binning). So the data is accumulated in
+ * two levels:
+ * - during an event: in a sparse, open addressing (linear probing) hash table
+ *   of the touched voxels by `Fill()`. The table grows (i.e. doubled) whenever
+ *   its load factor reaches 1/2 (it keeps its capacity for the next events).
+ * - at the end of an event: the touched voxels are flushed into the dense,
+ *   run level grid by `EndOfEvent()` (i.e. only the touched voxels are read and
+ *   cleared so its cost is proportional to the number of touched voxels).
+ *
+ * The run level grid can be written into a compact binary file by `WriteToFile()`
+ * that can be memory mapped directly: a fixed, 80 bytes header (see `ScoringMesh::Header`)
+ * followed by the `Nx x Ny x Nz` (native, i.e. little endian on all supported
+ * platforms) double values of the voxels in the above order.
+ *
+ * The run level grid can also be accumulated exactly (see `SetExact()` and
+ * `ExactSum`) to make it independent of the order of the events and merges.
+ *
+ * A mesh can share the run level grid of an other one (see `ShareRunGrid()`): it
+ * has only its per-event hash then and flushes the touched voxels directly into
+ * the run level grid of the other mesh (the flushes are serialised by a lock).
+ * The per-thread replicas of the mesh share the grid of the mesh of the first
+ * worker this way, so the memory of the mesh doesn't grow with the number of threads.
+ *
+ * The mesh is disabled (i.e. `IsActive()` is false and it doesn't allocate any
+ * memory) unless `ReSet()` is called with a positive number of voxels along
+ * each axes and with at most `kMaxNumVoxels` voxels in total.
+ */
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <algorithm>
+
+#include "ExactSum.hh"
+
+class ScoringMesh {
+
+public:
+
+  /** The header of the binary output file (80 bytes, the voxel data starts right after).*/
+  struct Header {
+    char     fMagic[8];     ///< the `HEPEMSH3` magic
+    uint32_t fVersion;      ///< version of the format (1)
+    uint32_t fNumVoxels[3]; ///< number of voxels along the x, y and z axes
+    double   fMin[3];       ///< minimum (lower corner) of the mesh along the x, y and z axes in [mm]
+    double   fMax[3];       ///< maximum (upper corner) of the mesh along the x, y and z axes in [mm]
+    uint64_t fNumEvents;    ///< number of events the (mean per event) voxel values were collected over
+  };
+  static_assert(sizeof(Header) == 80, "ScoringMesh::Header must be 80 bytes");
+
+  /** Maximum total number of voxels: the voxel indices are `int`s and the run level grid is 2 GB (8 bytes per voxel) at this limit (shared by all threads).*/
+  static constexpr int64_t kMaxNumVoxels = int64_t(1) << 28;
+
+  /** Total number of voxels of a mesh with the given number of voxels along the x, y and z axes (computed in 64 bits, i.e. without overflow).*/
+  static int64_t GetNumVoxelsTotal(const int* numVoxels) {
+    return static_cast<int64_t>(numVoxels[0])*numVoxels[1]*numVoxels[2];
+  }
+
+  /** Default constructor (disabled mesh).*/
+  ScoringMesh();
+
+  /** Sets up the mesh with the given number of voxels over the given box (the run level grid is allocated and cleared).
+    *
+    * @param filename  name of the binary file used in `WriteToFile()`
+    * @param numVoxels number of voxels along the x, y and z axes (disabled mesh if any is < 1 or more than `kMaxNumVoxels` in total)
+    * @param min       minimum (lower corner) of the mesh box along the x, y and z axes in [mm]
+    * @param max       maximum (upper corner) of the mesh box along the x, y and z axes in [mm]
+    */
+  void ReSet(const std::string& filename, const int* numVoxels, const double* min, const double* max);
+
+  /** Sets the run level grid to be accumulated exactly (see `ExactSum`) or by plain doubles (default).
+    *
+    * The run level grid is reset. In the exact mode, `GetGrid()` gives the exact sums only after `Scale()`.
+    */
+  void SetExact(bool isExact);
+
+  /** Sets up this mesh with the same dimensions as `theRunMesh` but sharing its run level grid (only the per-event hash is allocated).
+    *
+    * The voxels touched in the events of this mesh are flushed directly into the run level grid of `theRunMesh`
+    * by `EndOfEvent()` (that can be called concurrently for the meshes sharing the same grid). `theRunMesh` needs
+    * to stay alive while this mesh is used.
+    */
+  void ShareRunGrid(ScoringMesh& theRunMesh);
+
+  /** Indicates if the mesh shares the run level grid of an other mesh (see `ShareRunGrid()`).*/
+  bool IsSharingRunGrid() const { return fRunMesh != nullptr; }
+
+  /** Indicates if the mesh is active (i.e. has been set up with a non-zero number of voxels).*/
+  bool IsActive() const { return fNumVoxelsTotal > 0; }
+
+  /** Adds the given value to the voxel that contains the given position in the per-event hash (nothing happens if outside of the mesh).
+    *
+    * @param[in] r   the position in [mm]
+    * @param[in] val the value to add (e.g. energy deposit)
+    */
+  void Fill(const double* r, double val) {
+    const double ux = (r[0] - fMin[0])*fInvSize[0];
+    const double uy = (r[1] - fMin[1])*fInvSize[1];
+    const double uz = (r[2] - fMin[2])*fInvSize[2];
+    // NOTE: the `!(u >= 0)` form also rejects NaN while points on the upper boundaries are kept (in the last voxel)
+    if (!(ux >= 0.0 && uy >= 0.0 && uz >= 0.0) || ux > fNumVoxels[0] || uy > fNumVoxels[1] || uz > fNumVoxels[2]) {
+      return;
+    }
+    const int ix   = std::min(static_cast<int>(ux), fNumVoxels[0]-1);
+    const int iy   = std::min(static_cast<int>(uy), fNumVoxels[1]-1);
+    const int iz   = std::min(static_cast<int>(uz), fNumVoxels[2]-1);
+    const int indx = (ix*fNumVoxels[1] + iy)*fNumVoxels[2] + iz;
+    AddToHash(indx, val);
+    ++fNumFills;
+  }
+
+  /** Flushes the voxels touched in the current event (the per-event hash) into the run level grid then clears the hash.*/
+  void EndOfEvent();
+
+  /** Adds the run level grid of an other mesh (with the same dimensions) to this one (used to merge the worker results).
+    *
+    * Only the statistics are added if the other mesh shares a run level grid (its data is already there).
+    */
+  void Add(const ScoringMesh& other);
+
+  /** Scales the run level grid (e.g. to get mean per event values).*/
+  void Scale(double factor);
+
+  /** Writes the run level grid into the binary file (see the description) with the given number of events in the header.*/
+  void WriteToFile(uint64_t numEvents) const;
+
+  /** Prints the dimensions, memory use and per-event occupancy statistics of the mesh.*/
+  void PrintStatistics() const;
+
+  /** Gives the run level grid.*/
+  const std::vector<double>& GetGrid() const { return fGrid; }
+  /** Number of voxels along the given axis.*/
+  int    GetNumVoxels(int axis) const { return fNumVoxels[axis]; }
+  /** Total memory of the mesh (run level grid plus per-event hash table) in bytes.*/
+  std::size_t GetMemoryInBytes() const;
+
+
+private:
+
+  /** Adds the value to the given voxel in the per-event hash (inserted if not there yet).*/
+  void AddToHash(int indx, double val) {
+    std::size_t slot = Hash(indx);
+    while (true) {
+      const int key = fHashKeys[slot];
+      if (key == indx) {
+        fHashVals[slot] += val;
+        return;
+      }
+      if (key < 0) {
+        break;
+      }
+      slot = (slot + 1) & fHashMask;
+    }
+    fHashKeys[slot] = indx;
+    fHashVals[slot] = val;
+    fHashTouched.push_back(static_cast<int>(slot));
+    // keep the load factor below 1/2
+    if (2*fHashTouched.size() >= fHashKeys.size()) {
+      GrowHash();
+    }
+  }
+
+  /** Slot of the given voxel index in the per-event hash (Fibonacci hashing).*/
+  std::size_t Hash(int indx) const {
+    return static_cast<std::size_t>((static_cast<uint64_t>(indx)*0x9E3779B97F4A7C15ULL) >> fHashShift);
+  }
+
+  /** Doubles the capacity of the per-event hash (the touched voxels are re-inserted).*/
+  void GrowHash();
+
+
+private:
+
+  std::string          fFileName;        ///< name of the binary output file
+  int                  fNumVoxels[3];    ///< number of voxels along the x, y and z axes
+  std::size_t          fNumVoxelsTotal;  ///< total number of voxels (0 if not active)
+  double               fMin[3];          ///< lower corner of the mesh
+  double               fMax[3];          ///< upper corner of the mesh
+  double               fInvSize[3];      ///< inverse voxel sizes along the x, y and z axes
+  //
+  std::vector<double>  fGrid;            ///< the dense, run level grid
+  std::vector<ExactSum> fGridExact;      ///< the dense, run level grid of exact sums (only in the exact mode)
+  bool                 fIsExact;         ///< the run level grid is accumulated exactly
+  ScoringMesh*         fRunMesh;         ///< the mesh whose run level grid is used by this one (`nullptr` if its own is used)
+  //
+  std::vector<int>     fHashKeys;        ///< voxel indices of the per-event hash (-1 for empty slots)
+  std::vector<double>  fHashVals;        ///< values of the per-event hash
+  std::vector<int>     fHashTouched;     ///< the occupied slots of the per-event hash (in insertion order)
+  std::size_t          fHashMask;        ///< capacity - 1 (the capacity is a power of 2)
+  int                  fHashShift;       ///< 64 - log2(capacity) for the Fibonacci hashing
+  //
+  std::size_t          fNumFlushes;      ///< number of per-event hash flushes into the grid (events)
+  std::size_t          fNumFills;        ///< number of `Fill()` calls inside the mesh
+  std::size_t          fNumTouchedSum;   ///< sum of the number of touched voxels over the flushes
+  std::size_t          fNumTouchedPeak;  ///< maximum number of touched voxels in a flush
+};
+
+#endif // SCORINGMESH_HH
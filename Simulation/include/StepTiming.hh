@@ -0,0 +1,162 @@
+#ifndef STEPTIMING_HH
+#define STEPTIMING_HH
+
+/**
+ * @file    StepTiming.hh
+ * @class   StepTiming
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief Low overhead, compile time optional timing of the phases of the simulation steps in the `SteppingLoop`.
+ *
+ * The instrumentation is compiled only when `HEPEMSHOW_STEP_TIMING` is defined
+ * (by the `-DHepEmShow_STEP_TIMING=ON` `CMake` option): the `STEP_TIMING_BEGIN`
+ * and `STEP_TIMING_MARK` macros, placed in the steppers, expand to nothing
+ * otherwise (i.e. no cost at all).
+ *
+ * When compiled, the time stamp counter (`rdtsc`, the virtual counter on ARM
+ * and `steady_clock` nanoseconds elsewhere) is read at the beginning of the step
+ * and at the end of each of its phases (see `Phase`), the difference of the two
+ * consecutive readings is added to the counter of the phase. In order to keep the
+ * overhead low (a reading costs 10-50 cycles while a step is a few thousands with
+ * the full `G4HepEm` physics), only every `kSamplingPeriod`-th step is timed (the
+ * others only count). The counters are per thread (no synchronisation during the
+ * simulation) and are merged when the worker thread exits. `Report()` gives the
+ * average cycles per (timed) step spent in each phase for \f$\gamma\f$ and
+ * \f$e^-/e^+\f$ separately (with the cost of one reading that is included in each).
+ *
+ * Only the `SteppingLoop` (history based stepping) is instrumented, the steps done
+ * by the `BasketStepper` are not timed.
+ *
+ * @note The time stamp counter is not serialising (`rdtsc` instead of `rdtscp`
+ * with fences) so a few instructions might be attributed to the neighbouring
+ * phase. This is the price of the low overhead and it's negligible compared to
+ * the cost of the phases.
+ */
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+class StepTiming {
+
+public:
+
+  /** The timed phases of a simulation step.*/
+  enum Phase {
+    kLocate = 0,        ///< `Geometry::CalculateDistanceToOut` at the pre-step point
+    kSafety,            ///< `Box` safety at the pre-step point
+    kHowFar,            ///< `G4HepEm` physics step limit (`HowFar`)
+    kMove,              ///< selecting the step length and moving the track (with zero steps)
+    kPerform,           ///< `G4HepEm` physics (`Perform`)
+    kMSCDisplacement,   ///< applying the MSC lateral displacement (\f$e^-/e^+\f$ only)
+    kStackSecondaries,  ///< pushing the secondaries into the `TrackStack`
+    kSteppingAction,    ///< the `SteppingAction` (scoring)
+    kNumPhases
+  };
+
+  /** The particle types the phases are timed separately for.*/
+  enum Particle {
+    kGamma = 0,         ///< \f$\gamma\f$
+    kElectron,          ///< \f$e^-/e^+\f$
+    kNumParticles
+  };
+
+  /** Only every `kSamplingPeriod`-th step is timed (must be a power of 2).*/
+  static constexpr std::uint64_t kSamplingPeriod = 64;
+
+  /** The counters of one thread.*/
+  struct Counters {
+    std::uint64_t fCycles[kNumParticles][kNumPhases]; ///< the cycles spent in the phases of the timed steps
+    std::uint64_t fNumTimedSteps[kNumParticles];      ///< number of timed steps
+    std::uint64_t fNumSteps[kNumParticles];           ///< number of all steps
+  };
+
+  /** Times the phases of the steps of one track (used through the `STEP_TIMING_` macros).
+    *
+    * The step counters are kept locally (i.e. in registers) and added to those of the thread
+    * at the end of the track so the steps that are not timed cost only a few instructions.
+    */
+  class Timer {
+  public:
+    Timer(Particle particle) : fCounters(GetCounters()), fParticle(particle), fIsTimed(false), fNumSteps(fCounters.fNumSteps[particle]), fNumTimedSteps(0), fLast(0) {}
+    ~Timer() {
+      fCounters.fNumSteps[fParticle]       = fNumSteps;
+      fCounters.fNumTimedSteps[fParticle] += fNumTimedSteps;
+    }
+
+    /** Starts a new step: decides if it's timed and takes the first reading.*/
+    void Begin() {
+      fIsTimed = ((++fNumSteps) & (kSamplingPeriod - 1)) == 0;
+      if (fIsTimed) {
+        ++fNumTimedSteps;
+        fLast = Now();
+      }
+    }
+
+    /** Ends the given phase of the current step (the next starts).*/
+    void Mark(Phase phase) {
+      if (fIsTimed) {
+        const std::uint64_t now = Now();
+        fCounters.fCycles[fParticle][phase] += now - fLast;
+        fLast = now;
+      }
+    }
+
+  private:
+    Counters&     fCounters;
+    Particle      fParticle;
+    bool          fIsTimed;
+    std::uint64_t fNumSteps;
+    std::uint64_t fNumTimedSteps;
+    std::uint64_t fLast;
+  };
+
+  /** Reads the time stamp counter.*/
+  static std::uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t val;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(val));
+    return val;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  /** The counters of the calling thread.*/
+  static Counters& GetCounters();
+
+  /** Re-sets the counters (of the calling thread and those merged from the already completed threads).*/
+  static void Reset();
+
+  /** Reports the cycles per step spent in each phase (of the calling thread and the already completed threads).*/
+  static void Report();
+
+private:
+  StepTiming() = delete;
+
+  /** Merges the counters of a completed thread.*/
+  static void Merge(const Counters& theCounters);
+
+  friend struct ThreadCounters;
+};
+
+
+// NOTE: the instrumentation of the steppers (nothing unless `HEPEMSHOW_STEP_TIMING` is defined)
+#ifdef HEPEMSHOW_STEP_TIMING
+#define STEP_TIMING_TIMER(timer, particle) StepTiming::Timer timer(particle)
+#define STEP_TIMING_BEGIN(timer)           timer.Begin()
+#define STEP_TIMING_MARK(timer, phase)     timer.Mark(phase)
+#else
+#define STEP_TIMING_TIMER(timer, particle)
+#define STEP_TIMING_BEGIN(timer)
+#define STEP_TIMING_MARK(timer, phase)
+#endif
+
+#endif // STEPTIMING_HH
@@ -80,6 +80,7 @@
 class G4HepEmTLData;
 class G4HepEmState;
 class G4HepEmTrack;
+class G4HepEmMSCTrackData;
 
 class TrackStack;
 class Geometry;
@@ -126,6 +127,9 @@ public:
 private:
   SteppingLoop() = delete;
 
+  // the basket based stepping engine utilises the same auxiliary methods
+  friend class BasketStepper;
+
   /** Auxiliary method that pushes the secondary track(s), produced by physics interactions at the post-step point (if any), into the track stack.
    *
    * @param theTLData the `G4HepEm` specific (thread local) object that is used by `G4HepEm` to deliver the secondary tracks to the caller after calling the its `Perform` top level method
@@ -145,11 +149,26 @@ private:
    * @param currentPhysStepLength real (physical) length of the step
    * @param indxLayer index of the layer in which the step was done
    * @param indxAbsorber indicates if the step was done in the `absorber` (0) or in the `gap` (1)
+   * @param indxCell global index of the readout cell in which the step was done (-1 if not in a segmented volume)
    * @param eventID ID of the event to which the particle under tracking belongs to
    * @param stepID ID of this step that was just performed, i.e. number of steps cmpleted so far with with the current track
    */
-  static void SteppingAction(Results& theResult, const G4HepEmTrack& theTrack, const Box* currentVolume, double currentPhysStepLength, int indxLayer, int indxAbsorber, int eventID, int stepID);
+  static void SteppingAction(Results& theResult, const G4HepEmTrack& theTrack, const Box* currentVolume, double currentPhysStepLength, int indxLayer, int indxAbsorber, int indxCell, int eventID, int stepID);
+
 
+  /** Auxiliary method that applies the lateral displacement, sampled by MSC along the last step of an \f$e^-/e^+\f$, to the post-step point.
+   *
+   * The displacement is applied (or reduced) only if the displaced point stays inside the current volume, i.e. the post-step point safety
+   * (computed along the original direction) is used to decide. Should be called only if the post-step point is not on boundary.
+   *
+   * @param theTrack the \f$e^-/e^+\f$ track, in its post interaction state, with the post-step point position before displacement
+   * @param theMSCData the MSC related data of the track that provides the sampled displacement
+   * @param currentVolume pointer to the volume in which the simulation step was done
+   * @param localPosition pre-step point position in the local system of `currentVolume` (will be updated to the post-step point)
+   * @param orgDirection direction of the track at the pre-step point
+   * @param stepLength geometrical length of the step (along `orgDirection`)
+   */
+  static void ApplyMSCDisplacement(G4HepEmTrack& theTrack, G4HepEmMSCTrackData& theMSCData, const Box* currentVolume, double* localPosition, const double* orgDirection, double stepLength);
 
   // some utilities to modify 3vectors
   static void Set3Vect(double* v, double to);
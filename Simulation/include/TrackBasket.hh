@@ -0,0 +1,139 @@
+
+#ifndef TrackBasket_HH
+#define TrackBasket_HH
+
+/**
+ * @file    TrackBasket.hh
+ * @class   TrackBasket
+ * @author  agent
+ * @date    October 2026
+ *
+ * @brief A basket of in-flight tracks of the same type (\f$\gamma\f$ or \f$e^-/e^+\f$) for the basket based stepping.
+ *
+ * The basket based stepping engine (see `BasketStepper`) simulates a single step
+ * with all tracks of a basket at once instead of simulating the entire history
+ * of a single track (as in `SteppingLoop`). The basket stores:
+ * - the `G4HepEm` state of each track (i.e. `G4HepEmGammaTrack` or `G4HepEmElectronTrack`
+ *   depending on the type of the basket) that is used (and updated) only by the
+ *   `G4HepEm` `HowFar` and `Perform` methods. Each slot of the basket has its own
+ *   `G4HepEmTLData` (sharing the random engine of the worker) and the state of the
+ *   track is its primary track: the `G4HepEm` methods are invoked directly on these
+ *   resident tracks, i.e. without copying them into (and back from) a single
+ *   `G4HepEmTLData`
+ * - while all other data, used by the geometry, step limit selection, transportation
+ *   and scoring, are stored in a structure-of-arrays form such that these can be
+ *   computed in tight loops (batch kernels) over the basket
+ *
+ * The global position and direction of the tracks are stored in the structure-of-arrays
+ * part during the stepping: only these and the few other fields that are read by the
+ * `G4HepEm` methods are written into the resident tracks before invoking them (and only
+ * the updated position and direction are taken back after `Perform`).
+ *
+ * Tracks are added to the basket by `Insert()` (e.g. by popping a track from the
+ * `TrackStack` into the returned reference) and are flagged when their history is
+ * terminated (`IsAlive()`). The basket can be compacted (`Compact()`) to remove these
+ * terminated tracks, after invoking the end of tracking action on them, such that
+ * new tracks can be inserted.
+ */
+
+#include "G4HepEmTLData.hh"
+#include "G4HepEmGammaTrack.hh"
+#include "G4HepEmElectronTrack.hh"
+
+#include "NavigationState.hh"
+
+#include <vector>
+
+class Box;
+class G4HepEmRandomEngine;
+
+class TrackBasket {
+public:
+  /** CTR
+    *
+    * @param[in] isGamma  indicates if this basket stores \f$\gamma\f$ (or \f$e^-/e^+\f$ otherwise) tracks.
+    * @param[in] capacity maximum number of tracks that can be stored in this basket.
+    * @param[in] theRandomEngine the random engine (of the worker) used by the `G4HepEm` methods invoked on the tracks.
+    */
+  TrackBasket(bool isGamma, int capacity, G4HepEmRandomEngine* theRandomEngine);
+  /** DTR */
+ ~TrackBasket() {}
+
+  /** Indicates if this basket stores \f$\gamma\f$ (`true`) or \f$e^-/e^+\f$ (`false`) tracks.*/
+  bool IsGamma()     const { return fIsGamma;  }
+  /** Number of tracks currently stored in the basket.*/
+  int  GetSize()     const { return fSize;     }
+  /** Maximum number of tracks that can be stored in this basket.*/
+  int  GetCapacity() const { return fCapacity; }
+  /** Indicates if no more tracks can be inserted.*/
+  bool IsFull()      const { return fSize == fCapacity; }
+
+  /** Returns a reference to the (re-set) `G4HepEmTrack` of a new slot in the basket that can be used to add a new track.
+    *
+    * The new track is loaded into the structure-of-arrays part of the basket at the beginning of the next step.
+    * Must not be called when the basket is full.
+    */
+  G4HepEmTrack& Insert() { return *Insert(1)[0]; }
+
+  /** Inserts the given number of new slots at once (see above).
+    *
+    * @param[in] num number of the new slots (must not be more than the free capacity).
+    * @return array of the addresses of the (re-set) `G4HepEmTrack`-s of the new slots (e.g. to pop tracks from the stack at once).
+    */
+  G4HepEmTrack* const* Insert(int num);
+
+  /** Removes the terminated tracks from the basket by moving the last tracks into their slots (only the terminated ones are replaced).*/
+  void Compact();
+
+  /** Indicates if the history of the track at the given index is still not terminated.*/
+  bool IsAlive(int i) const { return fIsAlive[i] != 0; }
+
+  /** The `G4HepEmTrack` of the track at the given index.*/
+  G4HepEmTrack*          GetTrack(int i)         { return fTracks[i]; }
+  /** The `G4HepEmTLData` of the slot at the given index: its primary (\f$\gamma\f$ or \f$e^-/e^+\f$) track is the `G4HepEm` state of the track.*/
+  G4HepEmTLData&         GetTLData(int i)        { return fTLData[i]; }
+  /** The `G4HepEm` state of the \f$\gamma\f$ track at the given index (only for \f$\gamma\f$ baskets).*/
+  G4HepEmGammaTrack&     GetGammaTrack(int i)    { return *fTLData[i].GetPrimaryGammaTrack();    }
+  /** The `G4HepEm` state of the \f$e^-/e^+\f$ track at the given index (only for \f$e^-/e^+\f$ baskets).*/
+  G4HepEmElectronTrack&  GetElectronTrack(int i) { return *fTLData[i].GetPrimaryElectronTrack(); }
+
+
+private:
+  /** Moves all data of the track at index `from` to index `to`.*/
+  void MoveSlot(int from, int to);
+
+
+public:
+  // The structure-of-arrays part of the basket: all arrays have the size of `capacity`
+  // (only the first `GetSize()` elements are used). These are accessed directly by
+  // the batch kernels of the `BasketStepper`.
+  std::vector<double> fPosX;            ///< global x-position of the tracks
+  std::vector<double> fPosY;            ///< global y-position of the tracks
+  std::vector<double> fPosZ;            ///< global z-position of the tracks
+  std::vector<double> fDirX;            ///< x-component of the direction of the tracks
+  std::vector<double> fDirY;            ///< y-component of the direction of the tracks
+  std::vector<double> fDirZ;            ///< z-component of the direction of the tracks
+  std::vector<double> fDistToBoundary;  ///< distance to the boundary of the current volume along the direction
+  std::vector<double> fSafety;          ///< pre-step point safety
+  std::vector<double> fDistToPhysics;   ///< physics step limit (provided by the `G4HepEm` `HowFar`)
+  std::vector<double> fStepLength;      ///< geometrical length of the current step
+  std::vector<double> fPhysStepLength;  ///< physical (true) length of the current step
+  std::vector<NavigationState> fNavState; ///< navigation state of the tracks (current volume, layer and local position at the pre-step point)
+  std::vector<int>    fNumSteps;        ///< number of steps done so far by the track
+  std::vector<char>   fIsAlive;         ///< indicates if the history of the track is not terminated yet
+  std::vector<char>   fIsNew;           ///< indicates if the track still needs to be loaded into the arrays (inserted after the last step)
+  std::vector<char>   fOnBoundary;      ///< indicates if the current step is limited by the geometry
+  std::vector<char>   fWasOnBoundary;   ///< indicates if the previous step was limited by the geometry
+  std::vector<char>   fIsPushed;        ///< indicates if the track was only pushed in the current step (zero step length)
+
+
+
+private:
+  bool fIsGamma;                              ///< type of the tracks stored in the basket
+  int  fCapacity;                             ///< maximum number of tracks
+  int  fSize;                                 ///< number of tracks currently stored
+  std::vector<G4HepEmTLData>  fTLData;        ///< `G4HepEm` data of the slots: their primary tracks are the `G4HepEm` state of the tracks
+  std::vector<G4HepEmTrack*>  fTracks;        ///< addresses of the `G4HepEmTrack`-s of the above (per slot)
+};
+
+#endif // TrackBasket_HH
@@ -1,4 +1,5 @@
-#ifndef TrackStack_HH
+
+#ifndef TrackStack_HH
 #define TrackStack_HH
 
 /**
@@ -20,9 +21,31 @@
  * - the event is completed when the track-stack becomes empty again
  *
  * A new event can be started then.
+ *
+ * The tracks are stored in a compact, structure-of-arrays form: only the fields
+ * that describe the initial state of a track (position, direction, kinetic energy
+ * and its logarithm, charge, track and parent IDs and the material-cuts couple
+ * index) are stored, each in its own contiguous array. All other fields of the
+ * `G4HepEmTrack` (e.g. safety, on-boundary flag) are reset when a track is popped
+ * as these are computed at each pre-step point in the steppers anyway. Several
+ * tracks can be pushed (e.g. all secondaries produced in a step) or popped (e.g.
+ * when filling a basket of the `BasketStepper`) at once by the bulk `Push()` and
+ * `PopInto()` methods.
+ *
+ * When the tracks of a single event are shared by several worker threads (see the
+ * sub-event parallel mode of `EventLoop::ProcessEvents()`), each worker has its own
+ * stack that is used as a work-stealing deque: the owner pushes and pops tracks at
+ * the top (i.e. depth first as before) while the idle workers can steal the oldest
+ * track from the bottom of the stack (by `StealInto()`). The stack needs to be
+ * set to this `shared` mode (by `SetShared()`) in which all operations are guarded
+ * by a lock and the number of tracks, that are still to be finished in the event,
+ * is maintained in a counter that is shared by all workers.
  */
 
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
 
 class G4HepEmTrack;
 
@@ -39,11 +62,37 @@ public:
     * a new track. It returns with the original index of the popped track or -1 when
     * the track is actually empty, i.e. no more track to pop.
     *
+    * Only the stored fields are written so the input track is expected to be re-set
+    * already (e.g. the primary track of the `G4HepEmTLData` by `EventLoop::PrepareTrack()`
+    * or a new slot of a `TrackBasket`), i.e. the track is popped directly into the
+    * place where it will be stepped without any further copy or reset.
+    *
     * @param[in,out] track the address of the `G4HepEmTrack` where the next track should be popped, i.e. copied.
     * @return returns with the original index of the popped track or -1 if the there are no more tracks in the track
     */
   int PopInto(G4HepEmTrack& track);
 
+  /** Pops the given number of tracks from the stack at once.
+    *
+    * The tracks are popped in the same order as by calling the above `PopInto()` `num` times, i.e. the
+    * track from the top of the stack is written to `tracks[0]`. The number of tracks, that are popped,
+    * is limited by the number of tracks in the stack.
+    *
+    * @param[in,out] tracks array of addresses of the `G4HepEmTrack`-s where the next tracks should be popped.
+    * @param[in]     num    number of tracks required to be popped.
+    * @return the number of tracks popped (i.e. written to the first elements of `tracks`).
+    */
+  int PopInto(G4HepEmTrack* const* tracks, int num);
+
+  /** Steals the oldest track (i.e. from the bottom) from the stack and writes to the input address.
+    *
+    * This method is called by the idle workers in the sub-event parallel mode (only in `shared` mode).
+    *
+    * @param[in,out] track the address of the `G4HepEmTrack` where the stolen track should be copied.
+    * @return returns with the original index of the stolen track or -1 if the there are no more tracks in the track
+    */
+  int StealInto(G4HepEmTrack& track);
+
 
   /** Can provide the type of the next track.
    *
@@ -58,34 +107,110 @@ public:
    */
   int GetTypeOfNextTrack();
 
-
-  /** Returns a reference to a secondary track that can be used to push a new track into the stack.
+  /** Provides the number of the next tracks (i.e. on the top of the stack) that are all \f$\gamma\f$ or all \f$e^-/e^+\f$.
    *
-   * This method is called whenever a new track needs to be inseted into the stack. The provided reference
-   * can be used to fill the track infomation (the referenced track is re-set).
-   *
-   * @return A reference to a `G4HepEmTrack` that can be used to add a new track to the stack (by filling in its filed).
+   * @param[in] isGamma indicates if the number of the next \f$\gamma\f$ (or \f$e^-/e^+\f$ otherwise) tracks is required.
+   * @param[in] maxNum  the maximum number that is required.
+   * @return the number of the next tracks (at most `maxNum`) that can be popped by the bulk `PopInto()` as one type.
    */
-  G4HepEmTrack&  Insert();
+  int GetNumNextTracksOfType(bool isGamma, int maxNum);
+
+
+  /** Pushes a copy of the given track into the stack.
+    *
+    * This is safe in the `shared` mode (increments the shared counter of the tracks that are still to be finished).
+    *
+    * @param[in] track the track to be pushed (copied) into the stack.
+    */
+  void Push(G4HepEmTrack& track);
 
+  /** Pushes the secondary tracks, produced by the given parent track in its last step, into the stack at once.
+    *
+    * This is the hand-off of the secondaries from the `G4HepEmTLData` to the stack (see `SteppingLoop::StackSecondaries()`):
+    * the secondaries are written directly into the storage of the stack, while their track ID is assigned here and
+    * their parent ID, position and material-cuts couple index are taken from the parent. So the secondaries are only
+    * read from the buffer of the `G4HepEmTLData` (they are not modified or copied anywhere else). The secondaries are
+    * pushed in the same order as by the bulk `Push()` below.
+    *
+    * @param[in] secondaries array of addresses of the secondary tracks (e.g. in the `G4HepEmTLData`).
+    * @param[in] num         number of secondary tracks.
+    * @param[in] parent      the parent track that produced the secondaries.
+    */
+  void PushSecondaries(G4HepEmTrack* const* secondaries, int num, G4HepEmTrack& parent);
 
-  /** Copying the content of the `from` to the `to` track.*/
-  void Copy(G4HepEmTrack& from, G4HepEmTrack& to);
+  /** Pushes copies of the given number of tracks into the stack at once.
+    *
+    * The tracks are pushed in the same order as by calling the above `Push()` `num` times, i.e. `tracks[num-1]`
+    * will be on the top of the stack.
+    *
+    * @param[in] tracks array of addresses of the tracks to be pushed (copied) into the stack.
+    * @param[in] num    number of tracks to be pushed.
+    */
+  void Push(G4HepEmTrack* const* tracks, int num);
 
 
   /** Returns with the next track ID (track ID is incremented whenever this method is invoked).*/
-  int  GetNextTrackID() { return fCurrentTrackID++; }
-  /** Resets the track ID to zero.*/
-  void ReSetTrackID()   { fCurrentTrackID=0; }
+  int  GetNextTrackID() { const int id = fCurrentTrackID; fCurrentTrackID += fTrackIDStride; return id; }
+  /** Resets the track ID to zero (or to the first ID set in `SetTrackIDs()`).*/
+  void ReSetTrackID()   { fCurrentTrackID=fFirstTrackID; }
+  /** Sets the first track ID and the stride between the track IDs given by this stack.
+    *
+    * Used in the sub-event parallel mode to give unique track IDs to all tracks of the event over the stacks of
+    * all workers (the worker with index `i` of `N` gives `i, i+N, i+2N, ...`).*/
+  void SetTrackIDs(int first, int stride) { fFirstTrackID = first; fTrackIDStride = stride; fCurrentTrackID = first; }
+
+
+  /** Sets the stack to the `shared` (i.e. work-stealing deque) mode.
+    *
+    * @param[in] numPendingTracks counter, shared by all workers, of the tracks of the event that are still to be
+    *                             finished (incremented by each `Push()`).
+    */
+  void SetShared(std::atomic<int>* numPendingTracks) { fNumPendingTracks = numPendingTracks; }
+
+
+  /** Returns the maximum number of tracks that were stored in the stack at the same time.*/
+  int         GetPeakNumTracks()  const { return fPeakNumTracks; }
+  /** Returns the memory (in bytes) used by the track records of the stack at its current capacity.*/
+  std::size_t GetMemoryInBytes()  const { return fSize*kRecordSize; }
+  /** Size of one track record (in bytes) summed over all arrays.*/
+  static constexpr std::size_t kRecordSize = 8*sizeof(double) + sizeof(signed char) + 3*sizeof(int);
 
 
 
 private:
 
+  /** Makes sure that the capacity is enough to store the given number of tracks.*/
+  void Reserve(int num);
+  /** Writes the track into the given slot of the arrays.*/
+  void Write(int indx, G4HepEmTrack& track);
+  /** Reads the track from the given slot of the arrays (only the stored fields are written).*/
+  void Read(int indx, G4HepEmTrack& track) const;
+
+
   int fSize;                             ///< current capacity of the track stack
-  int fCurIndx;                          ///< number of tracks used from the capacity
+  int fCurIndx;                          ///< index of the track on the top (-1 when empty)
+  int fBottomIndx;                       ///< index of the oldest track that is still in the stack (> 0 only when tracks were stolen)
+  int fPeakNumTracks;                    ///< maximum number of tracks that were stored at the same time
   int fCurrentTrackID;                   ///< current track ID
-  std::vector<G4HepEmTrack> fTrackVect;  ///< the stack as a vector of tracks
+  int fFirstTrackID;                     ///< the first track ID (after `ReSetTrackID()`)
+  int fTrackIDStride;                    ///< the difference between two consecutive track IDs
+
+  // the track records in structure-of-arrays form
+  std::vector<double>      fPosX;        ///< x-coordinate of the position
+  std::vector<double>      fPosY;        ///< y-coordinate of the position
+  std::vector<double>      fPosZ;        ///< z-coordinate of the position
+  std::vector<double>      fDirX;        ///< x-component of the direction
+  std::vector<double>      fDirY;        ///< y-component of the direction
+  std::vector<double>      fDirZ;        ///< z-component of the direction
+  std::vector<double>      fEKin;        ///< kinetic energy
+  std::vector<double>      fLogEKin;     ///< logarithm of the kinetic energy
+  std::vector<signed char> fCharge;      ///< charge (-1, 0 or +1)
+  std::vector<int>         fID;          ///< track ID
+  std::vector<int>         fParentID;    ///< parent track ID
+  std::vector<int>         fMCIndex;     ///< material-cuts couple index
+
+  std::atomic<int>* fNumPendingTracks;   ///< shared counter of the tracks still to be finished (`nullptr` if not in `shared` mode)
+  std::mutex        fMutex;              ///< guards the stack in `shared` mode
 };
 
 #endif // TrackStack_HH
@@ -11,40 +11,154 @@
  *
  * This is the uniform random number generator, i.e. the only thing that is
  * need to make the `G4HepEm` physics implementation complete (see more at
- * the `Physics` documentation). This random number generator relies on the
- * c++11 implementation of the 64-bit Mersenne Twister engine. The `URandom::flat()`
- * method can be used to provide uniform random numbers on the \f$(0,1)\f$.
- * An object from this class is constructed in the `HepEmShow` main and set to
- * be used in the `G4HepEmRandomEngine`.
+ * the `Physics` documentation). The `URandom::flat()` method can be used to
+ * provide uniform random numbers on the \f$(0,1)\f$ while `URandom::flatArray()`
+ * fills a whole array at once. An object from this class is constructed by each
+ * worker of the `EventLoop` and set to be used in the `G4HepEmRandomEngine`.
+ *
+ * Two engines are available (selected at construction, see `URandom::EngineType`):
+ * - `kMersenneTwister` (default): the c++11 implementation of the 64-bit Mersenne
+ *   Twister engine (2.5 kB state that is costly to re-seed and has no skip-ahead).
+ * - `kPhilox`: the counter based Philox4x32-10 generator (J. K. Salmon et al.,
+ *   "Parallel random numbers: as easy as 1, 2, 3", SC11). A block of 4x32 random
+ *   bits (i.e. two doubles) is a pure function of a 64 bit key (derived from the
+ *   seed), the 64 bit stream ID and the 64 bit block counter. So the state is a
+ *   few words, re-seeding is free and any position of any stream can be reached
+ *   in O(1) (see `SetPosition()`). Consecutive blocks are independent so the array
+ *   version computes them in a loop that the compiler can vectorise.
+ *
+ * In order to make the simulation results independent from the number of
+ * worker threads and from the order in which the events are processed, the
+ * generator is re-seeded at the beginning of each event by `URandom::SetSeed()`
+ * with a seed that is derived from the run seed and the event ID. The two are
+ * combined by the (cheap) `SplitMix64` mixing function that gives well separated
+ * seeds, i.e. statistically independent streams even for consecutive event IDs.
+ * The event ID is used directly as the stream ID of the Philox engine.
+ *
+ * The numbers are delivered from a small buffer that is refilled in bulk, on
+ * demand, when all its numbers are used (the Philox blocks of a refill are computed
+ * in a vectorised loop). So `flat()` is only a load and an index increment in the
+ * overwhelming majority of the calls (it's inlined into the `G4HepEmRandomEngine::flat()`
+ * in `Physics.cc`). The buffer is transparent: the numbers are delivered in the same
+ * order as without buffering, `GetPosition()` counts the numbers that have been
+ * delivered (not generated) and `SetSeed()` or `SetPosition()` drop the buffered ones.
+ * Therefore, the per-event streams and any rewind (e.g. at the start of a track)
+ * are reproducible exactly the same way as without the buffer.
  *
  * @note This random number generator can be replaced with anything that can provide
  * uniform fandom numbers on \f$(0,1)\f$. One need to modify the corresponding
  * implementations in `Physics` (namely, one line in the `G4HepEmRandomEngine::flat()`
  * and `G4HepEmRandomEngine::flatArray()` implementations in `Physics.cc`) and
- * replace the `URandom` object construction in the `HepEmShow` main.
+ * replace the `URandom` object construction in the `EventLoop`.
  */
 
 #include <random>
+#include <memory>
+#include <cstdint>
 
 class URandom {
 public:
 
+   /** The available engines (the values are used as the `--random-engine` input argument).*/
+   enum class EngineType : int {
+     kMersenneTwister = 0,  ///< 64-bit Mersenne Twister (`std::mt19937_64`)
+     kPhilox          = 1   ///< counter based Philox4x32-10
+   };
+
    /** CTR
     *
-    * @param seed seed of the random number generator.
+    * @param seed   seed of the random number generator.
+    * @param engine the engine to be used.
     */
-   URandom(int seed=123);
+   URandom(int seed=123, EngineType engine=EngineType::kMersenneTwister);
    /** DTR*/
   ~URandom();
 
+   /** Size of the buffer of the pre-generated numbers (even, i.e. full Philox blocks).*/
+   static constexpr int kBufferSize = 128;
+
    /** Method to provide uniform random numbers on \f$(0,1)\f$ */
-   double flat();
+   double flat() {
+     if (fIndxInBuffer == kBufferSize) {
+       Refill();
+     }
+     return fBuffer[fIndxInBuffer++];
+   }
 
-public:
+   /** Method to fill the given array with uniform random numbers on \f$(0,1)\f$ (the same as calling `flat()` `size` times).
+    *
+    * @param size number of random numbers required.
+    * @param vect array to fill (with at least `size` elements).
+    */
+   void flatArray(int size, double* vect);
+
+   /** Re-seeds the generator to start the stream that belongs to the given ID.
+    *
+    * The seed of the engine is derived from the (run) `seed` and the `streamID`
+    * (e.g. event ID) such that the same (`seed`, `streamID`) pair always results
+    * the same sequence of random numbers.
+    *
+    * @param seed     seed of the run.
+    * @param streamID ID of the required stream (e.g. ID of the event).
+    */
+   void SetSeed(std::uint64_t seed, std::uint64_t streamID);
+
+   /** Number of random numbers taken from the current stream since `SetSeed()` (the buffered, not yet used numbers are not included).*/
+   std::uint64_t GetPosition() const { return fBufferPosition + fIndxInBuffer; }
+
+   /** Jumps to the given position of the current stream, i.e. the next number is the `position`-th.
+    *
+    * This is O(1) with the `kPhilox` engine while the `kMersenneTwister` engine
+    * is re-seeded and the first `position` numbers are discarded.
+    */
+   void SetPosition(std::uint64_t position);
+
+   /** The engine used by this generator.*/
+   EngineType GetEngineType() const { return fEngineType; }
+
+   /** The `SplitMix64` mixing function used to derive the seeds of the streams.*/
+   static std::uint64_t SplitMix64(std::uint64_t x);
+
+   /** The Philox4x32-10 bijection: the 4x32 bits of random output for the given 4x32 bits counter and 2x32 bits key.*/
+   static void Philox4x32(const std::uint32_t* ctr, const std::uint32_t* key, std::uint32_t* out);
+
+
+private:
+
+   /** Fills the buffer with the next `kBufferSize` numbers of the stream.*/
+   void Refill();
+
+   /** Computes `numBlocks` consecutive blocks (i.e. `2 x numBlocks` doubles), starting from the given one, of the current stream.*/
+   void Philox4x32Blocks(std::uint64_t counter, int numBlocks, double* out) const;
+
+
+private:
+   /** The engine used by this generator. */
+   EngineType fEngineType;
+   //
+   // the state of the Philox engine
+   /** The key (derived from the seed). */
+   std::uint32_t fKey[2];
+   /** The stream ID (e.g. event ID, the upper half of the Philox counter). */
+   std::uint64_t fStreamID;
+   /** Index of the next block of the stream (the lower half of the Philox counter). */
+   std::uint64_t fCounter;
+   //
+   // the buffer of the pre-generated numbers
+   /** Index of the next unused number in the buffer (`kBufferSize` if all used). */
+   int           fIndxInBuffer;
+   /** Position of the first number of the buffer in the current stream. */
+   std::uint64_t fBufferPosition;
+   /** The pre-generated numbers. */
+   alignas(64) double fBuffer[kBufferSize];
+   //
+   // the Mersenne Twister engine (allocated only if used)
    /** c++11 implementation of the 64-bit Mersenne Twister engine */
-   std::mt19937_64 fEngine;
+   std::unique_ptr<std::mt19937_64> fMTEngine;
    /** uniform distribution: utilises the above random engine to provide random numbers on \f$(0,1)\f$ */
-   std::uniform_real_distribution<double>* fDist;
+   std::uniform_real_distribution<double> fDist;
+   /** The seed of the Mersenne Twister engine in the current stream (used in `SetPosition()`) */
+   std::uint64_t fMTSeed;
 
 };
 
@@ -0,0 +1,228 @@
+
+#include "BasketStepper.hh"
+
+// G4HepEm includes
+#include "G4HepEmTLData.hh"
+#include "G4HepEmState.hh"
+#include "G4HepEmTrack.hh"
+#include "G4HepEmGammaTrack.hh"
+#include "G4HepEmElectronTrack.hh"
+
+#include "G4HepEmData.hh"
+#include "G4HepEmMatCutData.hh"
+
+
+// application local includes
+#include "SteppingLoop.hh"
+#include "TrackBasket.hh"
+#include "TrackStack.hh"
+#include "Physics.hh"
+#include "Geometry.hh"
+#include "Box.hh"
+#include "Results.hh"
+
+
+void BasketStepper::GammaStep(G4HepEmState& theState, TrackStack& theTrackStack, Geometry& theGeometry, Results& theResult, TrackBasket& theBasket, int eventID) {
+  LoadNewTracks(theBasket);
+  Locate(theGeometry, theBasket);
+  GammaHowFar(theState, theBasket);
+  SelectStepAndMove(theBasket);
+  GammaPerform(theState, theTrackStack, theBasket);
+  Score(theResult, theBasket, eventID);
+}
+
+
+void BasketStepper::ElectronStep(G4HepEmState& theState, TrackStack& theTrackStack, Geometry& theGeometry, Results& theResult, TrackBasket& theBasket, int eventID) {
+  LoadNewTracks(theBasket);
+  Locate(theGeometry, theBasket);
+  ElectronHowFar(theState, theBasket);
+  SelectStepAndMove(theBasket);
+  ElectronPerform(theState, theTrackStack, theBasket);
+  Score(theResult, theBasket, eventID);
+}
+
+
+void BasketStepper::LoadNewTracks(TrackBasket& theBasket) {
+  const int size = theBasket.GetSize();
+  for (int i=0; i<size; ++i) {
+    if (!theBasket.fIsNew[i]) {
+      continue;
+    }
+    const G4HepEmTrack* theTrack = theBasket.GetTrack(i);
+    const double* pos = theTrack->GetPosition();
+    const double* dir = theTrack->GetDirection();
+    theBasket.fPosX[i]  = pos[0];
+    theBasket.fPosY[i]  = pos[1];
+    theBasket.fPosZ[i]  = pos[2];
+    theBasket.fDirX[i]  = dir[0];
+    theBasket.fDirY[i]  = dir[1];
+    theBasket.fDirZ[i]  = dir[2];
+    theBasket.fIsNew[i] = 0;
+  }
+}
+
+
+void BasketStepper::Locate(Geometry& theGeometry, TrackBasket& theBasket) {
+  // NOTE: all tracks of the basket are alive at the beginning of the step (the basket is compacted
+  //       after each step) so the batch location is done over the whole structure-of-arrays
+  const int size = theBasket.GetSize();
+  theGeometry.CalculateDistanceToOut(theBasket.fPosX.data(), theBasket.fPosY.data(), theBasket.fPosZ.data(),
+                                     theBasket.fDirX.data(), theBasket.fDirY.data(), theBasket.fDirZ.data(),
+                                     theBasket.fNavState.data(), theBasket.fDistToBoundary.data(), theBasket.fSafety.data(), size);
+  // terminate the history of the tracks that are leaving the calorimeter
+  for (int i=0; i<size; ++i) {
+    theBasket.fIsAlive[i] = theBasket.fDistToBoundary[i] < 1.0E+10;
+  }
+}
+
+
+void BasketStepper::GammaHowFar(G4HepEmState& theState, TrackBasket& theBasket) {
+  const int size = theBasket.GetSize();
+  for (int i=0; i<size; ++i) {
+    if (!theBasket.fIsAlive[i]) {
+      continue;
+    }
+    // set the material-cuts couple index and the onBoundary flag (see `SteppingLoop::GammaStepper`)
+    G4HepEmTrack* theTrack = theBasket.GetTrack(i);
+    const int hepEmIMC = theState.fData->fTheMatCutData->fG4MCIndexToHepEmMCIndex[theBasket.fNavState[i].fVolume->GetMaterialIndx()];
+    theTrack->SetMCIndex(hepEmIMC);
+    theTrack->SetOnBoundary(theBasket.fSafety[i] == 0.0);
+    // invoke `HowFar` directly on the (resident) track of the slot
+    G4HepEmGammaManager::HowFar(theState.fData, theState.fParameters, &theBasket.GetTLData(i));
+    theBasket.fDistToPhysics[i] = theTrack->GetGStepLength();
+  }
+}
+
+
+void BasketStepper::ElectronHowFar(G4HepEmState& theState, TrackBasket& theBasket) {
+  const int size = theBasket.GetSize();
+  for (int i=0; i<size; ++i) {
+    if (!theBasket.fIsAlive[i]) {
+      continue;
+    }
+    // set the material-cuts couple index, the onBoundary flag and the pre-step
+    // point safety (see `SteppingLoop::ElectronStepper`)
+    G4HepEmTrack* theTrack = theBasket.GetTrack(i);
+    const bool onBoundary  = theBasket.fNumSteps[i] == 0 ? (theBasket.fSafety[i] < 5.0E-10) : theBasket.fWasOnBoundary[i] != 0;
+    const int  hepEmIMC    = theState.fData->fTheMatCutData->fG4MCIndexToHepEmMCIndex[theBasket.fNavState[i].fVolume->GetMaterialIndx()];
+    theTrack->SetMCIndex(hepEmIMC);
+    theTrack->SetOnBoundary(onBoundary);
+    theTrack->SetSafety(onBoundary ? 0.0 : theBasket.fSafety[i]);
+    // invoke `HowFar` directly on the (resident) track of the slot
+    G4HepEmElectronManager::HowFar(theState.fData, theState.fParameters, &theBasket.GetTLData(i));
+    theBasket.fDistToPhysics[i] = theTrack->GetGStepLength();
+  }
+}
+
+
+void BasketStepper::SelectStepAndMove(TrackBasket& theBasket) {
+  // NOTE: no function calls in this loop (only the arrays of the basket are used)
+  const int size = theBasket.GetSize();
+  for (int i=0; i<size; ++i) {
+    const bool   isAlive    = theBasket.fIsAlive[i] != 0;
+    const double distToBnd  = theBasket.fDistToBoundary[i];
+    const double distToPhys = theBasket.fDistToPhysics[i];
+    // take the shortest from the geometry and physics step limits
+    const bool   onBoundary = !(distToPhys < distToBnd);
+    double       stepLength = onBoundary ? distToBnd : distToPhys;
+    // apply a small push if the step length is zero (see `SteppingLoop`)
+    const bool   isPushed   = (stepLength == 0.0);
+    stepLength = isPushed ? 1.0E-6 : stepLength;
+    stepLength = isAlive  ? stepLength : 0.0;
+    theBasket.fPosX[i]      += stepLength*theBasket.fDirX[i];
+    theBasket.fPosY[i]      += stepLength*theBasket.fDirY[i];
+    theBasket.fPosZ[i]      += stepLength*theBasket.fDirZ[i];
+    theBasket.fStepLength[i] = stepLength;
+    theBasket.fOnBoundary[i] = onBoundary;
+    theBasket.fIsPushed[i]   = isPushed;
+  }
+}
+
+
+void BasketStepper::GammaPerform(G4HepEmState& theState, TrackStack& theTrackStack, TrackBasket& theBasket) {
+  const int size = theBasket.GetSize();
+  for (int i=0; i<size; ++i) {
+    if (!theBasket.fIsAlive[i] || theBasket.fIsPushed[i]) {
+      continue;
+    }
+    // set the post-step point state of the (resident) track of the slot
+    G4HepEmTLData& theTLData = theBasket.GetTLData(i);
+    G4HepEmTrack*  theTrack  = theBasket.GetTrack(i);
+    theTrack->SetPosition(theBasket.fPosX[i], theBasket.fPosY[i], theBasket.fPosZ[i]);
+    theTrack->SetGStepLength(theBasket.fStepLength[i]);
+    theTrack->SetOnBoundary(theBasket.fOnBoundary[i] != 0);
+    G4HepEmGammaManager::Perform(theState.fData, theState.fParameters, &theTLData);
+    // stack the secondaries (if any) then take back the updated direction
+    if (theTLData.GetNumSecondaryElectronTrack() + theTLData.GetNumSecondaryGammaTrack() > 0 ) {
+      SteppingLoop::StackSecondaries(theTLData, theTrackStack, *theTrack);
+    }
+    const double* dir = theTrack->GetDirection();
+    theBasket.fDirX[i] = dir[0];
+    theBasket.fDirY[i] = dir[1];
+    theBasket.fDirZ[i] = dir[2];
+    theBasket.fPhysStepLength[i] = theBasket.fStepLength[i];
+  }
+}
+
+
+void BasketStepper::ElectronPerform(G4HepEmState& theState, TrackStack& theTrackStack, TrackBasket& theBasket) {
+  const int size = theBasket.GetSize();
+  for (int i=0; i<size; ++i) {
+    if (!theBasket.fIsAlive[i] || theBasket.fIsPushed[i]) {
+      continue;
+    }
+    const bool   onBoundary = theBasket.fOnBoundary[i] != 0;
+    const double stepLength = theBasket.fStepLength[i];
+    theBasket.fWasOnBoundary[i] = onBoundary;
+    // set the post-step point state of the (resident) track of the slot
+    G4HepEmTLData&       theTLData  = theBasket.GetTLData(i);
+    G4HepEmTrack*        theTrack   = theBasket.GetTrack(i);
+    G4HepEmMSCTrackData* theMSCData = theBasket.GetElectronTrack(i).GetMSCTrackData();
+    theTrack->SetPosition(theBasket.fPosX[i], theBasket.fPosY[i], theBasket.fPosZ[i]);
+    theTrack->SetGStepLength(stepLength);
+    theTrack->SetOnBoundary(onBoundary);
+    // keep the original direction as it will be changed during the physics
+    const double orgDirection[3] = { theBasket.fDirX[i], theBasket.fDirY[i], theBasket.fDirZ[i] };
+    G4HepEmElectronManager::Perform(theState.fData, theState.fParameters, &theTLData);
+    // the real, i.e. physical step length (see `SteppingLoop::ElectronStepper`)
+    theBasket.fPhysStepLength[i] = theMSCData->fTrueStepLength > 0.0 ? theMSCData->fTrueStepLength : stepLength;
+    // apply the MSC displacement if the post-step point is not on boundary
+    if (!onBoundary) {
+      NavigationState& theNavState = theBasket.fNavState[i];
+      SteppingLoop::ApplyMSCDisplacement(*theTrack, *theMSCData, theNavState.fVolume, theNavState.fLocalPosition, orgDirection, stepLength);
+    }
+    // stack the secondaries (if any) then take back the updated position and direction
+    if (theTLData.GetNumSecondaryElectronTrack() + theTLData.GetNumSecondaryGammaTrack() > 0 ) {
+      SteppingLoop::StackSecondaries(theTLData, theTrackStack, *theTrack);
+    }
+    const double* pos = theTrack->GetPosition();
+    const double* dir = theTrack->GetDirection();
+    theBasket.fPosX[i] = pos[0];
+    theBasket.fPosY[i] = pos[1];
+    theBasket.fPosZ[i] = pos[2];
+    theBasket.fDirX[i] = dir[0];
+    theBasket.fDirY[i] = dir[1];
+    theBasket.fDirZ[i] = dir[2];
+  }
+}
+
+
+void BasketStepper::Score(Results& theResult, TrackBasket& theBasket, int eventID) {
+  const int size = theBasket.GetSize();
+  for (int i=0; i<size; ++i) {
+    if (!theBasket.fIsAlive[i]) {
+      continue;
+    }
+    // only count the zero distance iterations (the track was pushed without a step)
+    if (theBasket.fIsPushed[i]) {
+      theResult.fPerEventRes.fNumZeroSteps += 1.0;
+      continue;
+    }
+    const G4HepEmTrack* theTrack = theBasket.GetTrack(i);
+    const NavigationState& theNavState = theBasket.fNavState[i];
+    SteppingLoop::SteppingAction(theResult, *theTrack, theNavState.fVolume, theBasket.fPhysStepLength[i], theNavState.fIndxLayer, theNavState.fIndxAbs, theNavState.fIndxCell, eventID, theBasket.fNumSteps[i]);
+    ++theBasket.fNumSteps[i];
+    // terminate the history when the kinetic energy drops to zero
+    theBasket.fIsAlive[i] = theTrack->GetEKin() > 0.0;
+  }
+}
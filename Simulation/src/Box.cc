@@ -6,6 +6,11 @@
 #include <sstream>
 #include <cmath>
 
+// vector instructions are used in the batch methods if the code is compiled for a target that supports them
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 
 Box::Box (const std::string& name, int indxMat, double pX, double pY, double pZ)
 : fName(name),
@@ -97,6 +102,116 @@ double Box::DistanceToOut(double* p) const {
 }
 
 
+// NOTE: the same operations, in the same order, as in the single point versions above (the
+//       `std::min(a,b)` is `(b<a) ? b : a` that is `min(b,a)` in the vector instructions)
+void Box::DistanceToOut(const double* rx, const double* ry, const double* rz, const double* vx, const double* vy, const double* vz, double* dist, int num) const {
+  int i = 0;
+#if defined(__AVX512F__)
+  const __m512i signMask = _mm512_castpd_si512(_mm512_set1_pd(-0.0));
+  const __m512d dx       = _mm512_set1_pd(fDx);
+  const __m512d dy       = _mm512_set1_pd(fDy);
+  const __m512d dz       = _mm512_set1_pd(fDz);
+  const __m512d negDelta = _mm512_set1_pd(-fDelta);
+  const __m512d zero     = _mm512_setzero_pd();
+  const __m512d large    = _mm512_set1_pd(1.0E+20);
+  for (; i+8<=num; i+=8) {
+    const __m512d px = _mm512_loadu_pd(rx+i);
+    const __m512d py = _mm512_loadu_pd(ry+i);
+    const __m512d pz = _mm512_loadu_pd(rz+i);
+    const __m512d ux = _mm512_loadu_pd(vx+i);
+    const __m512d uy = _mm512_loadu_pd(vy+i);
+    const __m512d uz = _mm512_loadu_pd(vz+i);
+    // not inside and travelling away along any of the axes: zero
+    const __mmask8 isOut = (_mm512_cmp_pd_mask(_mm512_sub_pd(_mm512_abs_pd(px), dx), negDelta, _CMP_GE_OQ) & _mm512_cmp_pd_mask(_mm512_mul_pd(px, ux), zero, _CMP_GT_OQ))
+                         | (_mm512_cmp_pd_mask(_mm512_sub_pd(_mm512_abs_pd(py), dy), negDelta, _CMP_GE_OQ) & _mm512_cmp_pd_mask(_mm512_mul_pd(py, uy), zero, _CMP_GT_OQ))
+                         | (_mm512_cmp_pd_mask(_mm512_sub_pd(_mm512_abs_pd(pz), dz), negDelta, _CMP_GE_OQ) & _mm512_cmp_pd_mask(_mm512_mul_pd(pz, uz), zero, _CMP_GT_OQ));
+    // intersections (the copysign is done on the bits)
+    const __m512d sx  = _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(dx), _mm512_and_si512(_mm512_castpd_si512(ux), signMask)));
+    const __m512d tx  = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(ux, zero, _CMP_EQ_OQ), _mm512_div_pd(_mm512_sub_pd(sx, px), ux), large);
+    const __m512d sy  = _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(dy), _mm512_and_si512(_mm512_castpd_si512(uy), signMask)));
+    const __m512d ty  = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(uy, zero, _CMP_EQ_OQ), _mm512_div_pd(_mm512_sub_pd(sy, py), uy), tx);
+    const __m512d txy = _mm512_min_pd(ty, tx);
+    const __m512d sz  = _mm512_castsi512_pd(_mm512_or_si512(_mm512_castpd_si512(dz), _mm512_and_si512(_mm512_castpd_si512(uz), signMask)));
+    const __m512d tz  = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(uz, zero, _CMP_EQ_OQ), _mm512_div_pd(_mm512_sub_pd(sz, pz), uz), txy);
+    const __m512d tmax = _mm512_min_pd(tz, txy);
+    _mm512_storeu_pd(dist+i, _mm512_mask_blend_pd(isOut, tmax, zero));
+  }
+#elif defined(__AVX2__)
+  const __m256d signMask = _mm256_set1_pd(-0.0);
+  const __m256d dx       = _mm256_set1_pd(fDx);
+  const __m256d dy       = _mm256_set1_pd(fDy);
+  const __m256d dz       = _mm256_set1_pd(fDz);
+  const __m256d negDelta = _mm256_set1_pd(-fDelta);
+  const __m256d zero     = _mm256_setzero_pd();
+  const __m256d large    = _mm256_set1_pd(1.0E+20);
+  for (; i+4<=num; i+=4) {
+    const __m256d px = _mm256_loadu_pd(rx+i);
+    const __m256d py = _mm256_loadu_pd(ry+i);
+    const __m256d pz = _mm256_loadu_pd(rz+i);
+    const __m256d ux = _mm256_loadu_pd(vx+i);
+    const __m256d uy = _mm256_loadu_pd(vy+i);
+    const __m256d uz = _mm256_loadu_pd(vz+i);
+    // not inside and travelling away along any of the axes: zero
+    const __m256d isOutX = _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(_mm256_andnot_pd(signMask, px), dx), negDelta, _CMP_GE_OQ), _mm256_cmp_pd(_mm256_mul_pd(px, ux), zero, _CMP_GT_OQ));
+    const __m256d isOutY = _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(_mm256_andnot_pd(signMask, py), dy), negDelta, _CMP_GE_OQ), _mm256_cmp_pd(_mm256_mul_pd(py, uy), zero, _CMP_GT_OQ));
+    const __m256d isOutZ = _mm256_and_pd(_mm256_cmp_pd(_mm256_sub_pd(_mm256_andnot_pd(signMask, pz), dz), negDelta, _CMP_GE_OQ), _mm256_cmp_pd(_mm256_mul_pd(pz, uz), zero, _CMP_GT_OQ));
+    const __m256d isOut  = _mm256_or_pd(_mm256_or_pd(isOutX, isOutY), isOutZ);
+    // intersections (the copysign is done on the bits)
+    const __m256d tx  = _mm256_blendv_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_or_pd(dx, _mm256_and_pd(ux, signMask)), px), ux), large, _mm256_cmp_pd(ux, zero, _CMP_EQ_OQ));
+    const __m256d ty  = _mm256_blendv_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_or_pd(dy, _mm256_and_pd(uy, signMask)), py), uy), tx, _mm256_cmp_pd(uy, zero, _CMP_EQ_OQ));
+    const __m256d txy = _mm256_min_pd(ty, tx);
+    const __m256d tz  = _mm256_blendv_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_or_pd(dz, _mm256_and_pd(uz, signMask)), pz), uz), txy, _mm256_cmp_pd(uz, zero, _CMP_EQ_OQ));
+    const __m256d tmax = _mm256_min_pd(tz, txy);
+    _mm256_storeu_pd(dist+i, _mm256_blendv_pd(tmax, zero, isOut));
+  }
+#endif
+  // scalar fallback (and the remaining points)
+  for (; i<num; ++i) {
+    double p[3] = {rx[i], ry[i], rz[i]};
+    double v[3] = {vx[i], vy[i], vz[i]};
+    dist[i] = DistanceToOut(p, v);
+  }
+}
+
+
+void Box::DistanceToOut(const double* rx, const double* ry, const double* rz, double* safety, int num) const {
+  int i = 0;
+#if defined(__AVX512F__)
+  const __m512d dx   = _mm512_set1_pd(fDx);
+  const __m512d dy   = _mm512_set1_pd(fDy);
+  const __m512d dz   = _mm512_set1_pd(fDz);
+  const __m512d zero = _mm512_setzero_pd();
+  for (; i+8<=num; i+=8) {
+    const __m512d sx   = _mm512_sub_pd(dx, _mm512_abs_pd(_mm512_loadu_pd(rx+i)));
+    const __m512d sy   = _mm512_sub_pd(dy, _mm512_abs_pd(_mm512_loadu_pd(ry+i)));
+    const __m512d sz   = _mm512_sub_pd(dz, _mm512_abs_pd(_mm512_loadu_pd(rz+i)));
+    const __m512d dist = _mm512_min_pd(sz, _mm512_min_pd(sy, sx));
+    // `(dist > 0) ? dist : 0` is `max(dist,0)` in the vector instructions
+    _mm512_storeu_pd(safety+i, _mm512_max_pd(dist, zero));
+  }
+#elif defined(__AVX2__)
+  const __m256d signMask = _mm256_set1_pd(-0.0);
+  const __m256d dx       = _mm256_set1_pd(fDx);
+  const __m256d dy       = _mm256_set1_pd(fDy);
+  const __m256d dz       = _mm256_set1_pd(fDz);
+  const __m256d zero     = _mm256_setzero_pd();
+  for (; i+4<=num; i+=4) {
+    const __m256d sx   = _mm256_sub_pd(dx, _mm256_andnot_pd(signMask, _mm256_loadu_pd(rx+i)));
+    const __m256d sy   = _mm256_sub_pd(dy, _mm256_andnot_pd(signMask, _mm256_loadu_pd(ry+i)));
+    const __m256d sz   = _mm256_sub_pd(dz, _mm256_andnot_pd(signMask, _mm256_loadu_pd(rz+i)));
+    const __m256d dist = _mm256_min_pd(sz, _mm256_min_pd(sy, sx));
+    // `(dist > 0) ? dist : 0` is `max(dist,0)` in the vector instructions
+    _mm256_storeu_pd(safety+i, _mm256_max_pd(dist, zero));
+  }
+#endif
+  // scalar fallback (and the remaining points)
+  for (; i<num; ++i) {
+    double p[3] = {rx[i], ry[i], rz[i]};
+    safety[i] = DistanceToOut(p);
+  }
+}
+
+
 /*
 EInside Box::Inside(double rx, double ry, double rz) const {
   double dist = std::max ( std::max (
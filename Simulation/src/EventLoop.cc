@@ -4,6 +4,8 @@
 
 #include "G4HepEmTLData.hh"
 #include "G4HepEmState.hh"
+#include "G4HepEmRandomEngine.hh"
+#include "URandom.hh"
 
 #include "PrimaryGenerator.hh"
 #include "Geometry.hh"
@@ -11,32 +13,104 @@
 
 #include "TrackStack.hh"
 #include "SteppingLoop.hh"
+#include "TrackBasket.hh"
+#include "BasketStepper.hh"
+#include "NumaPlacement.hh"
+#include "StepTiming.hh"
 
 
 #include "sys/time.h"
 #include <ctime>
 #include <iostream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+#include <condition_variable>
 
 
-void EventLoop::ProcessEvents(G4HepEmTLData& theTLData, G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, Results& theResult, int numEventToSimulate, int verbosity) {
-  //
-  // first create the container for the tracks, i.e. the track-stack:
-  // - before and at the end of a given event processing: empty
-  // - at the start of a new event: all tracks of a new event are inserted
-  //   (using the `PrimaryGenerator`) that is a single primary track in our case
-  //   (however, should be no problem adding more than one primary tracks)
-  // - during the processing of a given event:
-  //     - one track is popped and tracked till the end of its history
-  //     - while all generated secondary tracks (if any) are pushed to the stack
-  TrackStack theTrackStack;
+// serialises the progress reports of the workers
+static std::mutex gOutputMutex;
+
+
+// A simple (reusable) barrier: all the `fNumThreads` workers wait in `Wait()`
+// till the last of them arrives.
+class Barrier {
+public:
+  Barrier(int numThreads) : fNumThreads(numThreads), fNumWaiting(0), fGeneration(0) {}
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(fMutex);
+    const int generation = fGeneration;
+    if (++fNumWaiting == fNumThreads) {
+      fNumWaiting = 0;
+      ++fGeneration;
+      fCondition.notify_all();
+    } else {
+      fCondition.wait(lock, [&] { return generation != fGeneration; });
+    }
+  }
+
+private:
+  int                     fNumThreads;
+  int                     fNumWaiting;
+  int                     fGeneration;
+  std::mutex              fMutex;
+  std::condition_variable fCondition;
+};
+
+
+// The parallel tree reduction of the per-thread `Results` replicas into the first:
+// all workers take part in each round (see `ReduceResultsStep`) then wait for the
+// others before the next round (so each replica is complete when it's merged).
+static void ReduceReplicas(const std::vector<Results*>& theReplicas, int threadID, Barrier& theBarrier) {
+  const int numReplicas = static_cast<int>(theReplicas.size());
+  for (int stride=1; stride<numReplicas; stride*=2) {
+    theBarrier.Wait();
+    ReduceResultsStep(theReplicas, threadID, stride);
+  }
+}
+
+
+// Data shared by the workers that process the same event in the sub-event
+// parallel mode (see `EventLoop::SubEventWorker`).
+struct SubEventTeam {
+  SubEventTeam(int numThreads)
+  : fNumThreads(numThreads), fTrackStacks(numThreads, nullptr), fResults(numThreads, nullptr), fNumPendingTracks(0), fBarrier(numThreads) {}
+
+  int                      fNumThreads;        // number of workers in the team
+  std::vector<TrackStack*> fTrackStacks;       // the track stacks (work-stealing deques) of the workers
+  std::vector<Results*>    fResults;           // the results of the workers
+  std::atomic<int>         fNumPendingTracks;  // tracks of the current event that are still to be finished
+  Barrier                  fBarrier;           // to synchronise the workers at the beginning and end of each event
+};
+
+
+void EventLoop::ProcessEvents(G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, Results& theResult, int numEventToSimulate, int firstEventID, int numThreads, bool isSubEventParallel, int basketSize, int randomSeed, int randomEngine, NumaPlacement* theNumaPlacement, int verbosity) {
   //
   // report progress
   if (verbosity > 0) {
-    std::cout << " --- EventLoop::ProcessEvents: starts simulation of N = " << numEventToSimulate << " events..." << std::endl;
+    std::cout << " --- EventLoop::ProcessEvents: starts simulation of N = " << numEventToSimulate << " events";
+    if (numThreads > 1) {
+      std::cout << " by " << numThreads << " worker threads";
+      if (isSubEventParallel) {
+        std::cout << " (sharing the tracks of each event)";
+      }
+    }
+    if (basketSize > 0) {
+      std::cout << " with basket based stepping (" << basketSize << " tracks per basket)";
+    }
+    std::cout << "..." << std::endl;
   }
   //
-  // init the event ID (counter) to zero
-  int eventID = 0;
+  // the event counter shared by all workers: each worker takes the index of the
+  // next event to simulate from here (so the events are shared dynamically)
+  std::atomic<int> theEventCounter(0);
+#ifdef HEPEMSHOW_STEP_TIMING
+  StepTiming::Reset();
+#endif
   // set the initial time stamp to meaure the event processing time
   struct timeval start;
   gettimeofday(&start, NULL);
@@ -46,97 +120,74 @@ void EventLoop::ProcessEvents(G4HepEmTLData& theTLData, G4HepEmState& theState,
     reportProgress = std::max(1, numEventToSimulate/10);
   }
   //
-  // enter to the event loop: generate and simulate as many events as required
-  while (eventID < numEventToSimulate) {
-    // report progress if it was rquested
-    if ( verbosity > 0 && (eventID+1) % reportProgress == 0) {
-      std::cout << "      - starts processing #event = " << (eventID+1) << std::endl;
-    }
-    //
-    // 0. Reset the track ID before each new event such that it starts from zero again.
-    theTrackStack.ReSetTrackID();
-    //
-    // 1. Generate the primary track of this event:
-    // NOTE: each event is assumed to have one primary now just for simplicity
-    //       (no problem though with inserting more than one primary into the stack)
-    // - the primary track is the very first track in the stack, so obtain one
-    //   track reference from the stack and generate one primary into that
-    G4HepEmTrack& primaryTrack = theTrackStack.Insert();
-    thePrimaryGenerator.GenerateOne(primaryTrack);
-    primaryTrack.SetID(theTrackStack.GetNextTrackID());
-    //
-    // 2. Invoke the beginning of event action (by passing the current primary track)
-    BeginOfEventAction(theResult, eventID, primaryTrack);
-    //
-    //
-    // 3. While the track-stack becomes empty:
-    //   - pop-up one track (into the `HepEmTLData` primary electron/gamma track)
-    //   - track this particle till the end of its history in a step-by-step way
-    //     NOTE: secondaries are insterted into the track-stack after each step
-    //   Processing/simulation of this event is completed when the track-stack
-    //   becomes empty again
-    //   NOTE: `GetTypeOfNextTrack` returns -1, 0, +1 if the next track in the
-    //          stack is an e-, gamma or e+, while -999 in case of empty stack.
-    int trackType = -1;
-    while ( (trackType = theTrackStack.GetTypeOfNextTrack()) > -2 ) {
-      G4HepEmTrack* nextTrack = nullptr;
-      // depending if the next track is a gamma or e-/e+ track:
-      if (trackType == 0) { // the next track is a gamma
-        // - obtain the primary gamma track from the TL-data which the next track
-        //   from the stack will be popped into
-        G4HepEmGammaTrack* gTrack = theTLData.GetPrimaryGammaTrack();
-        // - perform the before "start-tracking" procedure: reset the track
-        //   properties and the random engine (throw away cached rnd number)
-        gTrack->ReSet();
-        theTLData.GetRNGEngine()->DiscardGauss();
-        // - get the common track part of this primary track
-        nextTrack = gTrack->GetTrack();
-      } else { // the next track is an e- or e+
-        // - obtain the primary electron track from the TL-data which the next track
-        //   from the stack will be popped into
-        G4HepEmElectronTrack* eTrack = theTLData.GetPrimaryElectronTrack();
-        // - perform the before "start-tracking" procedure: reset the track
-        //   properties and the random engine (throw away cached rnd number)
-        eTrack->ReSet();
-        theTLData.GetRNGEngine()->DiscardGauss();
-        // - get the common track part of this primary track
-        nextTrack = eTrack->GetTrack();
-      }
-      // - pop the next track from the stack into this
-      theTrackStack.PopInto(*nextTrack);
-      // - the simplified "navigation" assumes, that tracks start from inside
-      //   the `calorimeter` volume. This is true for secondary (ParentID > -1)
-      //   tracks by default as they are generated inside the calorimeter but
-      //   not for primary tracks (ParentID = -1) generated outside of the
-      //   calorimeter volume (in the vacuum, pointing to the calorimeter).
-      //   Therefore, primaries need to be moved to the calorimeter boundary
-      //   (as they point into the calorimeter they will be inside then).
-      if (nextTrack->GetParentID() < 0) {
-        double* pos = nextTrack->GetPosition();
-        pos[0] = theGeometry.GetCaloStartXposition();
+  // the calling thread is the first worker: it collects its data directly into
+  // `theResult` while all other workers have their own copy of `theResult` (with
+  // the histograms already set but still empty) that are merged at the end
+  //  NOTE: the replicas are reduced into `theResult` by the workers themselves by
+  //        a parallel tree reduction (see `ReduceResultsStep`)
+  //  NOTE: each worker makes its own copy (from the prototype, since the first
+  //        worker already fills `theResult`) so it's allocated, i.e. first touched,
+  //        by the worker itself (after pinning it when NUMA placement is used)
+  //  NOTE: the scoring mesh of the replicas has only its per-event hash and the
+  //        events are flushed directly into the run level grid of `theResult`
+  //        (the grid is not replicated, see `CopyResultsForReplica`)
+  Results thePrototype;
+  CopyResultsForReplica(thePrototype, theResult);
+  std::vector<std::unique_ptr<Results>> theWorkerResults(numThreads);
+  // the state used by the given worker: the worker is pinned and the replica of its NUMA
+  // node is used if the NUMA placement is required (the shared state otherwise)
+  auto theWorkerState = [&](int it) -> G4HepEmState& {
+    return theNumaPlacement != nullptr ? theNumaPlacement->SetUpWorker(it) : theState;
+  };
+  if (numThreads < 2) {
+    Worker(theWorkerState(0), thePrimaryGenerator, theGeometry, theResult, theEventCounter, numEventToSimulate, firstEventID, basketSize, randomSeed, randomEngine, reportProgress);
+  } else if (!isSubEventParallel) {
+    std::vector<Results*> theReplicas(numThreads, &theResult);
+    Barrier theBarrier(numThreads);
+    auto theWorkerTask = [&](int it) {
+      G4HepEmState& theLocalState = theWorkerState(it);
+      if (it > 0) {
+        theWorkerResults[it].reset(new Results(thePrototype));
+        theReplicas[it] = theWorkerResults[it].get();
       }
-      // - invoke the beginning of tracking action before start tracking this track
-      BeginOfTrackingAction(theResult, *nextTrack);
-      // - call the gamma/electron stepper to simulate the entire history of this
-      //   next-track (provided now in the primary gamma/electron track member of
-      //   the TL-data)
-      //   NOTE: the secondaries, generated during the simulation of the history
-      //         of this track, are all inserted into the track stack.
-      if (trackType == 0) { // the next track is a gamma
-        SteppingLoop::GammaStepper(theTLData, theState, theTrackStack, theGeometry, theResult, eventID);
-      } else {              // the next track is an e- or e+
-        SteppingLoop::ElectronStepper(theTLData, theState, theTrackStack, theGeometry, theResult, eventID);
+      Worker(theLocalState, thePrimaryGenerator, theGeometry, *theReplicas[it], theEventCounter, numEventToSimulate, firstEventID, basketSize, randomSeed, randomEngine, reportProgress);
+      ReduceReplicas(theReplicas, it, theBarrier);
+    };
+    std::vector<std::thread> theWorkers;
+    for (int it=1; it<numThreads; ++it) {
+      theWorkers.emplace_back(theWorkerTask, it);
+    }
+    theWorkerTask(0);
+    for (auto& theWorker : theWorkers) {
+      theWorker.join();
+    }
+  } else {
+    // all workers process the same event (one after the other) by sharing its tracks
+    SubEventTeam theTeam(numThreads);
+    theTeam.fResults[0] = &theResult;
+    auto theWorkerTask = [&](int it) {
+      G4HepEmState& theLocalState = theWorkerState(it);
+      // NOTE: the results are accessed by the other workers only after the first barrier in `SubEventWorker`
+      if (it > 0) {
+        theWorkerResults[it].reset(new Results(thePrototype));
+        theTeam.fResults[it] = theWorkerResults[it].get();
       }
-      // - invoke the end of tracking action when the end of its simulation history is reached
-      EndOfTrackingAction(theResult, *nextTrack);
+      SubEventWorker(it, theTeam, theLocalState, thePrimaryGenerator, theGeometry, numEventToSimulate, firstEventID, randomSeed, randomEngine, reportProgress);
+      ReduceReplicas(theTeam.fResults, it, theTeam.fBarrier);
     };
-    //
-    // 4. Call the end of event action
-    EndOfEventAction(theResult, eventID);
-    //
-    // increase the event ID (i.e. counter of simulated events)
-    ++eventID;;
-  };
+    std::vector<std::thread> theWorkers;
+    for (int it=1; it<numThreads; ++it) {
+      theWorkers.emplace_back(theWorkerTask, it);
+    }
+    theWorkerTask(0);
+    for (auto& theWorker : theWorkers) {
+      theWorker.join();
+    }
+  }
+  // the calling thread (the first worker) gets back its original affinity
+  if (theNumaPlacement != nullptr) {
+    theNumaPlacement->TearDownWorker(0);
+  }
   //
   // calculate and report the event processing time
   struct timeval finish;
@@ -144,10 +195,335 @@ void EventLoop::ProcessEvents(G4HepEmTLData& theTLData, G4HepEmState& theState,
   const double theTime = ((double)(finish.tv_sec-start.tv_sec)*1000000 + (double)(finish.tv_usec-start.tv_usec)) / 1000000;
   if (verbosity > 0) {
     std::cout << " --- EventLoop::ProcessEvents: completed simulation within t = " << theTime << " [s]" << std::endl;
+    if (theNumaPlacement != nullptr) {
+      theNumaPlacement->Report();
+    }
+#ifdef HEPEMSHOW_STEP_TIMING
+    StepTiming::Report();
+#endif
+  }
+}
+
+
+void EventLoop::Worker(G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, Results& theResult, std::atomic<int>& theEventCounter, int numEventToSimulate, int firstEventID, int basketSize, int randomSeed, int randomEngine, int reportProgress) {
+  //
+  // `G4HepEmTLData` encapsulates "thread-local" (i.e. TL) data like:
+  // - the random number generator (will be constructed and set below)
+  // - the primary/secondary tracks used to provide/receive tracks to/from the
+  //   G4HepEm run-time functioinalities
+  G4HepEmTLData theTLData;
+  // construct a HepEm random number generator, using our local uniform `URandom`
+  // generator, then set it to be used in the above TLdata
+  // NOTE: each worker has its own generator that is re-seeded for each event
+  URandom             theURnd(randomSeed, static_cast<URandom::EngineType>(randomEngine));
+  G4HepEmRandomEngine theRandomEngine(&theURnd);
+  theTLData.SetRandomEngine(&theRandomEngine);
+  //
+  // create the container for the tracks, i.e. the track-stack:
+  // - before and at the end of a given event processing: empty
+  // - at the start of a new event: all tracks of a new event are inserted
+  //   (using the `PrimaryGenerator`) that is a single primary track in our case
+  //   (however, should be no problem adding more than one primary tracks)
+  // - during the processing of a given event:
+  //     - one track is popped and tracked till the end of its history
+  //     - while all generated secondary tracks (if any) are pushed to the stack
+  TrackStack theTrackStack;
+  //
+  // create the baskets of the in-flight gamma and e-/e+ tracks if the basket
+  // based stepping engine was required (history based otherwise)
+  std::unique_ptr<TrackBasket> theGammaBasket;
+  std::unique_ptr<TrackBasket> theElectronBasket;
+  if (basketSize > 0) {
+    theGammaBasket.reset(new TrackBasket(true, basketSize, &theRandomEngine));
+    theElectronBasket.reset(new TrackBasket(false, basketSize, &theRandomEngine));
+  }
+  //
+  // enter to the event loop: take the next event and simulate it while there
+  // are events left to simulate
+  int eventIndx = 0;
+  while ((eventIndx = theEventCounter.fetch_add(1)) < numEventToSimulate) {
+    // report progress if it was rquested
+    if (reportProgress > 0 && (eventIndx+1) % reportProgress == 0) {
+      std::lock_guard<std::mutex> lock(gOutputMutex);
+      std::cout << "      - starts processing #event = " << (eventIndx+1) << std::endl;
+    }
+    // start the random number stream that belongs to this event: makes the
+    // simulation of the event independent from the worker and the order
+    const int eventID = firstEventID + eventIndx;
+    theURnd.SetSeed(randomSeed, eventID);
+    ProcessEvent(theTLData, theState, thePrimaryGenerator, theGeometry, theTrackStack, theGammaBasket.get(), theElectronBasket.get(), theResult, eventID);
+  }
+}
+
+
+void EventLoop::SubEventWorker(int threadID, SubEventTeam& theTeam, G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, int numEventToSimulate, int firstEventID, int randomSeed, int randomEngine, int reportProgress) {
+  const int numThreads = theTeam.fNumThreads;
+  Results&  theResult  = *theTeam.fResults[threadID];
+  // the thread local data, random engine and track stack of this worker (see `Worker` above)
+  G4HepEmTLData       theTLData;
+  URandom             theURnd(randomSeed, static_cast<URandom::EngineType>(randomEngine));
+  G4HepEmRandomEngine theRandomEngine(&theURnd);
+  theTLData.SetRandomEngine(&theRandomEngine);
+  // the track stack is used as a work-stealing deque: it's set to `shared` mode
+  // and gives unique track IDs over all the stacks of the team
+  TrackStack theTrackStack;
+  theTrackStack.SetShared(&theTeam.fNumPendingTracks);
+  theTrackStack.SetTrackIDs(threadID, numThreads);
+  theTeam.fTrackStacks[threadID] = &theTrackStack;
+  // auxiliary track into which the stolen tracks are copied first (their type
+  // is known only after stealing)
+  G4HepEmTrack theStolenTrack;
+  //
+  // make sure that all stacks are registered before any stealing
+  theTeam.fBarrier.Wait();
+  for (int eventIndx=0; eventIndx<numEventToSimulate; ++eventIndx) {
+    const int eventID = firstEventID + eventIndx;
+    // the tracks of an event are shared dynamically so the random number
+    // sequence of the event depends on the scheduling anyway: each worker
+    // uses its own stream for the given event
+    theURnd.SetSeed(URandom::SplitMix64(randomSeed) + threadID, eventID);
+    theTrackStack.ReSetTrackID();
+    // the first worker generates the primary track and invokes the beginning
+    // of event action
+    if (threadID == 0) {
+      if (reportProgress > 0 && (eventIndx+1) % reportProgress == 0) {
+        std::lock_guard<std::mutex> lock(gOutputMutex);
+        std::cout << "      - starts processing #event = " << (eventIndx+1) << std::endl;
+      }
+      G4HepEmTrack thePrimaryTrack;
+      thePrimaryGenerator.GenerateOne(thePrimaryTrack);
+      thePrimaryTrack.SetID(theTrackStack.GetNextTrackID());
+      BeginOfEventAction(theResult, eventID, thePrimaryTrack);
+      theTrackStack.Push(thePrimaryTrack);
+    }
+    // wait till the event starts then reset the per-event accumulators of the
+    // other workers (the first worker have already read them, see below)
+    theTeam.fBarrier.Wait();
+    if (threadID > 0) {
+      theResult.fPerEventRes = ResultsPerEvent();
+    }
+    // simulate tracks of this event while there is any pending:
+    // - first from the own stack (depth first, from the top)
+    // - then stealing from the other workers (the oldest, from the bottom)
+    while (theTeam.fNumPendingTracks.load() > 0) {
+      const int trackType = theTrackStack.GetTypeOfNextTrack();
+      if (trackType > -2) {
+        G4HepEmTrack* nextTrack = PrepareTrack(theTLData, trackType);
+        // the track might have been stolen since its type was obtained
+        if (theTrackStack.PopInto(*nextTrack) > -1) {
+          SimulateTrack(theTLData, theState, theGeometry, theTrackStack, theResult, *nextTrack, trackType, eventID);
+          theTeam.fNumPendingTracks.fetch_sub(1);
+        }
+        continue;
+      }
+      bool isStolen = false;
+      for (int iv=1; iv<numThreads && !isStolen; ++iv) {
+        TrackStack* theVictim = theTeam.fTrackStacks[(threadID+iv)%numThreads];
+        isStolen = theVictim->StealInto(theStolenTrack) > -1;
+      }
+      if (isStolen) {
+        const int stolenType = theStolenTrack.GetCharge();
+        G4HepEmTrack* nextTrack = PrepareTrack(theTLData, stolenType);
+        *nextTrack = theStolenTrack;
+        SimulateTrack(theTLData, theState, theGeometry, theTrackStack, theResult, *nextTrack, stolenType, eventID);
+        theTeam.fNumPendingTracks.fetch_sub(1);
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    // the other workers flush their own per-event hash of the scoring mesh (into
+    // the shared run level grid) before the end of the event
+    if (threadID > 0) {
+      theResult.fEdepMesh.EndOfEvent();
+    }
+    // wait till all workers completed then the first worker merges the data,
+    // collected by all workers during this event, and invokes the end of event
+    // action
+    //  NOTE: the results of the other workers are not updated till the next
+    //        event starts so an intermediate snapshot can be taken here
+    theTeam.fBarrier.Wait();
+    if (threadID == 0) {
+      for (int it=1; it<numThreads; ++it) {
+        MergeResultsPerEvent(theResult.fPerEventRes, theTeam.fResults[it]->fPerEventRes);
+      }
+      EndOfEventAction(theResult, eventID);
+      if (reportProgress > 0 && (eventIndx+1) % reportProgress == 0) {
+        ReportSnapshot(theTeam.fResults, eventIndx+1);
+      }
+    }
+  }
+}
+
+
+void EventLoop::ProcessEvent(G4HepEmTLData& theTLData, G4HepEmState& theState, PrimaryGenerator& thePrimaryGenerator, Geometry& theGeometry, TrackStack& theTrackStack, TrackBasket* theGammaBasket, TrackBasket* theElectronBasket, Results& theResult, int eventID) {
+  //
+  // 0. Reset the track ID before each new event such that it starts from zero again.
+  theTrackStack.ReSetTrackID();
+  //
+  // 1. Generate the primary track of this event:
+  // NOTE: each event is assumed to have one primary now just for simplicity
+  //       (no problem though with inserting more than one primary into the stack)
+  // - the primary track is the very first track in the stack, so generate one
+  //   primary and push that into the stack
+  G4HepEmTrack primaryTrack;
+  thePrimaryGenerator.GenerateOne(primaryTrack);
+  primaryTrack.SetID(theTrackStack.GetNextTrackID());
+  theTrackStack.Push(primaryTrack);
+  //
+  // 2. Invoke the beginning of event action (by passing the current primary track)
+  BeginOfEventAction(theResult, eventID, primaryTrack);
+  //
+  //
+  // 3. While the track-stack becomes empty:
+  //   - pop-up one track (into the `HepEmTLData` primary electron/gamma track)
+  //   - track this particle till the end of its history in a step-by-step way
+  //     NOTE: secondaries are insterted into the track-stack after each step
+  //   Processing/simulation of this event is completed when the track-stack
+  //   becomes empty again
+  //   NOTE: `GetTypeOfNextTrack` returns -1, 0, +1 if the next track in the
+  //          stack is an e-, gamma or e+, while -999 in case of empty stack.
+  //   NOTE: the tracks are simulated by the basket based stepping engine
+  //         instead when the baskets are given
+  if (theGammaBasket != nullptr) {
+    SimulateTracksInBaskets(theState, theGeometry, theTrackStack, *theGammaBasket, *theElectronBasket, theResult, eventID);
+    EndOfEventAction(theResult, eventID);
+    return;
+  }
+  int trackType = -1;
+  while ( (trackType = theTrackStack.GetTypeOfNextTrack()) > -2 ) {
+    // - obtain the (reset) primary gamma or electron track from the TL-data
+    //   which the next track from the stack will be popped into
+    G4HepEmTrack* nextTrack = PrepareTrack(theTLData, trackType);
+    // - pop the next track from the stack into this
+    theTrackStack.PopInto(*nextTrack);
+    // - simulate the entire history of this track
+    SimulateTrack(theTLData, theState, theGeometry, theTrackStack, theResult, *nextTrack, trackType, eventID);
+  };
+  //
+  // 4. Call the end of event action
+  EndOfEventAction(theResult, eventID);
+}
+
+
+void EventLoop::SimulateTracksInBaskets(G4HepEmState& theState, Geometry& theGeometry, TrackStack& theTrackStack, TrackBasket& theGammaBasket, TrackBasket& theElectronBasket, Results& theResult, int eventID) {
+  while (true) {
+    // fill the baskets with tracks from the stack (till the basket, that
+    // corresponds to the type of the next track in the stack, becomes full):
+    // the next tracks of the same type are popped at once into the basket
+    int trackType = -1;
+    while ( (trackType = theTrackStack.GetTypeOfNextTrack()) > -2 ) {
+      TrackBasket& theBasket = trackType == 0 ? theGammaBasket : theElectronBasket;
+      const int numTracks = theTrackStack.GetNumNextTracksOfType(trackType == 0, theBasket.GetCapacity() - theBasket.GetSize());
+      if (numTracks == 0) {
+        break;
+      }
+      G4HepEmTrack* const* nextTracks = theBasket.Insert(numTracks);
+      theTrackStack.PopInto(nextTracks, numTracks);
+      for (int it=0; it<numTracks; ++it) {
+        G4HepEmTrack& nextTrack = *nextTracks[it];
+        // move the primaries to the calorimeter boundary (see `SimulateTrack`)
+        if (nextTrack.GetParentID() < 0) {
+          double* pos = nextTrack.GetPosition();
+          pos[0] = theGeometry.GetCaloStartXposition();
+        }
+        BeginOfTrackingAction(theResult, nextTrack);
+      }
+    }
+    // the event is completed when both the stack and the baskets are empty
+    if (theGammaBasket.GetSize() + theElectronBasket.GetSize() == 0) {
+      break;
+    }
+    // simulate one step with all tracks in the baskets
+    if (theGammaBasket.GetSize() > 0) {
+      BasketStepper::GammaStep(theState, theTrackStack, theGeometry, theResult, theGammaBasket, eventID);
+    }
+    if (theElectronBasket.GetSize() > 0) {
+      BasketStepper::ElectronStep(theState, theTrackStack, theGeometry, theResult, theElectronBasket, eventID);
+    }
+    // invoke the end of tracking action for the tracks with terminated history
+    // and remove them from the baskets
+    for (TrackBasket* theBasket : {&theGammaBasket, &theElectronBasket}) {
+      for (int i=0; i<theBasket->GetSize(); ++i) {
+        if (!theBasket->IsAlive(i)) {
+          EndOfTrackingAction(theResult, *theBasket->GetTrack(i));
+        }
+      }
+      theBasket->Compact();
+    }
   }
 }
 
 
+G4HepEmTrack* EventLoop::PrepareTrack(G4HepEmTLData& theTLData, int trackType) {
+  G4HepEmTrack* nextTrack = nullptr;
+  // depending if the next track is a gamma or e-/e+ track:
+  if (trackType == 0) { // the next track is a gamma
+    // - obtain the primary gamma track from the TL-data which the next track
+    //   from the stack will be popped into
+    G4HepEmGammaTrack* gTrack = theTLData.GetPrimaryGammaTrack();
+    // - perform the before "start-tracking" procedure: reset the track
+    //   properties and the random engine (throw away cached rnd number)
+    gTrack->ReSet();
+    // NOTE: the buffered uniform numbers of `URandom` are kept (the buffer is
+    //       transparent, i.e. the stream is the same as without buffering)
+    theTLData.GetRNGEngine()->DiscardGauss();
+    // - get the common track part of this primary track
+    nextTrack = gTrack->GetTrack();
+  } else { // the next track is an e- or e+
+    // - obtain the primary electron track from the TL-data which the next track
+    //   from the stack will be popped into
+    G4HepEmElectronTrack* eTrack = theTLData.GetPrimaryElectronTrack();
+    // - perform the before "start-tracking" procedure: reset the track
+    //   properties and the random engine (throw away cached rnd number)
+    eTrack->ReSet();
+    theTLData.GetRNGEngine()->DiscardGauss();
+    // - get the common track part of this primary track
+    nextTrack = eTrack->GetTrack();
+  }
+  return nextTrack;
+}
+
+
+void EventLoop::SimulateTrack(G4HepEmTLData& theTLData, G4HepEmState& theState, Geometry& theGeometry, TrackStack& theTrackStack, Results& theResult, G4HepEmTrack& nextTrack, int trackType, int eventID) {
+  // - the simplified "navigation" assumes, that tracks start from inside
+  //   the `calorimeter` volume. This is true for secondary (ParentID > -1)
+  //   tracks by default as they are generated inside the calorimeter but
+  //   not for primary tracks (ParentID = -1) generated outside of the
+  //   calorimeter volume (in the vacuum, pointing to the calorimeter).
+  //   Therefore, primaries need to be moved to the calorimeter boundary
+  //   (as they point into the calorimeter they will be inside then).
+  if (nextTrack.GetParentID() < 0) {
+    double* pos = nextTrack.GetPosition();
+    pos[0] = theGeometry.GetCaloStartXposition();
+  }
+  // - invoke the beginning of tracking action before start tracking this track
+  BeginOfTrackingAction(theResult, nextTrack);
+  // - call the gamma/electron stepper to simulate the entire history of this
+  //   next-track (provided now in the primary gamma/electron track member of
+  //   the TL-data)
+  //   NOTE: the secondaries, generated during the simulation of the history
+  //         of this track, are all inserted into the track stack.
+  if (trackType == 0) { // the next track is a gamma
+    SteppingLoop::GammaStepper(theTLData, theState, theTrackStack, theGeometry, theResult, eventID);
+  } else {              // the next track is an e- or e+
+    SteppingLoop::ElectronStepper(theTLData, theState, theTrackStack, theGeometry, theResult, eventID);
+  }
+  // - invoke the end of tracking action when the end of its simulation history is reached
+  EndOfTrackingAction(theResult, nextTrack);
+}
+
+
+void EventLoop::ReportSnapshot(const std::vector<Results*>& theResults, int numEvents) {
+  Results theSnapshot;
+  ReduceResults(theSnapshot, theResults);
+  // the per-layer histogram is filled by all workers (the exact sums, if any, are converted by the scaling)
+  theSnapshot.fEdepPerLayer.Scale(1.0/numEvents);
+  const double edepLayers = theSnapshot.fEdepPerLayer.GetSum()/numEvents;
+  std::lock_guard<std::mutex> lock(gOutputMutex);
+  std::cout << "      - snapshot after #event = " << numEvents << " : mean Edep in Absorber = " << theSnapshot.fEdepAbs.GetMean()
+            << " Gap = " << theSnapshot.fEdepGap.GetMean() << " and in all layers = " << edepLayers << " [MeV]" << std::endl;
+}
+
 void EventLoop::BeginOfEventAction(Results& theResult, int eventID, const G4HepEmTrack& thePrimaryTrack) {
   // reset all per-event accumulators in results, i.e. that are used to accumulate data during one event
   theResult.fPerEventRes.fEdepAbs        = 0.0;
@@ -159,39 +535,24 @@ void EventLoop::BeginOfEventAction(Results& theResult, int eventID, const G4HepE
 
   theResult.fPerEventRes.fNumStepsGamma  = 0.0;
   theResult.fPerEventRes.fNumStepsElPos  = 0.0;
+  theResult.fPerEventRes.fNumZeroSteps   = 0.0;
 }
 
 void EventLoop::EndOfEventAction(Results& theResult, int eventID) {
+  // flush the voxels of the scoring mesh, touched during this event, into its run level grid
+  theResult.fEdepMesh.EndOfEvent();
   // propagare the data accunulated during this event to the results
-  double dum = theResult.fPerEventRes.fEdepAbs;
-  theResult.fEdepAbs  += dum;
-  theResult.fEdepAbs2 += dum*dum;
-
-  dum = theResult.fPerEventRes.fEdepGap;
-  theResult.fEdepGap  += dum;
-  theResult.fEdepGap2 += dum*dum;
-
-
-  dum = theResult.fPerEventRes.fNumSecGamma;
-  theResult.fNumSecGamma  += dum;
-  theResult.fNumSecGamma2 += dum*dum;
-
-  dum = theResult.fPerEventRes.fNumSecElectron;
-  theResult.fNumSecElectron  += dum;
-  theResult.fNumSecElectron2 += dum*dum;
-
-  dum = theResult.fPerEventRes.fNumSecPositron;
-  theResult.fNumSecPositron  += dum;
-  theResult.fNumSecPositron2 += dum*dum;
-
+  const ResultsPerEvent& perEvent = theResult.fPerEventRes;
+  theResult.fEdepAbs.Add(perEvent.fEdepAbs);
+  theResult.fEdepGap.Add(perEvent.fEdepGap);
 
-  dum = theResult.fPerEventRes.fNumStepsGamma;
-  theResult.fNumStepsGamma  += dum;
-  theResult.fNumStepsGamma2 += dum*dum;
+  theResult.fNumSecGamma.Add(perEvent.fNumSecGamma);
+  theResult.fNumSecElectron.Add(perEvent.fNumSecElectron);
+  theResult.fNumSecPositron.Add(perEvent.fNumSecPositron);
 
-  dum = theResult.fPerEventRes.fNumStepsElPos;
-  theResult.fNumStepsElPos  += dum;
-  theResult.fNumStepsElPos2 += dum*dum;
+  theResult.fNumStepsGamma.Add(perEvent.fNumStepsGamma);
+  theResult.fNumStepsElPos.Add(perEvent.fNumStepsElPos);
+  theResult.fNumZeroSteps.Add(perEvent.fNumZeroSteps);
 }
 
 
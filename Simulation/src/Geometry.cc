@@ -4,6 +4,8 @@
 #include "Box.hh"
 
 #include <iostream>
+#include <cmath>
+#include <algorithm>
 
 Geometry::Geometry() {
   // default values: 50 layers of 2.3 [mm] absorber (PbWO4) and 5.7 [mm] gap (lAr)
@@ -16,6 +18,18 @@ Geometry::Geometry() {
   fCaloStartX       = 0.0;
   fPrimaryXPosition = 0.0;
 
+  // the `Box` based location is used by default
+  fUseBoundaryTable = false;
+  // the navigation state is used to cross the boundaries exactly by default
+  fExactCrossing    = true;
+  // no transverse readout segmentation by default
+  fNumCellsY           = 0;
+  fNumCellsZ           = 0;
+  fInvCellSizeY        = 0.0;
+  fInvCellSizeZ        = 0.0;
+  fIsAbsorberSegmented = false;
+  fIsSegmented         = false;
+
   // crate shapes here for all objects:
   // - their proper size is set when calling `UpdateParameters` below
   // - material index is set to 0, 1 or 2 that corresponds to (using the default
@@ -39,6 +53,17 @@ Geometry::~Geometry() {
 }
 
 
+std::vector<int> Geometry::GetMaterialIndices() const {
+  std::vector<int> indices = { fBoxWorld->GetMaterialIndx(), fBoxCalo->GetMaterialIndx(), fBoxLayer->GetMaterialIndx(), fBoxAbs->GetMaterialIndx() };
+  if (fGapThick > 0.0) {
+    indices.push_back(fBoxGap->GetMaterialIndx());
+  }
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  return indices;
+}
+
+
 void Geometry::UpdateParameters() {
   // calculate the layer and calorimeter thicknesses based on the `absorber`,
   // `gap` thinkesses and the number of layers
@@ -77,11 +102,27 @@ void Geometry::UpdateParameters() {
   fBoxGap->SetHalfLength(0.5*fGapThick, 0);
   fBoxGap->SetHalfLength(halfCaloYZ, 1);
   fBoxGap->SetHalfLength(halfCaloYZ, 2);
+
+  // pre-compute the boundary table: the translation of each layer and those of the
+  // `absorber` and `gap` inside the layer (computed exactly as in the `Box` based location)
+  fInvLayerThick     = 1.0/fLayerThick;
+  fHalfTolerance     = fBoxCalo->GetHalfTolerance();
+  fInLayerCenterX[0] = -0.5*(fLayerThick - fAbsThick);
+  fInLayerCenterX[1] = -0.5*(fLayerThick -fGapThick) + fAbsThick;
+  fLayerCenterX.resize(fNumLayers);
+  for (int il=0; il<fNumLayers; ++il) {
+    fLayerCenterX[il] = -0.5*fCaloThick + (il+0.5)*fLayerThick;
+  }
+
+  // the transverse readout segmentation (if any)
+  fIsSegmented  = fNumCellsY > 0 && fNumCellsZ > 0 && fNumLayers > 0;
+  fInvCellSizeY = fIsSegmented ? fNumCellsY/fCaloSizeYZ : 0.0;
+  fInvCellSizeZ = fIsSegmented ? fNumCellsZ/fCaloSizeYZ : 0.0;
 }
 
 
 // note: try to keep this more verbose than fast to keep it clear
-double Geometry::CalculateDistanceToOut(double* r, double *v, Box** currentVolume, int* indxLayer, int* indxAbs) {
+double Geometry::CalculateDistanceToOutByBoxes(double* r, double *v, Box** currentVolume, int* indxLayer, int* indxAbs) {
   // init everything to a step in the `world` case
   *currentVolume = fBoxWorld;
   *indxLayer     = -1;
@@ -138,3 +179,144 @@ double Geometry::CalculateDistanceToOut(double* r, double *v, Box** currentVolum
     return fBoxGap->DistanceToOut(r, v);
   }
 }
+
+
+double Geometry::CalculateDistanceToOutByTable(double* r, double *v, Box** currentVolume, int* indxLayer, int* indxAbs) {
+  // init everything to a step in the `world` case
+  *currentVolume = fBoxWorld;
+  *indxLayer     = -1;
+  *indxAbs       = -1;
+
+  // check if about leaving the calorimeter volume (same as its `Box::DistanceToOut` is zero)
+  const double halfCaloX  = 0.5*fCaloThick;
+  const double halfCaloYZ = 0.5*fCaloSizeYZ;
+  if (  ((std::abs(r[0]) - halfCaloX ) >= -fHalfTolerance && r[0]*v[0] > 0)
+     || ((std::abs(r[1]) - halfCaloYZ) >= -fHalfTolerance && r[1]*v[1] > 0)
+     || ((std::abs(r[2]) - halfCaloYZ) >= -fHalfTolerance && r[2]*v[2] > 0) ) {
+    return 1.0E+20;
+  }
+
+  // locate the layer by a single multiplication (the point might be on the calorimeter
+  // surface, i.e. just outside, but moving inside so the index is kept in range)
+  const int    iLayer  = std::min(std::max(int( (r[0] + halfCaloX)*fInvLayerThick ), 0), fNumLayers-1);
+  // then the `absorber` (0) or `gap` (1) inside the layer
+  const double rxLayer = r[0] - fLayerCenterX[iLayer];
+  const int    iAbs    = (rxLayer + 0.5*fLayerThick < fAbsThick || fGapThick == 0) ? 0 : 1;
+  return DistanceToOutInVolume(r, v, iLayer, iAbs, currentVolume, indxLayer, indxAbs);
+}
+
+
+double Geometry::CalculateDistanceToOut(const double* r, double* v, NavigationState& theNavState) {
+  const double dist = LocateAndDistanceToOut(r, v, theNavState);
+  // the readout cell is obtained from the local position of the same location
+  if (fIsSegmented) {
+    SetReadoutCell(theNavState);
+  }
+  return dist;
+}
+
+
+double Geometry::LocateAndDistanceToOut(const double* r, double* v, NavigationState& theNavState) {
+  double* rLocal = theNavState.fLocalPosition;
+  rLocal[0] = r[0];
+  rLocal[1] = r[1];
+  rLocal[2] = r[2];
+  // full location if the track has not been located yet (or at each step if not in the exact crossing mode)
+  if (!fExactCrossing || !theNavState.IsLocated()) {
+    const double dist = CalculateDistanceToOut(rLocal, v, &theNavState.fVolume, &theNavState.fIndxLayer, &theNavState.fIndxAbs);
+    if (dist > 0.0 || !fExactCrossing) {
+      return dist;
+    }
+    // zero distance: the point is on the boundary of the located volume while moving
+    // out so locate it directly in the volume on the other side (direction aware)
+    rLocal[0] = r[0];
+    rLocal[1] = r[1];
+    rLocal[2] = r[2];
+    return CalculateDistanceToOutByTable(rLocal, v, &theNavState.fVolume, &theNavState.fIndxLayer, &theNavState.fIndxAbs);
+  }
+  // check if about leaving the calorimeter through its transverse walls (shared by all volumes)
+  if (IsLeavingThroughWalls(r, v)) {
+    theNavState.fVolume    = fBoxWorld;
+    theNavState.fIndxLayer = -1;
+    theNavState.fIndxAbs   = -1;
+    return 1.0E+20;
+  }
+  // relocate in the current volume (or in its neighbour)
+  return DistanceToOutInVolume(rLocal, v, theNavState.fIndxLayer, theNavState.fIndxAbs, &theNavState.fVolume, &theNavState.fIndxLayer, &theNavState.fIndxAbs);
+}
+
+
+void Geometry::CalculateDistanceToOut(const double* rx, const double* ry, const double* rz, const double* vx, const double* vy, const double* vz, NavigationState* theNavStates, double* dist, double* safety, int num) {
+  const double halfCaloYZ = 0.5*fCaloSizeYZ;
+  for (int i=0; i<num; ++i) {
+    NavigationState& theNavState = theNavStates[i];
+    const double r[3] = { rx[i], ry[i], rz[i] };
+    double       v[3] = { vx[i], vy[i], vz[i] };
+    // full location (or leaving the calorimeter): the same as the single point version
+    if (!fExactCrossing || !theNavState.IsLocated() || IsLeavingThroughWalls(r, v)) {
+      dist[i]   = CalculateDistanceToOut(r, v, theNavState);
+      safety[i] = dist[i] > 1.0E+10 ? 0.0 : theNavState.fVolume->DistanceToOut(theNavState.fLocalPosition);
+      continue;
+    }
+    // relocate in the current volume (or in its neighbour)
+    double* rLocal = theNavState.fLocalPosition;
+    rLocal[0] = r[0];
+    rLocal[1] = r[1];
+    rLocal[2] = r[2];
+    if (!RelocateInVolume(rLocal, v, theNavState.fIndxLayer, theNavState.fIndxAbs, &theNavState.fVolume, &theNavState.fIndxLayer, &theNavState.fIndxAbs)) {
+      dist[i]   = 1.0E+20;
+      safety[i] = 0.0;
+      continue;
+    }
+    if (fIsSegmented) {
+      SetReadoutCell(theNavState);
+    }
+    // distance to out and safety in the volume (as in `Box::DistanceToOut`)
+    const double halfX = theNavState.fIndxAbs == 0 ? 0.5*fAbsThick : 0.5*fGapThick;
+    dist[i] = DistanceToOutLocal(rLocal, v, halfX);
+    const double safe = std::min( std::min(
+                          halfX - std::abs(rLocal[0]),
+                          halfCaloYZ - std::abs(rLocal[1]) ),
+                          halfCaloYZ - std::abs(rLocal[2]) );
+    safety[i] = (safe > 0) ? safe : 0.0;
+  }
+}
+
+
+double Geometry::DistanceToOutInVolume(double* r, const double* v, int iLayer, int iAbs, Box** currentVolume, int* indxLayer, int* indxAbs) {
+  if (!RelocateInVolume(r, v, iLayer, iAbs, currentVolume, indxLayer, indxAbs)) {
+    return 1.0E+20;
+  }
+  return DistanceToOutLocal(r, v, *indxAbs == 0 ? 0.5*fAbsThick : 0.5*fGapThick);
+}
+
+
+bool Geometry::RelocateInVolume(double* r, const double* v, int iLayer, int iAbs, Box** currentVolume, int* indxLayer, int* indxAbs) {
+  // transform the point into the local system of the volume (as in the `Box` based location)
+  const double rx  = r[0];
+  double halfX   = iAbs == 0 ? 0.5*fAbsThick : 0.5*fGapThick;
+  double rxLocal = (rx - fLayerCenterX[iLayer]) - fInLayerCenterX[iAbs];
+
+  // direction aware: the point is on the surface of the volume and moving out so
+  // locate it directly in the next volume along the direction
+  if ((std::abs(rxLocal) - halfX) >= -fHalfTolerance && rxLocal*v[0] > 0) {
+    // index of the volume along the x-axis (2i for absorber and 2i+1 for gap of the i-th layer)
+    const int step = fGapThick == 0 ? 2 : 1;
+    const int iVol = 2*iLayer + iAbs + (v[0] > 0 ? step : -step);
+    if (iVol < 0 || iVol >= 2*fNumLayers) {
+      // leaving the calorimeter
+      *currentVolume = fBoxWorld;
+      *indxLayer     = -1;
+      *indxAbs       = -1;
+      return false;
+    }
+    iLayer  = iVol/2;
+    iAbs    = iVol%2;
+    rxLocal = (rx - fLayerCenterX[iLayer]) - fInLayerCenterX[iAbs];
+  }
+  *currentVolume = iAbs == 0 ? fBoxAbs : fBoxGap;
+  *indxLayer     = iLayer;
+  *indxAbs       = iAbs;
+  r[0]           = rxLocal;
+  return true;
+}
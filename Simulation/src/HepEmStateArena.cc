@@ -0,0 +1,118 @@
+
+#include "HepEmStateArena.hh"
+
+#include "HepEmStateImage.hh"
+
+#include "G4HepEmState.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include <sys/mman.h>
+
+
+// the size of the anonymous huge pages backing the given address (from `/proc/self/smaps`) in [kB] (-1 if not known)
+static long GetAnonHugePages(const void* addr) {
+  FILE* f = fopen("/proc/self/smaps", "r");
+  if (f == nullptr) {
+    return -1;
+  }
+  const uintptr_t theAddr = reinterpret_cast<uintptr_t>(addr);
+  bool isInside = false;
+  long size = -1;
+  char line[512];
+  while (fgets(line, sizeof(line), f) != nullptr) {
+    unsigned long start, end;
+    if (sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+      isInside = (theAddr >= start && theAddr < end);
+      continue;
+    }
+    long val;
+    if (isInside && sscanf(line, "AnonHugePages: %ld kB", &val) == 1) {
+      size = val;
+      break;
+    }
+  }
+  fclose(f);
+  return size;
+}
+
+
+char* HepEmStateArena::Allocate(std::size_t& size, int& backing) {
+  // round up to huge pages: the kernel can use a huge page only for a fully covered, aligned range
+  size = (size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+#ifdef MAP_HUGETLB
+  if (backing == kExplicitHugePages) {
+    void* arena = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (arena != MAP_FAILED) {
+      return static_cast<char*>(arena);
+    }
+    // NOTE: the huge page pool is empty (or not reserved): fall back to transparent huge pages
+    backing = kTransparentHugePages;
+  }
+#else
+  backing = backing == kExplicitHugePages ? kTransparentHugePages : backing;
+#endif
+  // over-allocate to be able to trim the mapping to a huge page aligned one
+  const std::size_t mapSize = size + kHugePageSize;
+  void* mapping = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  const uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+  const uintptr_t begin = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  if (begin > start) {
+    munmap(mapping, begin - start);
+  }
+  const uintptr_t end = start + mapSize;
+  if (end > begin + size) {
+    munmap(reinterpret_cast<void*>(begin + size), end - (begin + size));
+  }
+  char* arena = reinterpret_cast<char*>(begin);
+#ifdef MADV_HUGEPAGE
+  if (backing == kTransparentHugePages && madvise(arena, size, MADV_HUGEPAGE) != 0) {
+    backing = kArena;
+  }
+#else
+  backing = kArena;
+#endif
+  return arena;
+}
+
+
+G4HepEmState* HepEmStateArena::Relayout(G4HepEmState* state, int backing, int verbosity) {
+  if (backing <= kNone) {
+    return state;
+  }
+  backing = backing > kExplicitHugePages ? kExplicitHugePages : backing;
+  // the same layout as in the payload of the image (all arrays aligned, pointers encoded by their offsets)
+  std::vector<char> payload;
+  const uint64_t stateOffset = HepEmStateImage::Serialise(*state, payload);
+  std::size_t arenaSize = payload.size();
+  int arenaBacking = backing;
+  char* arena = Allocate(arenaSize, arenaBacking);
+  if (arena == nullptr) {
+    std::cerr << "\n *** HepEmStateArena::Relayout: cannot allocate the arena of " << arenaSize
+              << " bytes (the state is used as it is)." << std::endl;
+    return state;
+  }
+  // NOTE: the copy touches all pages of the arena, i.e. they are all backed after this
+  std::memcpy(arena, payload.data(), payload.size());
+  G4HepEmState* theState = HepEmStateImage::Relocate(arena, stateOffset);
+  if (verbosity > 0) {
+    const char* names[] = { "none", "ordinary pages", "transparent huge pages", "explicit huge pages" };
+    const long  hugeKB  = arenaBacking == kExplicitHugePages ? static_cast<long>(arenaSize/1024) : GetAnonHugePages(arena);
+    std::cout << " === HepEmStateArena: the tables are relayouted into a contiguous arena " << std::endl;
+    std::cout << "     - arena size          : " << std::setprecision(4) << payload.size()/1024.0 << " [kB] (mapped " << arenaSize/1024 << " [kB])" << std::endl;
+    std::cout << "     - backing             : " << names[arenaBacking] << (arenaBacking != backing ? " (fallback)" : "") << std::endl;
+    std::cout << "     - huge pages in arena : " << (hugeKB < 0 ? std::string("unknown") : std::to_string(hugeKB) + " [kB]") << std::endl;
+    std::cout << "     - 4 kB pages spanned  : " << HepEmStateImage::GetNumPages(*state, 4096) << " before and " << HepEmStateImage::GetNumPages(*theState, 4096) << " after" << std::endl;
+    std::cout << "     - 2 MB pages spanned  : " << HepEmStateImage::GetNumPages(*state, kHugePageSize) << " before and " << HepEmStateImage::GetNumPages(*theState, kHugePageSize) << " after" << std::endl;
+  }
+  return theState;
+}
@@ -0,0 +1,547 @@
+#include "HepEmStateImage.hh"
+
+// G4HepEm related includes: the data structures stored in the image and the JSON IO
+#include "G4HepEmState.hh"
+#include "G4HepEmData.hh"
+#include "G4HepEmParameters.hh"
+#include "G4HepEmMatCutData.hh"
+#include "G4HepEmMaterialData.hh"
+#include "G4HepEmElementData.hh"
+#include "G4HepEmElectronData.hh"
+#include "G4HepEmSBTableData.hh"
+#include "G4HepEmGammaData.hh"
+#include "G4HepEmDataJsonIO.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+// NOTE: this is Unix specific!
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// version of the image format (must be increased at any change of the encoding)
+static const uint32_t    kImageVersion = 1;
+// alignment of the data structures and arrays in the payload
+static const std::size_t kImageAlign   = 64;
+
+
+//
+// Encoding: each array (or data structure) is appended to the payload and the
+// pointer is replaced by its `offset + 1` (nullptr stays nullptr)
+template <typename T>
+static T* Append(std::vector<char>& payload, const T* data, std::size_t num) {
+  if (data == nullptr || num == 0) {
+    return nullptr;
+  }
+  const std::size_t offset = (payload.size() + kImageAlign - 1) & ~(kImageAlign - 1);
+  payload.resize(offset + num*sizeof(T), 0);
+  std::memcpy(payload.data() + offset, static_cast<const void*>(data), num*sizeof(T));
+  return reinterpret_cast<T*>(offset + 1);
+}
+
+// the location of the encoded pointer in the payload
+template <typename T>
+static T* Resolve(const char* payload, T* encoded) {
+  if (encoded == nullptr) {
+    return nullptr;
+  }
+  return reinterpret_cast<T*>(const_cast<char*>(payload) + (reinterpret_cast<std::uintptr_t>(encoded) - 1));
+}
+
+// the data structure stored at the encoded pointer to resolve its pointers: its copy or itself when in place (writable payload)
+template <typename T>
+static T* GetShell(const char* payload, T* encoded, bool inPlace) {
+  T* data = Resolve(payload, encoded);
+  return data == nullptr || inPlace ? data : new T(*data);
+}
+
+// the two actions on the array pointers of the data structures
+struct ArrayWriter {
+  std::vector<char>& fPayload;
+  template <typename T>
+  void operator()(T*& ptr, std::size_t num) { ptr = Append(fPayload, ptr, num); }
+};
+
+struct ArrayResolver {
+  const char* fPayload;
+  template <typename T>
+  void operator()(T*& ptr, std::size_t) { ptr = Resolve(fPayload, ptr); }
+};
+
+struct PageCounter {
+  std::size_t           fPageSize;
+  std::vector<uintptr_t>& fPages;
+  template <typename T>
+  void operator()(T* const& ptr, std::size_t num) { Add(ptr, num*sizeof(T)); }
+  void Add(const void* ptr, std::size_t size) {
+    if (ptr == nullptr || size == 0) {
+      return;
+    }
+    const uintptr_t first = reinterpret_cast<uintptr_t>(ptr)/fPageSize;
+    const uintptr_t last  = (reinterpret_cast<uintptr_t>(ptr) + size - 1)/fPageSize;
+    for (uintptr_t page=first; page<=last; ++page) {
+      fPages.push_back(page);
+    }
+  }
+};
+
+
+//
+// The (leaf) arrays of the data structures with their number of entries.
+// NOTE: these must follow the `G4HepEm` data structures (see their `Allocate`
+//       and JSON IO functions). The counts are read before the pointers changed.
+template <typename Action>
+static void VisitArrays(G4HepEmMatCutData& data, Action& action) {
+  action(data.fG4MCIndexToHepEmMCIndex, data.fNumG4MatCuts);
+  action(data.fMatCutData, data.fNumMatCutData);
+}
+
+template <typename Action>
+static void VisitArrays(G4HepEmMatData& data, Action& action) {
+  action(data.fElementVect, data.fNumOfElement);
+  action(data.fNumOfAtomsPerVolumeVect, data.fNumOfElement);
+  action(data.fSandiaEnergies, data.fNumOfSandiaIntervals);
+  action(data.fSandiaCoefficients, 4*data.fNumOfSandiaIntervals);
+}
+
+template <typename Action>
+static void VisitArrays(G4HepEmElemData& data, Action& action) {
+  action(data.fSandiaEnergies, data.fNumOfSandiaIntervals);
+  action(data.fSandiaCoefficients, 4*data.fNumOfSandiaIntervals);
+}
+
+template <typename Action>
+static void VisitArrays(G4HepEmElectronData& data, Action& action) {
+  const std::size_t numELoss = data.fELossEnergyGridSize;
+  action(data.fELossEnergyGrid, numELoss);
+  action(data.fELossData, 5*data.fNumMatCuts*numELoss);
+  action(data.fResMacXSecStartIndexPerMatCut, data.fNumMatCuts);
+  action(data.fResMacXSecData, data.fResMacXSecNumData);
+  action(data.fTr1MacXSecData, 2*data.fNumMaterials*numELoss);
+  action(data.fElemSelectorIoniStartIndexPerMatCut, data.fNumMatCuts);
+  action(data.fElemSelectorIoniData, data.fElemSelectorIoniNumData);
+  action(data.fElemSelectorBremSBStartIndexPerMatCut, data.fNumMatCuts);
+  action(data.fElemSelectorBremSBData, data.fElemSelectorBremSBNumData);
+  action(data.fElemSelectorBremRBStartIndexPerMatCut, data.fNumMatCuts);
+  action(data.fElemSelectorBremRBData, data.fElemSelectorBremRBNumData);
+}
+
+template <typename Action>
+static void VisitArrays(G4HepEmSBTableData& data, Action& action) {
+  action(data.fGammaCutIndxStartIndexPerMC, data.fNumHepEmMatCuts);
+  action(data.fGammaCutIndices, data.fNumElemsInMatCuts);
+  action(data.fSBTableData, data.fNumSBTableData);
+}
+
+template <typename Action>
+static void VisitArrays(G4HepEmGammaData& data, Action& action) {
+  action(data.fConvEnergyGrid, data.fConvEnergyGridSize);
+  action(data.fCompEnergyGrid, data.fCompEnergyGridSize);
+  action(data.fConvCompMacXsecData, 2*data.fNumMaterials*(data.fConvEnergyGridSize + data.fCompEnergyGridSize));
+  action(data.fElemSelectorConvStartIndexPerMat, data.fNumMaterials);
+  action(data.fElemSelectorConvEgrid, data.fElemSelectorConvEgridSize);
+  action(data.fElemSelectorConvData, data.fElemSelectorConvNumData);
+}
+
+
+// appends the data structure (and its arrays) to the payload
+template <typename T>
+static T* AppendData(std::vector<char>& payload, const T* data) {
+  if (data == nullptr) {
+    return nullptr;
+  }
+  T shell(*data);
+  ArrayWriter writer{payload};
+  VisitArrays(shell, writer);
+  return Append(payload, &shell, 1);
+}
+
+// the data structure (with its pointers resolved) stored at the encoded pointer
+template <typename T>
+static T* ResolveData(const char* payload, T* encoded, bool inPlace) {
+  T* data = GetShell(payload, encoded, inPlace);
+  if (data != nullptr) {
+    ArrayResolver resolver{payload};
+    VisitArrays(*data, resolver);
+  }
+  return data;
+}
+
+// the material and element data are arrays of data structures with arrays
+static G4HepEmMaterialData* AppendMaterialData(std::vector<char>& payload, const G4HepEmMaterialData* data) {
+  if (data == nullptr) {
+    return nullptr;
+  }
+  G4HepEmMaterialData shell(*data);
+  ArrayWriter writer{payload};
+  writer(shell.fG4MatIndexToHepEmMatIndex, data->fNumG4Material);
+  if (data->fMaterialData != nullptr) {
+    std::vector<G4HepEmMatData> matData(data->fMaterialData, data->fMaterialData + data->fNumMaterialData);
+    for (G4HepEmMatData& mat : matData) {
+      VisitArrays(mat, writer);
+    }
+    shell.fMaterialData = Append(payload, matData.data(), matData.size());
+  }
+  return Append(payload, &shell, 1);
+}
+
+static G4HepEmMaterialData* ResolveMaterialData(const char* payload, G4HepEmMaterialData* encoded, bool inPlace) {
+  G4HepEmMaterialData* data = GetShell(payload, encoded, inPlace);
+  if (data != nullptr) {
+    ArrayResolver resolver{payload};
+    resolver(data->fG4MatIndexToHepEmMatIndex, 0);
+    G4HepEmMatData* matData = Resolve(payload, data->fMaterialData);
+    data->fMaterialData = matData;
+    if (matData != nullptr) {
+      if (!inPlace) {
+        data->fMaterialData = new G4HepEmMatData[data->fNumMaterialData];
+        std::copy(matData, matData + data->fNumMaterialData, data->fMaterialData);
+      }
+      for (int im=0; im<data->fNumMaterialData; ++im) {
+        VisitArrays(data->fMaterialData[im], resolver);
+      }
+    }
+  }
+  return data;
+}
+
+static G4HepEmElementData* AppendElementData(std::vector<char>& payload, const G4HepEmElementData* data) {
+  if (data == nullptr) {
+    return nullptr;
+  }
+  G4HepEmElementData shell(*data);
+  if (data->fElementData != nullptr) {
+    ArrayWriter writer{payload};
+    std::vector<G4HepEmElemData> elemData(data->fElementData, data->fElementData + data->fMaxZet + 1);
+    for (G4HepEmElemData& elem : elemData) {
+      VisitArrays(elem, writer);
+    }
+    shell.fElementData = Append(payload, elemData.data(), elemData.size());
+  }
+  return Append(payload, &shell, 1);
+}
+
+static G4HepEmElementData* ResolveElementData(const char* payload, G4HepEmElementData* encoded, bool inPlace) {
+  G4HepEmElementData* data = GetShell(payload, encoded, inPlace);
+  if (data != nullptr) {
+    G4HepEmElemData* elemData = Resolve(payload, data->fElementData);
+    data->fElementData = elemData;
+    if (elemData != nullptr) {
+      ArrayResolver resolver{payload};
+      if (!inPlace) {
+        data->fElementData = new G4HepEmElemData[data->fMaxZet + 1];
+        std::copy(elemData, elemData + data->fMaxZet + 1, data->fElementData);
+      }
+      for (int iz=0; iz<=data->fMaxZet; ++iz) {
+        VisitArrays(data->fElementData[iz], resolver);
+      }
+    }
+  }
+  return data;
+}
+
+// modification time of the file in [ns] since the epoch
+static int64_t GetMTime(const struct stat& fileStat) {
+  return static_cast<int64_t>(fileStat.st_mtim.tv_sec)*1000000000 + fileStat.st_mtim.tv_nsec;
+}
+
+
+// number of (minor plus major) page faults of the process so far
+static long GetNumPageFaults() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_minflt + usage.ru_majflt;
+}
+
+// reports the source, time and page faults of loading the state
+static void ReportLoad(const std::string& source, const std::chrono::steady_clock::time_point& start, long numPageFaultsAtStart) {
+  const double timeInMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::cout << std::setprecision(4);
+  std::cout << " === G4HepEm state loaded from " << source << " in " << timeInMs << " [ms] with "
+            << GetNumPageFaults() - numPageFaultsAtStart << " page faults" << std::endl;
+}
+
+
+G4HepEmState* HepEmStateImage::Load(const std::string& jsonFileName, bool useImage, int verbosity) {
+  const auto start = std::chrono::steady_clock::now();
+  const long numPageFaults = GetNumPageFaults();
+  G4HepEmState* state = useImage ? MapImage(jsonFileName) : nullptr;
+  const bool isMapped = state != nullptr;
+  if (!isMapped) {
+    std::ifstream jsonIS{ jsonFileName.c_str() };
+    state = G4HepEmStateFromJson(jsonIS);
+    if (state == nullptr) {
+      std::cerr << "\n ***** ERROR in HepEmStateImage::Load  "
+                << " cannot load the G4HepEm state from the file = " << jsonFileName
+                << std::endl;
+      exit(1);
+    }
+  }
+  if (verbosity > 0) {
+    ReportLoad(isMapped ? "the image = " + GetImageFileName(jsonFileName) : "the file = " + jsonFileName, start, numPageFaults);
+  }
+  // build the image for the next jobs (not included in the above report)
+  if (useImage && !isMapped) {
+    const bool isWritten = WriteImage(*state, jsonFileName);
+    if (verbosity > 0) {
+      std::cout << "     (the image " << (isWritten ? "written to = " : "cannot be written to = ") << GetImageFileName(jsonFileName)
+                << (isWritten ? " for the next jobs)" : ")") << std::endl;
+    }
+  }
+  return state;
+}
+
+
+G4HepEmState* HepEmStateImage::LoadFromMemory(const char* data, std::size_t size, const std::string& name, int verbosity) {
+  const auto start = std::chrono::steady_clock::now();
+  const long numPageFaults = GetNumPageFaults();
+  G4HepEmState* state = nullptr;
+  const bool isImage = size >= sizeof(Header) && std::memcmp(data, "HEPEMIMG", 8) == 0;
+  if (isImage) {
+    if (IsValidImage(data, size)) {
+      state = Deserialise(data + sizeof(Header), reinterpret_cast<const Header*>(data)->fStateOffset);
+    }
+  } else {
+    std::istringstream jsonIS{ std::string(data, size) };
+    state = G4HepEmStateFromJson(jsonIS);
+  }
+  if (state == nullptr) {
+    std::cerr << "\n ***** ERROR in HepEmStateImage::LoadFromMemory  "
+              << " cannot load the G4HepEm state from the " << (isImage ? "(not valid) image = " : "JSON data = ") << name
+              << std::endl;
+    exit(1);
+  }
+  if (verbosity > 0) {
+    ReportLoad(std::string("the embedded ") + (isImage ? "image = " : "JSON data = ") + name, start, numPageFaults);
+  }
+  return state;
+}
+
+
+std::string HepEmStateImage::GetImageFileName(const std::string& jsonFileName) {
+  const std::size_t pos = jsonFileName.rfind(".json");
+  return (pos != std::string::npos && pos + 5 == jsonFileName.size() ? jsonFileName.substr(0, pos) : jsonFileName) + ".bin";
+}
+
+
+G4HepEmState* HepEmStateImage::MapImage(const std::string& jsonFileName) {
+  struct stat jsonStat;
+  if (stat(jsonFileName.c_str(), &jsonStat) != 0) {
+    return nullptr;
+  }
+  const std::string imageFileName = GetImageFileName(jsonFileName);
+  const int fd = open(imageFileName.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat imageStat;
+  if (fstat(fd, &imageStat) != 0 || static_cast<std::size_t>(imageStat.st_size) < sizeof(Header)) {
+    close(fd);
+    return nullptr;
+  }
+  // NOTE: the mapping stays valid after closing the file and it's kept till the end (tables are used from there)
+  const std::size_t imageSize = imageStat.st_size;
+  void* image = mmap(nullptr, imageSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (image == MAP_FAILED) {
+    return nullptr;
+  }
+  const Header* header  = static_cast<const Header*>(image);
+  // the image must be built from the current JSON file
+  const bool isValid = header->fSourceSize  == static_cast<uint64_t>(jsonStat.st_size)
+                       && header->fSourceMTime == GetMTime(jsonStat)
+                       && IsValidImage(static_cast<const char*>(image), imageSize);
+  if (!isValid) {
+    munmap(image, imageSize);
+    return nullptr;
+  }
+  return Deserialise(static_cast<const char*>(image) + sizeof(Header), header->fStateOffset);
+}
+
+
+bool HepEmStateImage::IsValidImage(const char* image, std::size_t imageSize) {
+  if (imageSize < sizeof(Header)) {
+    return false;
+  }
+  const Header* header  = reinterpret_cast<const Header*>(image);
+  const char*   payload = image + sizeof(Header);
+  return std::memcmp(header->fMagic, "HEPEMIMG", 8) == 0
+         && header->fVersion     == kImageVersion
+         && header->fHeaderSize  == sizeof(Header)
+         && header->fLayout      == GetLayoutSignature()
+         && header->fPayloadSize == imageSize - sizeof(Header)
+         && header->fStateOffset <  header->fPayloadSize
+         && header->fChecksum    == Checksum(payload, header->fPayloadSize);
+}
+
+
+bool HepEmStateImage::WriteImage(const G4HepEmState& state, const std::string& jsonFileName) {
+  struct stat jsonStat;
+  if (stat(jsonFileName.c_str(), &jsonStat) != 0) {
+    return false;
+  }
+  std::vector<char> payload;
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  std::memcpy(header.fMagic, "HEPEMIMG", 8);
+  header.fVersion     = kImageVersion;
+  header.fHeaderSize  = sizeof(Header);
+  header.fLayout      = GetLayoutSignature();
+  header.fSourceSize  = jsonStat.st_size;
+  header.fSourceMTime = GetMTime(jsonStat);
+  header.fStateOffset = Serialise(state, payload);
+  header.fPayloadSize = payload.size();
+  header.fChecksum    = Checksum(payload.data(), payload.size());
+  // write into a temporary file (unique per process) then rename: jobs never see a partial image
+  const std::string imageFileName = GetImageFileName(jsonFileName);
+  const std::string tmpFileName   = imageFileName + ".tmp." + std::to_string(getpid());
+  FILE* f = fopen(tmpFileName.c_str(), "wb");
+  if (!f) {
+    return false;
+  }
+  bool isOK = fwrite(&header, sizeof(Header), 1, f) == 1
+              && fwrite(payload.data(), 1, payload.size(), f) == payload.size();
+  isOK = fclose(f) == 0 && isOK;
+  if (!isOK || rename(tmpFileName.c_str(), imageFileName.c_str()) != 0) {
+    remove(tmpFileName.c_str());
+    return false;
+  }
+  return true;
+}
+
+
+uint64_t HepEmStateImage::Serialise(const G4HepEmState& state, std::vector<char>& payload) {
+  G4HepEmState shell(state);
+  if (state.fData != nullptr) {
+    const G4HepEmData* data = state.fData;
+    G4HepEmData dataShell(*data);
+    dataShell.fTheMatCutData   = AppendData(payload, data->fTheMatCutData);
+    dataShell.fTheMaterialData = AppendMaterialData(payload, data->fTheMaterialData);
+    dataShell.fTheElementData  = AppendElementData(payload, data->fTheElementData);
+    dataShell.fTheElectronData = AppendData(payload, data->fTheElectronData);
+    dataShell.fThePositronData = AppendData(payload, data->fThePositronData);
+    dataShell.fTheSBTableData  = AppendData(payload, data->fTheSBTableData);
+    dataShell.fTheGammaData    = AppendData(payload, data->fTheGammaData);
+    shell.fData = Append(payload, &dataShell, 1);
+  }
+  shell.fParameters = Append(payload, state.fParameters, 1);
+  G4HepEmState* encoded = Append(payload, &shell, 1);
+  // the payload size is kept to be a multiple of the alignment
+  payload.resize((payload.size() + kImageAlign - 1) & ~(kImageAlign - 1), 0);
+  return reinterpret_cast<std::uintptr_t>(encoded) - 1;
+}
+
+
+G4HepEmState* HepEmStateImage::Deserialise(const char* payload, uint64_t stateOffset) {
+  return ResolveState(const_cast<char*>(payload), stateOffset, false);
+}
+
+
+G4HepEmState* HepEmStateImage::Relocate(char* payload, uint64_t stateOffset) {
+  return ResolveState(payload, stateOffset, true);
+}
+
+
+G4HepEmState* HepEmStateImage::ResolveState(char* payload, uint64_t stateOffset, bool inPlace) {
+  G4HepEmState* state = GetShell(payload, reinterpret_cast<G4HepEmState*>(stateOffset + 1), inPlace);
+  state->fParameters  = GetShell(payload, state->fParameters, inPlace);
+  G4HepEmData*  data  = GetShell(payload, state->fData, inPlace);
+  if (data != nullptr) {
+    data->fTheMatCutData   = ResolveData(payload, data->fTheMatCutData, inPlace);
+    data->fTheMaterialData = ResolveMaterialData(payload, data->fTheMaterialData, inPlace);
+    data->fTheElementData  = ResolveElementData(payload, data->fTheElementData, inPlace);
+    data->fTheElectronData = ResolveData(payload, data->fTheElectronData, inPlace);
+    data->fThePositronData = ResolveData(payload, data->fThePositronData, inPlace);
+    data->fTheSBTableData  = ResolveData(payload, data->fTheSBTableData, inPlace);
+    data->fTheGammaData    = ResolveData(payload, data->fTheGammaData, inPlace);
+  }
+  state->fData = data;
+  return state;
+}
+
+
+// adds the pages of the data structure and its arrays
+template <typename T>
+static void AddPages(PageCounter& counter, T* data) {
+  if (data != nullptr) {
+    counter.Add(data, sizeof(T));
+    T shell(*data);
+    VisitArrays(shell, counter);
+  }
+}
+
+
+std::size_t HepEmStateImage::GetNumPages(const G4HepEmState& state, std::size_t pageSize) {
+  std::vector<uintptr_t> pages;
+  PageCounter counter{pageSize, pages};
+  counter.Add(&state, sizeof(G4HepEmState));
+  counter.Add(state.fParameters, sizeof(G4HepEmParameters));
+  const G4HepEmData* data = state.fData;
+  if (data != nullptr) {
+    counter.Add(data, sizeof(G4HepEmData));
+    AddPages(counter, data->fTheMatCutData);
+    AddPages(counter, data->fTheElectronData);
+    AddPages(counter, data->fThePositronData);
+    AddPages(counter, data->fTheSBTableData);
+    AddPages(counter, data->fTheGammaData);
+    if (const G4HepEmMaterialData* matData = data->fTheMaterialData) {
+      counter.Add(matData, sizeof(G4HepEmMaterialData));
+      counter(matData->fG4MatIndexToHepEmMatIndex, matData->fNumG4Material);
+      counter(matData->fMaterialData, matData->fNumMaterialData);
+      for (int im=0; matData->fMaterialData != nullptr && im<matData->fNumMaterialData; ++im) {
+        G4HepEmMatData mat(matData->fMaterialData[im]);
+        VisitArrays(mat, counter);
+      }
+    }
+    if (const G4HepEmElementData* elemData = data->fTheElementData) {
+      counter.Add(elemData, sizeof(G4HepEmElementData));
+      counter(elemData->fElementData, elemData->fMaxZet + 1);
+      for (int iz=0; elemData->fElementData != nullptr && iz<=elemData->fMaxZet; ++iz) {
+        G4HepEmElemData elem(elemData->fElementData[iz]);
+        VisitArrays(elem, counter);
+      }
+    }
+  }
+  std::sort(pages.begin(), pages.end());
+  return static_cast<std::size_t>(std::unique(pages.begin(), pages.end()) - pages.begin());
+}
+
+
+uint64_t HepEmStateImage::Checksum(const char* data, std::size_t size) {
+  const uint64_t kPrime = 0x100000001B3ULL;
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  // 8 bytes words (the payload is 64 bytes aligned) then the remaining bytes
+  const std::size_t numWords = size/8;
+  for (std::size_t i=0; i<numWords; ++i) {
+    uint64_t word;
+    std::memcpy(&word, data + 8*i, 8);
+    hash = (hash ^ word)*kPrime;
+  }
+  for (std::size_t i=8*numWords; i<size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(data[i]))*kPrime;
+  }
+  return hash;
+}
+
+
+uint64_t HepEmStateImage::GetLayoutSignature() {
+  const std::size_t sizes[] = { sizeof(void*), sizeof(G4HepEmState), sizeof(G4HepEmParameters), sizeof(G4HepEmData),
+                                sizeof(G4HepEmMatCutData), sizeof(G4HepEmMCCData), sizeof(G4HepEmMaterialData),
+                                sizeof(G4HepEmMatData), sizeof(G4HepEmElementData), sizeof(G4HepEmElemData),
+                                sizeof(G4HepEmElectronData), sizeof(G4HepEmSBTableData), sizeof(G4HepEmGammaData) };
+  uint64_t words[sizeof(sizes)/sizeof(std::size_t)];
+  for (std::size_t i=0; i<sizeof(sizes)/sizeof(std::size_t); ++i) {
+    words[i] = sizes[i];
+  }
+  return Checksum(reinterpret_cast<const char*>(words), sizeof(words));
+}
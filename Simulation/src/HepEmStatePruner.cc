@@ -0,0 +1,247 @@
+#include "HepEmStatePruner.hh"
+
+#include "HepEmStateImage.hh"
+
+// G4HepEm related includes: the data structures that are pruned
+#include "G4HepEmState.hh"
+#include "G4HepEmData.hh"
+#include "G4HepEmMatCutData.hh"
+#include "G4HepEmElectronData.hh"
+#include "G4HepEmSBTableData.hh"
+#include "G4HepEmGammaData.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+
+// electron rest mass energy in [MeV]
+static const double kElectronMassC2 = 0.51099895;
+
+
+// a new array with the content of the vector (nullptr if empty)
+template <typename T>
+static T* NewArray(const std::vector<T>& vect) {
+  if (vect.empty()) {
+    return nullptr;
+  }
+  T* arr = new T[vect.size()];
+  std::copy(vect.begin(), vect.end(), arr);
+  return arr;
+}
+
+// compacts per-couple chunks of data given by their start indices (-1 for no data) to the kept couples
+template <typename T>
+static void CompactChunks(const int* starts, const T* data, int numData, int numMatCuts, const std::vector<int>& keptMC, int*& newStarts, T*& newData, int& newNumData) {
+  if (starts == nullptr) {
+    return;
+  }
+  std::vector<int> theStarts;
+  std::vector<T>   theData;
+  for (int imc : keptMC) {
+    const int start = starts[imc];
+    if (start < 0) {
+      theStarts.push_back(-1);
+      continue;
+    }
+    // the chunk ends at the next start (or at the end of the data)
+    int end = numData;
+    for (int i=0; i<numMatCuts; ++i) {
+      if (starts[i] > start) {
+        end = std::min(end, starts[i]);
+      }
+    }
+    theStarts.push_back(static_cast<int>(theData.size()));
+    theData.insert(theData.end(), data + start, data + end);
+  }
+  newStarts  = NewArray(theStarts);
+  newData    = NewArray(theData);
+  newNumData = static_cast<int>(theData.size());
+}
+
+// appends the restricted macroscopic cross sections of a couple (ionisation then bremsstrahlung) truncated above `maxEkin`
+static void AppendResMacXSec(std::vector<double>& out, const double* chunk, int size, double maxEkin) {
+  // check the self describing layout (the chunk is copied as it is otherwise)
+  const int numIoni = size > 10 ? static_cast<int>(chunk[0]) : -1;
+  const int numBrem = numIoni > 1 && 5 + 3*numIoni < size ? static_cast<int>(chunk[5 + 3*numIoni]) : -1;
+  if (numBrem < 2 || 10 + 3*(numIoni + numBrem) != size) {
+    out.insert(out.end(), chunk, chunk + size);
+    return;
+  }
+  for (const double* table : { chunk, chunk + 5 + 3*numIoni }) {
+    const int numKeep = HepEmStatePruner::GetNumGridPoints(static_cast<int>(table[0]), table[3], table[4], maxEkin);
+    out.push_back(numKeep);
+    out.insert(out.end(), table + 1, table + 5);
+    out.insert(out.end(), table + 5, table + 5 + 3*numKeep);
+  }
+}
+
+
+static G4HepEmMatCutData* PruneMatCutData(const G4HepEmMatCutData* data, const std::vector<int>& keptMC) {
+  G4HepEmMatCutData* pruned = new G4HepEmMatCutData(*data);
+  const int numMC = static_cast<int>(keptMC.size());
+  std::vector<int> newIndex(data->fNumMatCutData, -1);
+  pruned->fNumMatCutData = numMC;
+  pruned->fMatCutData    = new G4HepEmMCCData[numMC];
+  for (int imc=0; imc<numMC; ++imc) {
+    pruned->fMatCutData[imc] = data->fMatCutData[keptMC[imc]];
+    newIndex[keptMC[imc]]    = imc;
+  }
+  pruned->fG4MCIndexToHepEmMCIndex = new int[data->fNumG4MatCuts];
+  for (int ig=0; ig<data->fNumG4MatCuts; ++ig) {
+    const int imc = data->fG4MCIndexToHepEmMCIndex[ig];
+    pruned->fG4MCIndexToHepEmMCIndex[ig] = imc < 0 ? -1 : newIndex[imc];
+  }
+  return pruned;
+}
+
+
+static G4HepEmElectronData* PruneElectronData(const G4HepEmElectronData* data, const std::vector<int>& keptMC, double maxEkin) {
+  if (data == nullptr) {
+    return nullptr;
+  }
+  G4HepEmElectronData* pruned = new G4HepEmElectronData(*data);
+  const int numMC    = static_cast<int>(keptMC.size());
+  const int numELoss = data->fELossEnergyGridSize;
+  const int numKeep  = HepEmStatePruner::GetNumGridPoints(numELoss, data->fELossLogMinEkin, data->fELossEILDelta, maxEkin);
+  pruned->fNumMatCuts          = numMC;
+  pruned->fELossEnergyGridSize = numKeep;
+  pruned->fELossEnergyGrid     = new double[numKeep];
+  std::copy(data->fELossEnergyGrid, data->fELossEnergyGrid + numKeep, pruned->fELossEnergyGrid);
+  // energy loss: (range, sd) and (dE/dx, sd) pairs then the sd of the inverse range per couple
+  pruned->fELossData = new double[5*numMC*numKeep];
+  for (int imc=0; imc<numMC; ++imc) {
+    const double* src = data->fELossData + 5*numELoss*keptMC[imc];
+    double*       dst = pruned->fELossData + 5*numKeep*imc;
+    std::copy(src, src + 2*numKeep, dst);
+    std::copy(src + 2*numELoss, src + 2*numELoss + 2*numKeep, dst + 2*numKeep);
+    std::copy(src + 4*numELoss, src + 4*numELoss + numKeep, dst + 4*numKeep);
+  }
+  // first transport macroscopic cross sections: (value, sd) pairs per material (all kept)
+  pruned->fTr1MacXSecData = new double[2*data->fNumMaterials*numKeep];
+  for (int im=0; im<data->fNumMaterials; ++im) {
+    const double* src = data->fTr1MacXSecData + 2*numELoss*im;
+    std::copy(src, src + 2*numKeep, pruned->fTr1MacXSecData + 2*numKeep*im);
+  }
+  // restricted macroscopic cross sections per couple (each with its own grids)
+  std::vector<int>    resStarts;
+  std::vector<double> resData;
+  for (int imc : keptMC) {
+    const int start = data->fResMacXSecStartIndexPerMatCut[imc];
+    if (start < 0) {
+      resStarts.push_back(-1);
+      continue;
+    }
+    int end = data->fResMacXSecNumData;
+    for (int i=0; i<data->fNumMatCuts; ++i) {
+      if (data->fResMacXSecStartIndexPerMatCut[i] > start) {
+        end = std::min(end, data->fResMacXSecStartIndexPerMatCut[i]);
+      }
+    }
+    resStarts.push_back(static_cast<int>(resData.size()));
+    AppendResMacXSec(resData, data->fResMacXSecData + start, end - start, maxEkin);
+  }
+  pruned->fResMacXSecNumData             = static_cast<int>(resData.size());
+  pruned->fResMacXSecStartIndexPerMatCut = NewArray(resStarts);
+  pruned->fResMacXSecData                = NewArray(resData);
+  // the element selectors (only compacted)
+  CompactChunks(data->fElemSelectorIoniStartIndexPerMatCut, data->fElemSelectorIoniData, data->fElemSelectorIoniNumData, data->fNumMatCuts, keptMC,
+                pruned->fElemSelectorIoniStartIndexPerMatCut, pruned->fElemSelectorIoniData, pruned->fElemSelectorIoniNumData);
+  CompactChunks(data->fElemSelectorBremSBStartIndexPerMatCut, data->fElemSelectorBremSBData, data->fElemSelectorBremSBNumData, data->fNumMatCuts, keptMC,
+                pruned->fElemSelectorBremSBStartIndexPerMatCut, pruned->fElemSelectorBremSBData, pruned->fElemSelectorBremSBNumData);
+  CompactChunks(data->fElemSelectorBremRBStartIndexPerMatCut, data->fElemSelectorBremRBData, data->fElemSelectorBremRBNumData, data->fNumMatCuts, keptMC,
+                pruned->fElemSelectorBremRBStartIndexPerMatCut, pruned->fElemSelectorBremRBData, pruned->fElemSelectorBremRBNumData);
+  return pruned;
+}
+
+
+static G4HepEmSBTableData* PruneSBTableData(const G4HepEmSBTableData* data, const std::vector<int>& keptMC) {
+  if (data == nullptr) {
+    return nullptr;
+  }
+  G4HepEmSBTableData* pruned = new G4HepEmSBTableData(*data);
+  CompactChunks(data->fGammaCutIndxStartIndexPerMC, data->fGammaCutIndices, data->fNumElemsInMatCuts, data->fNumHepEmMatCuts, keptMC,
+                pruned->fGammaCutIndxStartIndexPerMC, pruned->fGammaCutIndices, pruned->fNumElemsInMatCuts);
+  pruned->fNumHepEmMatCuts = static_cast<int>(keptMC.size());
+  return pruned;
+}
+
+
+static G4HepEmGammaData* PruneGammaData(const G4HepEmGammaData* data, double maxEkin) {
+  if (data == nullptr) {
+    return nullptr;
+  }
+  G4HepEmGammaData* pruned = new G4HepEmGammaData(*data);
+  const int numConv     = data->fConvEnergyGridSize;
+  const int numComp     = data->fCompEnergyGridSize;
+  const int numConvKeep = HepEmStatePruner::GetNumGridPoints(numConv, data->fConvLogMinEkin, data->fConvEILDelta, maxEkin);
+  const int numCompKeep = HepEmStatePruner::GetNumGridPoints(numComp, data->fCompLogMinEkin, data->fCompEILDelta, maxEkin);
+  pruned->fConvEnergyGridSize = numConvKeep;
+  pruned->fCompEnergyGridSize = numCompKeep;
+  pruned->fConvEnergyGrid     = new double[numConvKeep];
+  pruned->fCompEnergyGrid     = new double[numCompKeep];
+  std::copy(data->fConvEnergyGrid, data->fConvEnergyGrid + numConvKeep, pruned->fConvEnergyGrid);
+  std::copy(data->fCompEnergyGrid, data->fCompEnergyGrid + numCompKeep, pruned->fCompEnergyGrid);
+  // conversion then Compton (value, sd) pairs per material
+  pruned->fConvCompMacXsecData = new double[2*data->fNumMaterials*(numConvKeep + numCompKeep)];
+  for (int im=0; im<data->fNumMaterials; ++im) {
+    const double* src = data->fConvCompMacXsecData + 2*(numConv + numComp)*im;
+    double*       dst = pruned->fConvCompMacXsecData + 2*(numConvKeep + numCompKeep)*im;
+    std::copy(src, src + 2*numConvKeep, dst);
+    std::copy(src + 2*numConv, src + 2*numConv + 2*numCompKeep, dst + 2*numConvKeep);
+  }
+  return pruned;
+}
+
+
+G4HepEmState* HepEmStatePruner::Prune(const G4HepEmState& state, const std::vector<int>& g4MatCutIndices, double primaryEnergy, int verbosity) {
+  const G4HepEmData* data = state.fData;
+  if (data == nullptr || data->fTheMatCutData == nullptr) {
+    return new G4HepEmState(state);
+  }
+  // the kept couples (in their original order)
+  const G4HepEmMatCutData* mcData = data->fTheMatCutData;
+  std::vector<int> keptMC;
+  for (int ig : g4MatCutIndices) {
+    if (ig >= 0 && ig < mcData->fNumG4MatCuts && mcData->fG4MCIndexToHepEmMCIndex[ig] >= 0) {
+      keptMC.push_back(mcData->fG4MCIndexToHepEmMCIndex[ig]);
+    }
+  }
+  std::sort(keptMC.begin(), keptMC.end());
+  keptMC.erase(std::unique(keptMC.begin(), keptMC.end()), keptMC.end());
+  // e+ of the primary energy can annihilate in flight
+  const double maxEkin = kSafetyFactor*(primaryEnergy + 2.0*kElectronMassC2);
+  //
+  G4HepEmData* pruned = new G4HepEmData(*data);
+  pruned->fTheMatCutData   = PruneMatCutData(mcData, keptMC);
+  pruned->fTheElectronData = PruneElectronData(data->fTheElectronData, keptMC, maxEkin);
+  pruned->fThePositronData = PruneElectronData(data->fThePositronData, keptMC, maxEkin);
+  pruned->fTheSBTableData  = PruneSBTableData(data->fTheSBTableData, keptMC);
+  pruned->fTheGammaData    = PruneGammaData(data->fTheGammaData, maxEkin);
+  G4HepEmState* prunedState = new G4HepEmState(state);
+  prunedState->fData = pruned;
+  if (verbosity > 0) {
+    // the size of the images gives the memory of all the tables
+    std::vector<char> image;
+    HepEmStateImage::Serialise(state, image);
+    const double sizeBefore = image.size()/1024.0;
+    image.clear();
+    HepEmStateImage::Serialise(*prunedState, image);
+    const double sizeAfter = image.size()/1024.0;
+    std::cout << std::setprecision(4);
+    std::cout << " === G4HepEm state pruned to " << keptMC.size() << " (of " << mcData->fNumMatCutData << ") material-cuts couples and kinetic energies up to "
+              << maxEkin << " [MeV]: tables " << sizeBefore << " [kB] -> " << sizeAfter << " [kB] ("
+              << sizeBefore - sizeAfter << " [kB] saved)" << std::endl;
+  }
+  return prunedState;
+}
+
+
+int HepEmStatePruner::GetNumGridPoints(int numPoints, double logMinEkin, double invLogDelta, double maxEkin) {
+  // the bin of `maxEkin` and its upper edge are kept
+  const double bin = (std::log(maxEkin) - logMinEkin)*invLogDelta;
+  if (!(bin < numPoints)) {
+    return numPoints;
+  }
+  return std::min(numPoints, std::max(2, static_cast<int>(bin) + 2));
+}
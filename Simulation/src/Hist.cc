@@ -11,7 +11,8 @@ Hist::Hist(const std::string& fname, double min, double max, int numbin)
   fDelta(0.),
   fInvDelta(1.),
   fSum(0.),
-  fNumBins(numbin) {
+  fNumBins(numbin),
+  fIsExact(false) {
   fDelta    = (fMax - fMin) / fNumBins;
   fInvDelta = 1./fDelta;
   Initialize();
@@ -24,7 +25,8 @@ Hist::Hist(const std::string& fname, double min, double max, double delta)
   fDelta(delta),
   fInvDelta(1.),
   fSum(0.),
-  fNumBins(0) {
+  fNumBins(0),
+  fIsExact(false) {
   fInvDelta = 1./fDelta;
   fNumBins = (int)((fMax - fMin) / (fDelta)) + 1.0;
   Initialize();
@@ -37,7 +39,8 @@ Hist::Hist()
   fDelta(0.),
   fInvDelta(1.),
   fSum(0.),
-  fNumBins(10) {
+  fNumBins(10),
+  fIsExact(false) {
   fDelta    = (fMax - fMin) / fNumBins;
   fInvDelta = 1./fDelta;
   Initialize();
@@ -51,6 +54,15 @@ void Hist::Initialize() {
     fx[i] = fMin + i * fDelta;
   }
   fSum = 0.0;
+  // the exact accumulators are allocated only if needed
+  fyExact.assign(fIsExact ? fNumBins : 0, ExactSum());
+  fSumExact = ExactSum();
+}
+
+
+void Hist::SetExact(bool isExact) {
+  fIsExact = isExact;
+  Initialize();
 }
 
 
@@ -77,6 +89,11 @@ void Hist::Fill(double x) {
   }
 */
   if (indx>-1 && indx<fNumBins) {
+    if (fIsExact) {
+      fyExact[indx].Add(1.0);
+      fSumExact.Add(1.0);
+      return;
+    }
     fy[indx] += 1.0;
     fSum     += 1.0;
   }
@@ -95,6 +112,11 @@ void Hist::Fill(double x, double w) {
   }
 */
   if (indx>-1 && indx<fNumBins) {
+    if (fIsExact) {
+      fyExact[indx].Add(w);
+      fSumExact.Add(w);
+      return;
+    }
     fy[indx] += w; //1.0 * w;
     fSum     += w;
   }
@@ -102,6 +124,13 @@ void Hist::Fill(double x, double w) {
 
 
 void Hist::Scale(double sc) {
+  // convert the exact sums to doubles first (in the exact mode)
+  if (fIsExact) {
+    for (int i = 0; i < fNumBins; ++i) {
+      fy[i] = fyExact[i].GetValue();
+    }
+    fSum = fSumExact.GetValue();
+  }
   for (int i = 0; i < fNumBins; ++i) {
     fy[i] *= sc;
   }
@@ -149,6 +178,12 @@ void Hist::Add(const Hist* hist) {
            << " histograms have different dimensions ! "
            << std::endl;
   }
+  if (fIsExact) {
+    for (int i = 0; i < fNumBins; ++i) {
+      fyExact[i].Add(hist->fyExact[i]);
+    }
+    fSumExact.Add(hist->fSumExact);
+  }
   for (int i = 0; i < fNumBins; ++i) {
     fy[i] += hist->GetY()[i];
   }
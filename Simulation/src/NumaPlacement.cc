@@ -0,0 +1,179 @@
+
+#include "NumaPlacement.hh"
+
+#include "HepEmStateArena.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+// NOTE: this is Linux specific!
+#include <pthread.h>
+#include <sched.h>
+#include <dirent.h>
+
+
+NumaPlacement::NumaPlacement(G4HepEmState& theState, int numThreads, int backing)
+: fState(theState), fBacking(std::max(static_cast<int>(HepEmStateArena::kArena), backing)) {
+  // the CPUs the process is allowed to run on (e.g. restricted by `taskset` or the batch system)
+  std::vector<int> allowed;
+  cpu_set_t theSet;
+  CPU_ZERO(&theSet);
+  if (sched_getaffinity(0, sizeof(theSet), &theSet) == 0) {
+    for (int cpu=0; cpu<CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &theSet)) {
+        allowed.push_back(cpu);
+      }
+    }
+  }
+  // the NUMA topology: a single node with all the allowed CPUs if not available
+  std::vector<NodeCPUs> nodeCPUs = ReadNodeCPUs();
+  if (nodeCPUs.empty()) {
+    nodeCPUs.push_back({ 0, allowed });
+  }
+  const int maxCPU = allowed.empty() ? 0 : allowed.back();
+  fCPUToNode.assign(maxCPU + 1, 0);
+  for (std::size_t in=0; in<nodeCPUs.size(); ++in) {
+    fNodeIDs.push_back(nodeCPUs[in].fNodeID);
+    for (int cpu : nodeCPUs[in].fCPUs) {
+      if (cpu <= maxCPU) {
+        fCPUToNode[cpu] = static_cast<int>(in);
+      }
+    }
+  }
+  // order the allowed CPUs by their node (stable: by their index within a node)
+  fCPUs = allowed;
+  std::stable_sort(fCPUs.begin(), fCPUs.end(), [&](int a, int b) { return fCPUToNode[a] < fCPUToNode[b]; });
+  //
+  fReplicas.assign(nodeCPUs.size(), nullptr);
+  fReplicaOnce.reset(new std::once_flag[nodeCPUs.size()]);
+  fWorkers.assign(numThreads, WorkerPlacement());
+  for (WorkerPlacement& thePlacement : fWorkers) {
+    thePlacement.fCPU         = -1;
+    thePlacement.fNode        = 0;
+    thePlacement.fReplicaNode = 0;
+    thePlacement.fActualCPU   = -1;
+    CPU_ZERO(&thePlacement.fOriginalAffinity);
+  }
+}
+
+
+G4HepEmState& NumaPlacement::SetUpWorker(int threadID) {
+  WorkerPlacement& thePlacement = fWorkers[threadID];
+  // NOTE: the original affinity is kept only if it can be restored
+  if (!fCPUs.empty() && pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &thePlacement.fOriginalAffinity) == 0) {
+    const int cpu = fCPUs[threadID % fCPUs.size()];
+    cpu_set_t theSet;
+    CPU_ZERO(&theSet);
+    CPU_SET(cpu, &theSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(theSet), &theSet) == 0) {
+      thePlacement.fCPU  = cpu;
+      thePlacement.fNode = GetNode(cpu);
+    }
+  }
+  // NOTE: the replica of the node is made (copied, i.e. first touched) by this worker if it's the first on the node
+  const int node = thePlacement.fCPU < 0 ? GetNode(sched_getcpu()) : thePlacement.fNode;
+  std::call_once(fReplicaOnce[node], [&]() { fReplicas[node] = HepEmStateArena::Relayout(&fState, fBacking, 0); });
+  thePlacement.fReplicaNode = node;
+  thePlacement.fActualCPU   = sched_getcpu();
+  return *fReplicas[node];
+}
+
+
+void NumaPlacement::TearDownWorker(int threadID) {
+  const WorkerPlacement& thePlacement = fWorkers[threadID];
+  if (thePlacement.fCPU > -1) {
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &thePlacement.fOriginalAffinity);
+  }
+}
+
+
+void NumaPlacement::Report() const {
+  std::cout << " === NumaPlacement: " << fWorkers.size() << " workers on " << fCPUs.size() << " CPUs of "
+            << fReplicas.size() << " NUMA node(s) with "
+            << std::count_if(fReplicas.begin(), fReplicas.end(), [](const G4HepEmState* s) { return s != nullptr; })
+            << " state replica(s)" << std::endl;
+  for (std::size_t it=0; it<fWorkers.size(); ++it) {
+    const WorkerPlacement& thePlacement = fWorkers[it];
+    std::cout << "     - worker " << it << " : ";
+    if (thePlacement.fCPU < 0) {
+      std::cout << "not pinned";
+    } else {
+      std::cout << "cpu " << thePlacement.fCPU << " (node " << fNodeIDs[thePlacement.fNode] << ")";
+    }
+    std::cout << ", state replica of node " << fNodeIDs[thePlacement.fReplicaNode]
+              << ", was on cpu " << thePlacement.fActualCPU << std::endl;
+  }
+}
+
+
+int NumaPlacement::GetNode(int cpu) const {
+  return cpu >= 0 && cpu < static_cast<int>(fCPUToNode.size()) ? fCPUToNode[cpu] : 0;
+}
+
+
+std::vector<NumaPlacement::NodeCPUs> NumaPlacement::ReadNodeCPUs() {
+  std::vector<NodeCPUs> nodeCPUs;
+  const std::string path = "/sys/devices/system/node/";
+  DIR* dir = opendir(path.c_str());
+  if (dir == nullptr) {
+    return nodeCPUs;
+  }
+  // collect the node indices (the directory is not ordered)
+  std::vector<int> nodes;
+  while (struct dirent* entry = readdir(dir)) {
+    int node;
+    char rest;
+    if (sscanf(entry->d_name, "node%d%c", &node, &rest) == 1) {
+      nodes.push_back(node);
+    }
+  }
+  closedir(dir);
+  std::sort(nodes.begin(), nodes.end());
+  for (int node : nodes) {
+    const std::string fileName = path + "node" + std::to_string(node) + "/cpulist";
+    FILE* f = fopen(fileName.c_str(), "r");
+    if (f == nullptr) {
+      continue;
+    }
+    char list[4096] = {0};
+    if (fgets(list, sizeof(list), f) != nullptr) {
+      std::vector<int> cpus = ParseCPUList(list);
+      // memory-only nodes (without CPUs) are skipped (the node ID is kept with the CPUs)
+      if (!cpus.empty()) {
+        nodeCPUs.push_back({ node, cpus });
+      }
+    }
+    fclose(f);
+  }
+  return nodeCPUs;
+}
+
+
+std::vector<int> NumaPlacement::ParseCPUList(const char* list) {
+  std::vector<int> cpus;
+  const char* ptr = list;
+  while (*ptr != '\0' && *ptr != '\n') {
+    char* end;
+    const long first = std::strtol(ptr, &end, 10);
+    if (end == ptr) {
+      break;
+    }
+    long last = first;
+    ptr = end;
+    if (*ptr == '-') {
+      last = std::strtol(ptr + 1, &end, 10);
+      ptr  = end;
+    }
+    for (long cpu=first; cpu<=last; ++cpu) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+    if (*ptr == ',') {
+      ++ptr;
+    }
+  }
+  return cpus;
+}
@@ -30,5 +30,5 @@ double G4HepEmRandomEngine::flat() {
 }
 
 void G4HepEmRandomEngine::flatArray(const int size, double *vect) {
-  for (int i = 0; i < size; i++) vect[i] = ((URandom*)fObject)->flat();
+  ((URandom*)fObject)->flatArray(size, vect);
 }
@@ -5,6 +5,8 @@
 
 #include <iostream>
 #include <iomanip>
+#include <cstdio>
+#include <cstdlib>
 
 
 void WriteResults(struct Results& res, int numEvents) {
@@ -18,33 +20,183 @@ void WriteResults(struct Results& res, int numEvents) {
   res.fGammaTrackLenghtPerLayer.WriteToFile(false);
   res.fElPosTrackLenghtPerLayer.WriteToFile(false);
 
-  //
-  res.fEdepAbs  = res.fEdepAbs*norm;
-  res.fEdepAbs2 = res.fEdepAbs2*norm;
-  const double rmsEAbs = std::sqrt(std::abs(res.fEdepAbs2 - res.fEdepAbs*res.fEdepAbs));
-
-  res.fEdepGap  = res.fEdepGap*norm;
-  res.fEdepGap2 = res.fEdepGap2*norm;
-  const double rmsEGap = std::sqrt(std::abs(res.fEdepGap2 - res.fEdepGap*res.fEdepGap));
+  // the per-cell energy deposit (if any readout segmentation)
+  if (!res.fEdepPerCell.empty()) {
+    WriteEdepPerCell(res, norm);
+  }
+  // the 3D scoring mesh (if active)
+  if (res.fEdepMesh.IsActive()) {
+    res.fEdepMesh.Scale(norm);
+    res.fEdepMesh.WriteToFile(numEvents);
+  }
 
+  // the raw state of the accumulators (for combining jobs)
+  WriteMoments(res);
 
   // the secondary type and step number statistics
   std::cout << std::endl;
   std::cout << " --- Results::WriteResults ---------------------------------- " << std::endl;
   std::cout << std::setprecision(6);
-  std::cout << " Absorber: mean Edep = " << res.fEdepAbs << " [MeV] and  Std-dev = " << rmsEAbs << " [MeV]"<< std::endl;
-  std::cout << " Gap     : mean Edep = " << res.fEdepGap << " [MeV] and  Std-dev = " << rmsEGap << " [MeV]"<< std::endl;
+  std::cout << " Absorber: mean Edep = " << res.fEdepAbs.GetMean() << " [MeV] and  Std-dev = " << res.fEdepAbs.GetStdDev() << " [MeV]"<< std::endl;
+  std::cout << " Gap     : mean Edep = " << res.fEdepGap.GetMean() << " [MeV] and  Std-dev = " << res.fEdepGap.GetStdDev() << " [MeV]"<< std::endl;
 
   std::cout << std::endl;
   std::cout << std::setprecision(14);
-  std::cout << " Mean number of gamma       " << res.fNumSecGamma*norm    << std::endl;
-  std::cout << " Mean number of e-          " << res.fNumSecElectron*norm << std::endl;
-  std::cout << " Mean number of e+          " << res.fNumSecPositron*norm << std::endl;
+  std::cout << " Mean number of gamma       " << res.fNumSecGamma.GetMean()    << std::endl;
+  std::cout << " Mean number of e-          " << res.fNumSecElectron.GetMean() << std::endl;
+  std::cout << " Mean number of e+          " << res.fNumSecPositron.GetMean() << std::endl;
 
   std::cout << std::endl;
   std::cout << std::setprecision(6)
-            << " Mean number of e-/e+ steps " << res.fNumStepsElPos*norm  << std::endl;
-  std::cout << " Mean number of gamma steps " << res.fNumStepsGamma*norm  << std::endl;
+            << " Mean number of e-/e+ steps " << res.fNumStepsElPos.GetMean()  << std::endl;
+  std::cout << " Mean number of gamma steps " << res.fNumStepsGamma.GetMean()  << std::endl;
+  std::cout << " Mean number of zero steps  " << res.fNumZeroSteps.GetMean()   << std::endl;
+  if (res.fEdepMesh.IsActive()) {
+    std::cout << std::endl;
+    res.fEdepMesh.PrintStatistics();
+  }
   std::cout << " ------------------------------------------------------------\n";
 
 }
+
+
+void SetReproducible(struct Results& res, bool isReproducible) {
+  res.fIsReproducible = isReproducible;
+  res.fEdepPerLayer.SetExact(isReproducible);
+  res.fGammaTrackLenghtPerLayer.SetExact(isReproducible);
+  res.fElPosTrackLenghtPerLayer.SetExact(isReproducible);
+  res.fEdepPerCell.assign(res.fEdepPerCell.size(), 0.0);
+  res.fEdepPerCellExact.assign(isReproducible ? res.fEdepPerCell.size() : 0, ExactSum());
+  res.fEdepMesh.SetExact(isReproducible);
+  for (Moments* mom : { &res.fEdepAbs, &res.fEdepGap, &res.fNumSecGamma, &res.fNumSecElectron, &res.fNumSecPositron, &res.fNumStepsGamma, &res.fNumStepsElPos, &res.fNumZeroSteps }) {
+    mom->SetExact(isReproducible);
+  }
+}
+
+
+void WriteMoments(const struct Results& res) {
+  FILE* f = fopen("results_Moments", "w");
+  if (!f) {
+    std::cerr << "\n ***** ERROR in WriteMoments  "
+              << " cannot create the file = results_Moments"
+              << std::endl;
+    exit(1);
+  }
+  const char*    names[] = { "EdepAbs", "EdepGap", "NumSecGamma", "NumSecElectron", "NumSecPositron", "NumStepsGamma", "NumStepsElPos", "NumZeroSteps" };
+  const Moments* moms[]  = { &res.fEdepAbs, &res.fEdepGap, &res.fNumSecGamma, &res.fNumSecElectron, &res.fNumSecPositron, &res.fNumStepsGamma, &res.fNumStepsElPos, &res.fNumZeroSteps };
+  for (int i=0; i<8; ++i) {
+    moms[i]->Write(f, names[i]);
+  }
+  fclose(f);
+}
+
+
+void WriteEdepPerCell(const struct Results& res, double norm) {
+  FILE* f = fopen("hist_Edep_PerCell", "w");
+  if (!f) {
+    std::cerr << "\n ***** ERROR in WriteEdepPerCell  "
+              << " cannot create the file = hist_Edep_PerCell"
+              << std::endl;
+    exit(1);
+  }
+  const int numCellsYZ = res.fNumCellsY*res.fNumCellsZ;
+  const int numCells   = static_cast<int>(res.fEdepPerCell.size());
+  for (int ic=0; ic<numCells; ++ic) {
+    const double edep = res.fIsReproducible ? res.fEdepPerCellExact[ic].GetValue() : res.fEdepPerCell[ic];
+    if (edep == 0.0) {
+      continue;
+    }
+    // decode the global cell index
+    const int is     = ic/numCellsYZ;
+    const int iLayer = res.fIsAbsorberSegmented ? is/2 : is;
+    const int iAbs   = res.fIsAbsorberSegmented ? is%2 : 1;
+    const int iy     = (ic%numCellsYZ)/res.fNumCellsZ;
+    const int iz     = ic%res.fNumCellsZ;
+    fprintf(f, "%d\t%d\t%d\t%d\t%d\t%.8g\n", ic, iLayer, iAbs, iy, iz, edep*norm);
+  }
+  fclose(f);
+}
+
+
+void MergeResults(struct Results& res, const struct Results& other) {
+  res.fEdepPerLayer.Add(&other.fEdepPerLayer);
+  res.fGammaTrackLenghtPerLayer.Add(&other.fGammaTrackLenghtPerLayer);
+  res.fElPosTrackLenghtPerLayer.Add(&other.fElPosTrackLenghtPerLayer);
+  for (std::size_t ic=0; ic<res.fEdepPerCell.size(); ++ic) {
+    res.fEdepPerCell[ic] += other.fEdepPerCell[ic];
+  }
+  for (std::size_t ic=0; ic<res.fEdepPerCellExact.size(); ++ic) {
+    res.fEdepPerCellExact[ic].Add(other.fEdepPerCellExact[ic]);
+  }
+  if (res.fEdepMesh.IsActive()) {
+    res.fEdepMesh.Add(other.fEdepMesh);
+  }
+  //
+  res.fEdepAbs.Merge(other.fEdepAbs);
+  res.fEdepGap.Merge(other.fEdepGap);
+  //
+  res.fNumSecGamma.Merge(other.fNumSecGamma);
+  res.fNumSecElectron.Merge(other.fNumSecElectron);
+  res.fNumSecPositron.Merge(other.fNumSecPositron);
+  //
+  res.fNumStepsGamma.Merge(other.fNumStepsGamma);
+  res.fNumStepsElPos.Merge(other.fNumStepsElPos);
+  res.fNumZeroSteps.Merge(other.fNumZeroSteps);
+}
+
+
+void CopyResultsForReplica(struct Results& replica, struct Results& res) {
+  // copy everything but the mesh (it's moved out and back meanwhile so its grid is not copied)
+  ScoringMesh theRunMesh;
+  std::swap(theRunMesh, res.fEdepMesh);
+  replica = res;
+  std::swap(theRunMesh, res.fEdepMesh);
+  // the mesh of the replica has only its per-event hash (if active)
+  if (res.fEdepMesh.IsActive()) {
+    replica.fEdepMesh.ShareRunGrid(res.fEdepMesh);
+  }
+}
+
+
+void ReduceResultsStep(const std::vector<Results*>& replicas, int threadID, int stride) {
+  const int numReplicas = static_cast<int>(replicas.size());
+  if (threadID % (2*stride) == 0 && threadID + stride < numReplicas) {
+    MergeResults(*replicas[threadID], *replicas[threadID + stride]);
+  }
+}
+
+
+void ReduceResults(Results& snapshot, const std::vector<Results*>& replicas) {
+  const int numReplicas = static_cast<int>(replicas.size());
+  if (numReplicas == 0) {
+    return;
+  }
+  // the same pairwise order as in the parallel reduction but on copies (without
+  // the run level grid of the scoring mesh, that is shared by all replicas)
+  std::vector<Results> theCopies(numReplicas);
+  std::vector<Results*> theReplicas(numReplicas);
+  for (int ir=0; ir<numReplicas; ++ir) {
+    CopyResultsForReplica(theCopies[ir], *replicas[ir]);
+    theReplicas[ir] = &theCopies[ir];
+  }
+  for (int stride=1; stride<numReplicas; stride*=2) {
+    for (int ir=0; ir<numReplicas; ir+=2*stride) {
+      ReduceResultsStep(theReplicas, ir, stride);
+    }
+  }
+  snapshot = theCopies[0];
+}
+
+
+void MergeResultsPerEvent(struct ResultsPerEvent& res, const struct ResultsPerEvent& other) {
+  res.fEdepAbs        += other.fEdepAbs;
+  res.fEdepGap        += other.fEdepGap;
+  //
+  res.fNumSecGamma    += other.fNumSecGamma;
+  res.fNumSecElectron += other.fNumSecElectron;
+  res.fNumSecPositron += other.fNumSecPositron;
+  //
+  res.fNumStepsGamma  += other.fNumStepsGamma;
+  res.fNumStepsElPos  += other.fNumStepsElPos;
+  res.fNumZeroSteps   += other.fNumZeroSteps;
+}
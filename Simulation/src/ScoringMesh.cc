@@ -0,0 +1,249 @@
+#include "ScoringMesh.hh"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+
+// initial capacity of the per-event hash (power of 2)
+static const int kInitialHashLog2 = 10;
+
+// serialises the flushes into the run level grids (some are shared by several meshes)
+static std::mutex gRunGridMutex;
+
+ScoringMesh::ScoringMesh()
+: fFileName(""),
+  fNumVoxelsTotal(0),
+  fIsExact(false),
+  fRunMesh(nullptr),
+  fHashMask(0),
+  fHashShift(64),
+  fNumFlushes(0),
+  fNumFills(0),
+  fNumTouchedSum(0),
+  fNumTouchedPeak(0) {
+  for (int i=0; i<3; ++i) {
+    fNumVoxels[i] = 0;
+    fMin[i]       = 0.0;
+    fMax[i]       = 0.0;
+    fInvSize[i]   = 0.0;
+  }
+}
+
+
+void ScoringMesh::ReSet(const std::string& filename, const int* numVoxels, const double* min, const double* max) {
+  fFileName       = filename;
+  fNumVoxelsTotal = 0;
+  fRunMesh        = nullptr;
+  fGrid.clear();
+  fGridExact.clear();
+  fHashKeys.clear();
+  fHashVals.clear();
+  fHashTouched.clear();
+  fNumFlushes     = 0;
+  fNumFills       = 0;
+  fNumTouchedSum  = 0;
+  fNumTouchedPeak = 0;
+  if (numVoxels[0] < 1 || numVoxels[1] < 1 || numVoxels[2] < 1) {
+    return;
+  }
+  const int64_t numVoxelsTotal = GetNumVoxelsTotal(numVoxels);
+  if (numVoxelsTotal > kMaxNumVoxels) {
+    std::cerr << "\n ***** ERROR in ScoringMesh::ReSet  "
+              << " too many voxels = " << numVoxelsTotal << " (maximum " << kMaxNumVoxels << ") : mesh disabled !"
+              << std::endl;
+    return;
+  }
+  for (int i=0; i<3; ++i) {
+    fNumVoxels[i] = numVoxels[i];
+    fMin[i]       = min[i];
+    fMax[i]       = max[i];
+    fInvSize[i]   = numVoxels[i]/(max[i] - min[i]);
+  }
+  fNumVoxelsTotal = static_cast<std::size_t>(numVoxelsTotal);
+  fGrid.assign(fNumVoxelsTotal, 0.0);
+  if (fIsExact) {
+    fGridExact.assign(fNumVoxelsTotal, ExactSum());
+  }
+  // the per-event hash (grows on demand)
+  fHashKeys.assign(std::size_t(1) << kInitialHashLog2, -1);
+  fHashVals.assign(std::size_t(1) << kInitialHashLog2, 0.0);
+  fHashMask  = fHashKeys.size() - 1;
+  fHashShift = 64 - kInitialHashLog2;
+}
+
+
+void ScoringMesh::SetExact(bool isExact) {
+  fIsExact = isExact;
+  fGrid.assign(fNumVoxelsTotal, 0.0);
+  fGridExact.assign(fIsExact ? fNumVoxelsTotal : 0, ExactSum());
+}
+
+
+void ScoringMesh::ShareRunGrid(ScoringMesh& theRunMesh) {
+  // reset as an inactive mesh first (i.e. without allocating any grid) then take the dimensions
+  const int noVoxels[3] = { 0, 0, 0 };
+  ReSet(theRunMesh.fFileName, noVoxels, theRunMesh.fMin, theRunMesh.fMax);
+  if (!theRunMesh.IsActive()) {
+    return;
+  }
+  for (int i=0; i<3; ++i) {
+    fNumVoxels[i] = theRunMesh.fNumVoxels[i];
+    fMin[i]       = theRunMesh.fMin[i];
+    fMax[i]       = theRunMesh.fMax[i];
+    fInvSize[i]   = theRunMesh.fInvSize[i];
+  }
+  fNumVoxelsTotal = theRunMesh.fNumVoxelsTotal;
+  fIsExact        = theRunMesh.fIsExact;
+  fRunMesh        = &theRunMesh;
+  // the per-event hash (grows on demand)
+  fHashKeys.assign(std::size_t(1) << kInitialHashLog2, -1);
+  fHashVals.assign(std::size_t(1) << kInitialHashLog2, 0.0);
+  fHashMask  = fHashKeys.size() - 1;
+  fHashShift = 64 - kInitialHashLog2;
+}
+
+
+void ScoringMesh::EndOfEvent() {
+  if (!IsActive()) {
+    return;
+  }
+  // flush the touched voxels into the (own or shared) run level grid and clear only their slots
+  {
+    std::lock_guard<std::mutex> lock(gRunGridMutex);
+    ScoringMesh& theRunMesh = fRunMesh != nullptr ? *fRunMesh : *this;
+    if (fIsExact) {
+      for (int slot : fHashTouched) {
+        theRunMesh.fGridExact[fHashKeys[slot]].Add(fHashVals[slot]);
+      }
+    } else {
+      for (int slot : fHashTouched) {
+        theRunMesh.fGrid[fHashKeys[slot]] += fHashVals[slot];
+      }
+    }
+  }
+  for (int slot : fHashTouched) {
+    fHashKeys[slot] = -1;
+  }
+  const std::size_t numTouched = fHashTouched.size();
+  fNumTouchedSum  += numTouched;
+  fNumTouchedPeak  = std::max(fNumTouchedPeak, numTouched);
+  ++fNumFlushes;
+  fHashTouched.clear();
+}
+
+
+void ScoringMesh::GrowHash() {
+  const std::vector<int>    keys(fHashKeys);
+  const std::vector<double> vals(fHashVals);
+  const std::vector<int>    touched(fHashTouched);
+  const std::size_t capacity = 2*fHashKeys.size();
+  fHashKeys.assign(capacity, -1);
+  fHashVals.assign(capacity, 0.0);
+  fHashMask  = capacity - 1;
+  fHashShift = fHashShift - 1;
+  fHashTouched.clear();
+  fHashTouched.reserve(capacity/2);
+  for (int slot : touched) {
+    std::size_t newSlot = Hash(keys[slot]);
+    while (fHashKeys[newSlot] > -1) {
+      newSlot = (newSlot + 1) & fHashMask;
+    }
+    fHashKeys[newSlot] = keys[slot];
+    fHashVals[newSlot] = vals[slot];
+    fHashTouched.push_back(static_cast<int>(newSlot));
+  }
+}
+
+
+void ScoringMesh::Add(const ScoringMesh& other) {
+  if (fNumVoxelsTotal != other.fNumVoxelsTotal) {
+    std::cerr << "\n ***** ERROR in ScoringMesh::Add  "
+              << " meshes have different dimensions ! "
+              << std::endl;
+    return;
+  }
+  // the data of a mesh that shares a run level grid is already there
+  if (!other.IsSharingRunGrid()) {
+    for (std::size_t i=0; i<fNumVoxelsTotal; ++i) {
+      fGrid[i] += other.fGrid[i];
+    }
+    for (std::size_t i=0; i<fGridExact.size(); ++i) {
+      fGridExact[i].Add(other.fGridExact[i]);
+    }
+  }
+  fNumFlushes     += other.fNumFlushes;
+  fNumFills       += other.fNumFills;
+  fNumTouchedSum  += other.fNumTouchedSum;
+  fNumTouchedPeak  = std::max(fNumTouchedPeak, other.fNumTouchedPeak);
+}
+
+
+void ScoringMesh::Scale(double factor) {
+  // convert the exact sums to doubles first (in the exact mode)
+  for (std::size_t i=0; i<fGridExact.size(); ++i) {
+    fGrid[i] = fGridExact[i].GetValue();
+  }
+  for (double& val : fGrid) {
+    val *= factor;
+  }
+}
+
+
+std::size_t ScoringMesh::GetMemoryInBytes() const {
+  return fGrid.capacity()*sizeof(double) + fGridExact.capacity()*sizeof(ExactSum)
+         + fHashKeys.capacity()*sizeof(int) + fHashVals.capacity()*sizeof(double) + fHashTouched.capacity()*sizeof(int);
+}
+
+
+void ScoringMesh::WriteToFile(uint64_t numEvents) const {
+  if (!IsActive()) {
+    return;
+  }
+  FILE* f = fopen(fFileName.c_str(), "wb");
+  if (!f) {
+    std::cerr << "\n ***** ERROR in ScoringMesh::WriteToFile  "
+              << " cannot create the file = " << fFileName
+              << std::endl;
+    exit(1);
+  }
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  std::memcpy(header.fMagic, "HEPEMSH3", 8);
+  header.fVersion = 1;
+  for (int i=0; i<3; ++i) {
+    header.fNumVoxels[i] = static_cast<uint32_t>(fNumVoxels[i]);
+    header.fMin[i]       = fMin[i];
+    header.fMax[i]       = fMax[i];
+  }
+  header.fNumEvents = numEvents;
+  const bool isOK = fwrite(&header, sizeof(Header), 1, f) == 1
+                    && fwrite(fGrid.data(), sizeof(double), fGrid.size(), f) == fGrid.size();
+  fclose(f);
+  if (!isOK) {
+    std::cerr << "\n ***** ERROR in ScoringMesh::WriteToFile  "
+              << " cannot write the file = " << fFileName
+              << std::endl;
+    exit(1);
+  }
+}
+
+
+void ScoringMesh::PrintStatistics() const {
+  if (!IsActive()) {
+    return;
+  }
+  const double meanTouched = fNumFlushes > 0 ? static_cast<double>(fNumTouchedSum)/fNumFlushes : 0.0;
+  const double meanFills   = fNumFlushes > 0 ? static_cast<double>(fNumFills)/fNumFlushes : 0.0;
+  std::cout << std::setprecision(6);
+  std::cout << " Scoring mesh: " << fNumVoxels[0] << " x " << fNumVoxels[1] << " x " << fNumVoxels[2]
+            << " voxels written to " << fFileName << std::endl;
+  std::cout << "   - memory: run grid " << (fGrid.capacity()*sizeof(double) + fGridExact.capacity()*sizeof(ExactSum))/1048576.0 << " [MB], per-event hash "
+            << (fHashKeys.capacity()*sizeof(int) + fHashVals.capacity()*sizeof(double) + fHashTouched.capacity()*sizeof(int))/1024.0
+            << " [kB] (" << fHashKeys.size() << " slots)" << std::endl;
+  std::cout << "   - per event: " << meanFills << " fills, " << meanTouched << " touched voxels (peak "
+            << fNumTouchedPeak << ")" << std::endl;
+}
@@ -0,0 +1,93 @@
+
+#include "StepTiming.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+
+// the counters merged from the completed threads
+static StepTiming::Counters gMergedCounters = {};
+static std::mutex           gMergeMutex;
+
+
+// the counters of one thread that are merged when the thread exits
+struct ThreadCounters {
+  StepTiming::Counters fCounters = {};
+  ~ThreadCounters() { StepTiming::Merge(fCounters); }
+};
+
+static thread_local ThreadCounters tlCounters;
+
+
+StepTiming::Counters& StepTiming::GetCounters() {
+  return tlCounters.fCounters;
+}
+
+
+void StepTiming::Merge(const Counters& theCounters) {
+  std::lock_guard<std::mutex> lock(gMergeMutex);
+  for (int ip=0; ip<kNumParticles; ++ip) {
+    for (int iph=0; iph<kNumPhases; ++iph) {
+      gMergedCounters.fCycles[ip][iph] += theCounters.fCycles[ip][iph];
+    }
+    gMergedCounters.fNumTimedSteps[ip] += theCounters.fNumTimedSteps[ip];
+    gMergedCounters.fNumSteps[ip]      += theCounters.fNumSteps[ip];
+  }
+}
+
+
+void StepTiming::Reset() {
+  std::lock_guard<std::mutex> lock(gMergeMutex);
+  std::memset(&gMergedCounters, 0, sizeof(Counters));
+  std::memset(&tlCounters.fCounters, 0, sizeof(Counters));
+}
+
+
+void StepTiming::Report() {
+  // the counters of the calling thread are added to those of the completed threads
+  Merge(tlCounters.fCounters);
+  std::memset(&tlCounters.fCounters, 0, sizeof(Counters));
+  Counters theCounters;
+  {
+    std::lock_guard<std::mutex> lock(gMergeMutex);
+    theCounters = gMergedCounters;
+  }
+  const char* phaseNames[kNumPhases] = { "Locate (DistanceToOut)", "Safety (Box)", "HowFar", "Move", "Perform", "MSC displacement", "StackSecondaries", "SteppingAction" };
+  const char* particleNames[kNumParticles] = { "gamma", "e-/e+" };
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+  const char* unit = "cycles";
+#else
+  const char* unit = "ns";
+#endif
+  // the cost of one reading (included in each phase): median of the back-to-back readings
+  std::vector<std::uint64_t> theDeltas(1001);
+  for (std::uint64_t& delta : theDeltas) {
+    const std::uint64_t t0 = Now();
+    delta = Now() - t0;
+  }
+  std::nth_element(theDeltas.begin(), theDeltas.begin()+500, theDeltas.end());
+  std::printf(" --- StepTiming: %s per step spent in the phases (every %d-th step is timed, %d %s per reading included in each phase)\n", unit, static_cast<int>(kSamplingPeriod), static_cast<int>(theDeltas[500]), unit);
+  for (int ip=0; ip<kNumParticles; ++ip) {
+    const std::uint64_t numTimed = theCounters.fNumTimedSteps[ip];
+    if (numTimed == 0) {
+      continue;
+    }
+    std::uint64_t total = 0;
+    for (int iph=0; iph<kNumPhases; ++iph) {
+      total += theCounters.fCycles[ip][iph];
+    }
+    std::printf("     %s: %llu steps (%llu timed), %.1f %s per step\n", particleNames[ip], static_cast<unsigned long long>(theCounters.fNumSteps[ip]),
+                static_cast<unsigned long long>(numTimed), static_cast<double>(total)/numTimed, unit);
+    for (int iph=0; iph<kNumPhases; ++iph) {
+      if (ip == kGamma && iph == kMSCDisplacement) {
+        continue;
+      }
+      const double perStep = static_cast<double>(theCounters.fCycles[ip][iph])/numTimed;
+      const double share   = total > 0 ? 100.0*theCounters.fCycles[ip][iph]/total : 0.0;
+      std::printf("       - %-24s %12.1f %8.2f %%\n", phaseNames[iph], perStep, share);
+    }
+  }
+}
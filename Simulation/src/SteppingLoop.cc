@@ -17,6 +17,7 @@
 #include "Geometry.hh"
 #include "Box.hh"
 #include "Results.hh"
+#include "StepTiming.hh"
 
 
 
@@ -35,32 +36,33 @@ void SteppingLoop::GammaStepper(G4HepEmTLData& theTLData, G4HepEmState& theState
   G4HepEmTrack* theTrack = theTLData.GetPrimaryGammaTrack()->GetTrack();
 
   //
-  // if this is a real primary track then I need to locate it
-  // if this is a secondary then I could already know, but
-  // anyway: locate in all cases to keep it simply (but slower anyway)
+  // the track is located at its first step (both primaries and secondaries) then
+  // the navigation state is used to skip the full relocation in the next steps
   //
   int  numStep       = 0;
-  Box* currentVolume = nullptr;
   bool onBoundary    = false;
-  int  indxLayer     = -1;
-  int  indxAbs       = -1;
-  double  localPosition[3];
+  NavigationState theNavState;
+  double* localPosition = theNavState.fLocalPosition;
+  // NOTE: the phases of the steps are timed only if `HEPEMSHOW_STEP_TIMING` is defined (see `StepTiming`)
+  STEP_TIMING_TIMER(theTiming, StepTiming::kGamma);
   while (theTrack->GetEKin() > 0.0) {
+    STEP_TIMING_BEGIN(theTiming);
     // calculate distance to boundary from the pre-step point: will locate the pont
     // NOTE: this should never be zero as zero means that the point is outside of the volume
     //       (taking into account the direction and tolerance)
-    // NOTE: the given position will be in local coordiantes at return
+    // NOTE: the local position (with the volume and indices) is written into the navigation state
     double* globalPosition = theTrack->GetPosition();
     double* curDirection   = theTrack->GetDirection();
-    // set the local position = global position (will be local after CalculateDistanceToOut)
-    Set3Vect(localPosition, globalPosition);
-    const double distToBoundary = theGeometry.CalculateDistanceToOut(localPosition, curDirection, &currentVolume, &indxLayer, &indxAbs);
+    const double distToBoundary = theGeometry.CalculateDistanceToOut(globalPosition, curDirection, theNavState);
+    Box* currentVolume = theNavState.fVolume;
+    STEP_TIMING_MARK(theTiming, StepTiming::kLocate);
     // STOP HERE IF `distToBoundary = 1.0E+20` i.e. we are going out from the Calorimeter
     if (distToBoundary > 1.0E+10) {
       return;
     }
     // calculate pre-step point safety
     const double preStepSafety  = currentVolume->DistanceToOut(localPosition);
+    STEP_TIMING_MARK(theTiming, StepTiming::kSafety);
     bool onBoundary = (preStepSafety == 0.0);
     // get the material-cuts couple index from the volume
     const int indxMaterial = currentVolume->GetMaterialIndx();
@@ -75,6 +77,7 @@ void SteppingLoop::GammaStepper(G4HepEmTLData& theTLData, G4HepEmState& theState
     //       2. the result is the straight line distance that the photon needs to travel along the current
     //          direction till the next physics interaction (assuming the same material along)
     G4HepEmGammaManager::HowFar(theState.fData, theState.fParameters, &theTLData);
+    STEP_TIMING_MARK(theTiming, StepTiming::kHowFar);
     const double distToPhysics = theTrack->GetGStepLength();
     //
     // take the shortest from the geometry and the physics step limits as the current (straight line) step length
@@ -91,6 +94,8 @@ void SteppingLoop::GammaStepper(G4HepEmTLData& theTLData, G4HepEmState& theState
     if (stepLength==0.0) {
       stepLength = 1.0E-6;
       AddTo3Vect(globalPosition, curDirection, stepLength);
+      theResult.fPerEventRes.fNumZeroSteps += 1.0;
+      STEP_TIMING_MARK(theTiming, StepTiming::kMove);
       continue;
     }
     // move the track to the corresponding post-step point
@@ -99,19 +104,23 @@ void SteppingLoop::GammaStepper(G4HepEmTLData& theTLData, G4HepEmState& theState
     theTrack->SetGStepLength(stepLength);
     // update the `onBoundary` falg
     theTrack->SetOnBoundary(onBoundary);
+    STEP_TIMING_MARK(theTiming, StepTiming::kMove);
     // Then call `Perform` to do evything needs to be done with the track regarding physics
     // NOTE:
     //  - in case of boundary limited steps: no physics interaction just update
     //       of the `number of interaction left` based on the current step length
     //  - in case of physics limited step: interaction happens additionaly
     G4HepEmGammaManager::Perform(theState.fData, theState.fParameters, &theTLData);
+    STEP_TIMING_MARK(theTiming, StepTiming::kPerform);
     //
     // Take and stack all secondaries (if any) that has been produced.
     if (theTLData.GetNumSecondaryElectronTrack() + theTLData.GetNumSecondaryGammaTrack() > 0 ) {
       StackSecondaries(theTLData, theTrackStack, *theTrack);
     }
+    STEP_TIMING_MARK(theTiming, StepTiming::kStackSecondaries);
     // call the SteppingAction (whenever a step was done in the calorimeter)
-    SteppingAction(theResult, *theTrack, currentVolume, stepLength, indxLayer, indxAbs, eventID, numStep);
+    SteppingAction(theResult, *theTrack, currentVolume, stepLength, theNavState.fIndxLayer, theNavState.fIndxAbs, theNavState.fIndxCell, eventID, numStep);
+    STEP_TIMING_MARK(theTiming, StepTiming::kSteppingAction);
 
     ++numStep;
   }
@@ -123,31 +132,31 @@ void SteppingLoop::ElectronStepper(G4HepEmTLData& theTLData, G4HepEmState& theSt
   G4HepEmTrack*           theTrack = theTLData.GetPrimaryElectronTrack()->GetTrack();
   G4HepEmMSCTrackData*  theMSCData = theTLData.GetPrimaryElectronTrack()->GetMSCTrackData();
   //
-  // if this is a real primary track then I need to locate it
-  // if this is a secondary then I could already know, but
-  // anyway: locate in all cases to keep it simply (but slower anyway)
+  // the track is located at its first step (both primaries and secondaries) then
+  // the navigation state is used to skip the full relocation in the next steps
   //
   int  numStep       = 0;
-  Box* currentVolume = nullptr;
   bool onBoundary    = false;
-  int  indxLayer     = -1;
-  int  indxAbs       = -1;
-  double  localPosition[3];
+  NavigationState theNavState;
+  double* localPosition = theNavState.fLocalPosition;
   bool wasOnBoundary = false;
 //  bool wasPushed     = false;
+  // NOTE: the phases of the steps are timed only if `HEPEMSHOW_STEP_TIMING` is defined (see `StepTiming`)
+  STEP_TIMING_TIMER(theTiming, StepTiming::kElectron);
 
   // keep tracking while the kinetic energy drops to zero (i.e. e-/e+ lose all its energy; e+ annihilates)
   // unless the track is going out of the Calorimeter
   while (theTrack->GetEKin() > 0.0) {
+    STEP_TIMING_BEGIN(theTiming);
     // calculate distance to boundary from the pre-step point: will locate the pont
     // NOTE: this should never be zero as zero means that the point is outside of the volume
     //       (taking into account the direction and tolerance)
-    // NOTE: the given position will be in local coordiantes at return
+    // NOTE: the local position (with the volume and indices) is written into the navigation state
     double* globalPosition = theTrack->GetPosition();
     double* curDirection   = theTrack->GetDirection();
-    // set the local position = global position (will be local after CalculateDistanceToOut)
-    Set3Vect(localPosition, globalPosition);
-    const double distToBoundary = theGeometry.CalculateDistanceToOut(localPosition, curDirection, &currentVolume, &indxLayer, &indxAbs);
+    const double distToBoundary = theGeometry.CalculateDistanceToOut(globalPosition, curDirection, theNavState);
+    Box* currentVolume = theNavState.fVolume;
+    STEP_TIMING_MARK(theTiming, StepTiming::kLocate);
     // STOP HERE IF `distToBoundary = 1.0E+20` i.e. we are going out from the Calorimeter
     if (distToBoundary > 1.0E+10) {
       return;
@@ -155,6 +164,7 @@ void SteppingLoop::ElectronStepper(G4HepEmTLData& theTLData, G4HepEmState& theSt
     // at the pre-step point: calculate safety and check if on-boundary (use only if we do not know that the
     // previous step ended up on boundary i.e. use only in the very first or pushed steps)
     double safety   = currentVolume->DistanceToOut(localPosition);
+    STEP_TIMING_MARK(theTiming, StepTiming::kSafety);
     bool onBoundary = numStep == 0 ? (safety<5.0E-10) : wasOnBoundary;
     const double preStepSafety = onBoundary ? 0.0 : safety;
 
@@ -179,6 +189,7 @@ void SteppingLoop::ElectronStepper(G4HepEmTLData& theTLData, G4HepEmState& theSt
     //       4. also note, that the real length (physical) of the step is longer than the straight light along the
     //          original direction (geometrical) step length due to MSC
     G4HepEmElectronManager::HowFar(theState.fData, theState.fParameters, &theTLData);
+    STEP_TIMING_MARK(theTiming, StepTiming::kHowFar);
     const double distToPhysics = theTrack->GetGStepLength();
     //
     // take the shortest from the geometry and physics step limits as current (straight line) step length
@@ -198,6 +209,8 @@ void SteppingLoop::ElectronStepper(G4HepEmTLData& theTLData, G4HepEmState& theSt
 //      wasPushed  = true;
       stepLength = 1.0E-6;
       AddTo3Vect(globalPosition, curDirection, stepLength);
+      theResult.fPerEventRes.fNumZeroSteps += 1.0;
+      STEP_TIMING_MARK(theTiming, StepTiming::kMove);
       continue;
     }
     // move the track to the corresponding post-step point
@@ -208,6 +221,7 @@ void SteppingLoop::ElectronStepper(G4HepEmTLData& theTLData, G4HepEmState& theSt
     theTrack->SetOnBoundary(onBoundary);
     // store if this step ended up on the boundary
     wasOnBoundary = onBoundary;
+    STEP_TIMING_MARK(theTiming, StepTiming::kMove);
 
     // Then call `Perform` to do evything needs to be done with the track regarding physics
     //  - the continuous interactions will be performed in all cases (i.e. independently
@@ -227,49 +241,22 @@ void SteppingLoop::ElectronStepper(G4HepEmTLData& theTLData, G4HepEmState& theSt
     // take the real, i.e. physical step length (only if MSC is active in G4HepEmElectronManager because the
     // physical step length stays zero when MSC is not active as physical = geometrical in that case)
     const double pStepLength = theMSCData->fTrueStepLength > 0.0 ? theMSCData->fTrueStepLength : stepLength;
+    STEP_TIMING_MARK(theTiming, StepTiming::kPerform);
 
-    // get the displacement and check if we need to apply (should not if the energy is zero but ok keep its simply)
-    // we apply it if its length is lonegr than a minimum and we are not on boudnry (i.e. the current post-step point)
+    // get the displacement and apply it if needed (only if the post-step point is not on boundary)
     if (!onBoundary) {
-      const double* displacement    = theMSCData->GetDisplacement();
-      const double  dLength2        = displacement[0]*displacement[0] + displacement[1]*displacement[1] + displacement[2]*displacement[2];
-      const double  kGeomMinLength  = 5.0e-8;  // 0.05 [nm]
-      const double  kGeomMinLength2 = kGeomMinLength*kGeomMinLength; // (0.05 [nm])^2
-      if (dLength2 > kGeomMinLength2) {
-        // apply displacement
-        // bool isPositionChanged  = true;
-        const double dispR = std::sqrt(dLength2);
-        // update local position by moving to the local longitudinal (i.e. along the original direction) post step-point
-        // just to be able to compute the safety at that point
-        AddTo3Vect(localPosition, orgDirection, stepLength);
-        // compute the current post-step point safety and reduce a bit
-        const double postSafety = 0.99*currentVolume->DistanceToOut(localPosition);
-        if (postSafety > 0.0 && dispR < postSafety) {
-          // far away from boundary: can be applied safely i.e. we won't get to boundary
-          AddTo3Vect(globalPosition, displacement);
-          //near the boundary
-        } else {
-          // displaced point is definitely within the volume
-          if (dispR < postSafety) {
-            AddTo3Vect(globalPosition, displacement);
-          } else if(postSafety > kGeomMinLength) {
-            // reduced displacement
-            const double scale = (postSafety/dispR);
-            AddTo3Vect(globalPosition, displacement, scale);
-          } // else {
-            // very small postSafety
-            // isPositionChanged = false;
-          // }
-        }
-      }
+      ApplyMSCDisplacement(*theTrack, *theMSCData, currentVolume, localPosition, orgDirection, stepLength);
     }
+    STEP_TIMING_MARK(theTiming, StepTiming::kMSCDisplacement);
     //
     // stack all secondaries (if any) that has been produced in this step
     if (theTLData.GetNumSecondaryElectronTrack() + theTLData.GetNumSecondaryGammaTrack() > 0 ) {
       StackSecondaries(theTLData, theTrackStack, *theTrack);
     }
+    STEP_TIMING_MARK(theTiming, StepTiming::kStackSecondaries);
 
-    SteppingAction(theResult, *theTrack, currentVolume, pStepLength, indxLayer, indxAbs, eventID, numStep);
+    SteppingAction(theResult, *theTrack, currentVolume, pStepLength, theNavState.fIndxLayer, theNavState.fIndxAbs, theNavState.fIndxCell, eventID, numStep);
+    STEP_TIMING_MARK(theTiming, StepTiming::kSteppingAction);
 
     ++numStep;
   }
@@ -282,30 +269,28 @@ void SteppingLoop::StackSecondaries(G4HepEmTLData& theTLData, TrackStack& theTra
   const int numSecGamma    = theTLData.GetNumSecondaryGammaTrack();
   const int numSecondaries = numSecElectron+numSecGamma;
   if (numSecondaries>0) {
-    for (int is=0; is<numSecElectron; ++is) {
-      G4HepEmTrack* secTrack = theTLData.GetSecondaryElectronTrack(is)->GetTrack();
-      secTrack->SetID(theTrackStack.GetNextTrackID());
-      secTrack->SetParentID(thePrimary.GetID());
-      secTrack->SetPosition(thePrimary.GetPosition());
-      secTrack->SetMCIndex(thePrimary.GetMCIndex());
-      theTrackStack.Copy(*secTrack, theTrackStack.Insert());
+    // hand over the secondaries (e-/e+ first then gamma) to the stack: they are written directly into its
+    // storage (the IDs, position and material-cuts couple index are set there from the primary)
+    constexpr int kMaxNumBulk = 16;
+    G4HepEmTrack* secTracks[kMaxNumBulk];
+    int numBulk = 0;
+    for (int is=0; is<numSecondaries; ++is) {
+      secTracks[numBulk++] = is < numSecElectron
+                             ? theTLData.GetSecondaryElectronTrack(is)->GetTrack()
+                             : theTLData.GetSecondaryGammaTrack(is-numSecElectron)->GetTrack();
+      if (numBulk == kMaxNumBulk) {
+        theTrackStack.PushSecondaries(secTracks, numBulk, thePrimary);
+        numBulk = 0;
+      }
     }
+    theTrackStack.PushSecondaries(secTracks, numBulk, thePrimary);
     theTLData.ResetNumSecondaryElectronTrack();
-
-    for (int is=0; is<numSecGamma; ++is) {
-      G4HepEmTrack* secTrack = theTLData.GetSecondaryGammaTrack(is)->GetTrack();
-      secTrack->SetID(theTrackStack.GetNextTrackID());
-      secTrack->SetParentID(thePrimary.GetID());
-      secTrack->SetPosition(thePrimary.GetPosition());
-      secTrack->SetMCIndex(thePrimary.GetMCIndex());
-      theTrackStack.Copy(*secTrack, theTrackStack.Insert());
-    }
     theTLData.ResetNumSecondaryGammaTrack();
   }
 }
 
 
-void SteppingLoop::SteppingAction(Results& theResult, const G4HepEmTrack& theTrack, const Box* /*currentVolume*/, double currentPhysStepLength, int indxLayer, int indxAbsorber, int /*eventID*/, int /*stepID*/) {
+void SteppingLoop::SteppingAction(Results& theResult, const G4HepEmTrack& theTrack, const Box* /*currentVolume*/, double currentPhysStepLength, int indxLayer, int indxAbsorber, int indxCell, int /*eventID*/, int /*stepID*/) {
   if (indxLayer < 0) return;
   //
   const double edep = theTrack.GetEnergyDeposit();
@@ -319,6 +304,17 @@ void SteppingLoop::SteppingAction(Results& theResult, const G4HepEmTrack& theTra
       default: //
               break;
     }
+    if (indxCell > -1) {
+      if (theResult.fIsReproducible) {
+        theResult.fEdepPerCellExact[indxCell].Add(edep);
+      } else {
+        theResult.fEdepPerCell[indxCell] += edep;
+      }
+    }
+    // NOTE: the energy deposit is assigned to the voxel of the post-step point
+    if (theResult.fEdepMesh.IsActive()) {
+      theResult.fEdepMesh.Fill(theTrack.GetPosition(), edep);
+    }
   }
 
   //
@@ -333,6 +329,44 @@ void SteppingLoop::SteppingAction(Results& theResult, const G4HepEmTrack& theTra
 }
 
 
+void SteppingLoop::ApplyMSCDisplacement(G4HepEmTrack& theTrack, G4HepEmMSCTrackData& theMSCData, const Box* currentVolume, double* localPosition, const double* orgDirection, double stepLength) {
+  // get the displacement and check if we need to apply (should not if the energy is zero but ok keep its simply)
+  // we apply it if its length is lonegr than a minimum
+  double* globalPosition        = theTrack.GetPosition();
+  const double* displacement    = theMSCData.GetDisplacement();
+  const double  dLength2        = displacement[0]*displacement[0] + displacement[1]*displacement[1] + displacement[2]*displacement[2];
+  const double  kGeomMinLength  = 5.0e-8;  // 0.05 [nm]
+  const double  kGeomMinLength2 = kGeomMinLength*kGeomMinLength; // (0.05 [nm])^2
+  if (dLength2 > kGeomMinLength2) {
+    // apply displacement
+    // bool isPositionChanged  = true;
+    const double dispR = std::sqrt(dLength2);
+    // update local position by moving to the local longitudinal (i.e. along the original direction) post step-point
+    // just to be able to compute the safety at that point
+    AddTo3Vect(localPosition, orgDirection, stepLength);
+    // compute the current post-step point safety and reduce a bit
+    const double postSafety = 0.99*currentVolume->DistanceToOut(localPosition);
+    if (postSafety > 0.0 && dispR < postSafety) {
+      // far away from boundary: can be applied safely i.e. we won't get to boundary
+      AddTo3Vect(globalPosition, displacement);
+      //near the boundary
+    } else {
+      // displaced point is definitely within the volume
+      if (dispR < postSafety) {
+        AddTo3Vect(globalPosition, displacement);
+      } else if(postSafety > kGeomMinLength) {
+        // reduced displacement
+        const double scale = (postSafety/dispR);
+        AddTo3Vect(globalPosition, displacement, scale);
+      } // else {
+        // very small postSafety
+        // isPositionChanged = false;
+      // }
+    }
+  }
+}
+
+
 // some utilities to modify 3vectors
 void SteppingLoop::Set3Vect(double* v, double to) {
   v[0] = to;
@@ -0,0 +1,103 @@
+#include "TrackBasket.hh"
+
+#include "G4HepEmTrack.hh"
+
+TrackBasket::TrackBasket(bool isGamma, int capacity, G4HepEmRandomEngine* theRandomEngine)
+: fIsGamma(isGamma),
+  fCapacity(capacity),
+  fSize(0),
+  fTLData(capacity) {
+  fPosX.resize(fCapacity);
+  fPosY.resize(fCapacity);
+  fPosZ.resize(fCapacity);
+  fDirX.resize(fCapacity);
+  fDirY.resize(fCapacity);
+  fDirZ.resize(fCapacity);
+  fDistToBoundary.resize(fCapacity);
+  fSafety.resize(fCapacity);
+  fDistToPhysics.resize(fCapacity);
+  fStepLength.resize(fCapacity);
+  fPhysStepLength.resize(fCapacity);
+  fNavState.resize(fCapacity);
+  fNumSteps.resize(fCapacity);
+  fIsAlive.resize(fCapacity);
+  fIsNew.resize(fCapacity);
+  fOnBoundary.resize(fCapacity);
+  fWasOnBoundary.resize(fCapacity);
+  fIsPushed.resize(fCapacity);
+  // only the primary track, that corresponds to the type of this basket, is used in each slot
+  fTracks.resize(fCapacity);
+  for (int i=0; i<fCapacity; ++i) {
+    fTLData[i].SetRandomEngine(theRandomEngine);
+    fTracks[i] = fIsGamma ? GetGammaTrack(i).GetTrack() : GetElectronTrack(i).GetTrack();
+  }
+}
+
+
+G4HepEmTrack* const* TrackBasket::Insert(int num) {
+  const int first = fSize;
+  fSize += num;
+  for (int i=first; i<fSize; ++i) {
+    // the track will be loaded into the arrays at the beginning of the next step
+    fIsAlive[i]       = 1;
+    fIsNew[i]         = 1;
+    fNumSteps[i]      = 0;
+    fWasOnBoundary[i] = 0;
+    fIsPushed[i]      = 0;
+    // not located yet
+    fNavState[i].ReSet();
+    // reset the `G4HepEm` state of the track (i.e. before "start-tracking")
+    if (fIsGamma) {
+      GetGammaTrack(i).ReSet();
+    } else {
+      GetElectronTrack(i).ReSet();
+    }
+  }
+  return &fTracks[first];
+}
+
+
+void TrackBasket::Compact() {
+  // NOTE: only the slots of the terminated tracks are filled (by the last alive tracks)
+  //       so the tracks are moved (copied) only when a track before them terminated
+  for (int i=0; i<fSize; ++i) {
+    if (fIsAlive[i]) {
+      continue;
+    }
+    // drop the terminated tracks from the end then move the last one into this slot
+    while (fSize > i+1 && !fIsAlive[fSize-1]) {
+      --fSize;
+    }
+    --fSize;
+    if (i < fSize) {
+      MoveSlot(fSize, i);
+    }
+  }
+}
+
+
+void TrackBasket::MoveSlot(int from, int to) {
+  fPosX[to]           = fPosX[from];
+  fPosY[to]           = fPosY[from];
+  fPosZ[to]           = fPosZ[from];
+  fDirX[to]           = fDirX[from];
+  fDirY[to]           = fDirY[from];
+  fDirZ[to]           = fDirZ[from];
+  fDistToBoundary[to] = fDistToBoundary[from];
+  fSafety[to]         = fSafety[from];
+  fDistToPhysics[to]  = fDistToPhysics[from];
+  fStepLength[to]     = fStepLength[from];
+  fPhysStepLength[to] = fPhysStepLength[from];
+  fNavState[to]       = fNavState[from];
+  fNumSteps[to]       = fNumSteps[from];
+  fIsAlive[to]        = fIsAlive[from];
+  fIsNew[to]          = fIsNew[from];
+  fOnBoundary[to]     = fOnBoundary[from];
+  fWasOnBoundary[to]  = fWasOnBoundary[from];
+  fIsPushed[to]       = fIsPushed[from];
+  if (fIsGamma) {
+    GetGammaTrack(to)    = GetGammaTrack(from);
+  } else {
+    GetElectronTrack(to) = GetElectronTrack(from);
+  }
+}
@@ -1,58 +1,200 @@
-
 #include "TrackStack.hh"
 
 #include "G4HepEmTrack.hh"
 
+#include <algorithm>
+
 TrackStack::TrackStack()
-: fSize(16),
+: fSize(0),
   fCurIndx(-1),
-  fCurrentTrackID(0) {
-  fTrackVect.resize(fSize);
+  fBottomIndx(0),
+  fPeakNumTracks(0),
+  fCurrentTrackID(0),
+  fFirstTrackID(0),
+  fTrackIDStride(1),
+  fNumPendingTracks(nullptr) {
+  Reserve(16);
 }
 
 
 int TrackStack::PopInto(G4HepEmTrack& track) {
+  // the stack is guarded by the lock only in `shared` mode
+  std::unique_lock<std::mutex> lock(fMutex, std::defer_lock);
+  if (fNumPendingTracks) lock.lock();
   // return -1 if the secondary stack is empty
-  if (fCurIndx<0) {
+  if (fCurIndx<fBottomIndx) {
     return -1;
   }
   // compy the next avaiable seconday track to the primary
-  Copy(fTrackVect[fCurIndx], track);
-  // return with the currently used secondary index and decrease
-  return fCurIndx--;
+  Read(fCurIndx, track);
+  // reset the bottom when the last track has been taken
+  const int indx = fCurIndx--;
+  if (fCurIndx<fBottomIndx) {
+    fCurIndx    = -1;
+    fBottomIndx =  0;
+  }
+  // return with the currently used secondary index
+  return indx;
+}
+
+
+int TrackStack::PopInto(G4HepEmTrack* const* tracks, int num) {
+  std::unique_lock<std::mutex> lock(fMutex, std::defer_lock);
+  if (fNumPendingTracks) lock.lock();
+  int numPopped = 0;
+  for (; numPopped<num && fCurIndx>=fBottomIndx; ++numPopped, --fCurIndx) {
+    Read(fCurIndx, *tracks[numPopped]);
+  }
+  if (fCurIndx<fBottomIndx) {
+    fCurIndx    = -1;
+    fBottomIndx =  0;
+  }
+  return numPopped;
+}
+
+
+int TrackStack::StealInto(G4HepEmTrack& track) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  // return -1 if the secondary stack is empty
+  if (fCurIndx<fBottomIndx) {
+    return -1;
+  }
+  // copy the oldest track, i.e. the one at the bottom
+  Read(fBottomIndx, track);
+  // reset the bottom when the last track has been taken
+  const int indx = fBottomIndx++;
+  if (fCurIndx<fBottomIndx) {
+    fCurIndx    = -1;
+    fBottomIndx =  0;
+  }
+  return indx;
 }
 
 
 int TrackStack::GetTypeOfNextTrack() {
-  if (fCurIndx<0) {
+  std::unique_lock<std::mutex> lock(fMutex, std::defer_lock);
+  if (fNumPendingTracks) lock.lock();
+  if (fCurIndx<fBottomIndx) {
     return -999;
   }
-  return fTrackVect[fCurIndx].GetCharge();
+  return fCharge[fCurIndx];
+}
+
+
+int TrackStack::GetNumNextTracksOfType(bool isGamma, int maxNum) {
+  std::unique_lock<std::mutex> lock(fMutex, std::defer_lock);
+  if (fNumPendingTracks) lock.lock();
+  int num = 0;
+  for (int i=fCurIndx; i>=fBottomIndx && num<maxNum && (fCharge[i]==0)==isGamma; --i) {
+    ++num;
+  }
+  return num;
+}
+
+
+void TrackStack::Push(G4HepEmTrack& track) {
+  std::unique_lock<std::mutex> lock(fMutex, std::defer_lock);
+  if (fNumPendingTracks) {
+    lock.lock();
+    fNumPendingTracks->fetch_add(1);
+  }
+  Reserve(fCurIndx+2);
+  Write(++fCurIndx, track);
+  fPeakNumTracks = std::max(fPeakNumTracks, fCurIndx+1-fBottomIndx);
+}
+
+
+void TrackStack::Push(G4HepEmTrack* const* tracks, int num) {
+  std::unique_lock<std::mutex> lock(fMutex, std::defer_lock);
+  if (fNumPendingTracks) {
+    lock.lock();
+    fNumPendingTracks->fetch_add(num);
+  }
+  Reserve(fCurIndx+1+num);
+  for (int it=0; it<num; ++it) {
+    Write(++fCurIndx, *tracks[it]);
+  }
+  fPeakNumTracks = std::max(fPeakNumTracks, fCurIndx+1-fBottomIndx);
 }
 
 
-G4HepEmTrack& TrackStack::Insert() {
-  // make sure that the size if fine
-  ++fCurIndx;
-  if (fCurIndx==fSize) {
-    fSize *= 2;
-    fTrackVect.resize(fSize);
+void TrackStack::PushSecondaries(G4HepEmTrack* const* secondaries, int num, G4HepEmTrack& parent) {
+  std::unique_lock<std::mutex> lock(fMutex, std::defer_lock);
+  if (fNumPendingTracks) {
+    lock.lock();
+    fNumPendingTracks->fetch_add(num);
+  }
+  Reserve(fCurIndx+1+num);
+  const double* pos = parent.GetPosition();
+  const int parentID = parent.GetID();
+  const int mcIndex  = parent.GetMCIndex();
+  for (int it=0; it<num; ++it) {
+    G4HepEmTrack& sec = *secondaries[it];
+    const double* dir = sec.GetDirection();
+    const int indx    = ++fCurIndx;
+    fPosX[indx]     = pos[0];
+    fPosY[indx]     = pos[1];
+    fPosZ[indx]     = pos[2];
+    fDirX[indx]     = dir[0];
+    fDirY[indx]     = dir[1];
+    fDirZ[indx]     = dir[2];
+    fEKin[indx]     = sec.GetEKin();
+    fLogEKin[indx]  = sec.GetLogEKin();
+    fCharge[indx]   = static_cast<signed char>(sec.GetCharge());
+    fID[indx]       = GetNextTrackID();
+    fParentID[indx] = parentID;
+    fMCIndex[indx]  = mcIndex;
   }
-  // retrun a eference to the next avaiable secondary track
-  fTrackVect[fCurIndx].ReSet();
-  return fTrackVect[fCurIndx];
+  fPeakNumTracks = std::max(fPeakNumTracks, fCurIndx+1-fBottomIndx);
+}
+
+
+void TrackStack::Reserve(int num) {
+  if (num <= fSize) {
+    return;
+  }
+  // grow the capacity (at least double it)
+  fSize = std::max(num, 2*fSize);
+  fPosX.resize(fSize);
+  fPosY.resize(fSize);
+  fPosZ.resize(fSize);
+  fDirX.resize(fSize);
+  fDirY.resize(fSize);
+  fDirZ.resize(fSize);
+  fEKin.resize(fSize);
+  fLogEKin.resize(fSize);
+  fCharge.resize(fSize);
+  fID.resize(fSize);
+  fParentID.resize(fSize);
+  fMCIndex.resize(fSize);
+}
+
+
+void TrackStack::Write(int indx, G4HepEmTrack& track) {
+  const double* pos = track.GetPosition();
+  const double* dir = track.GetDirection();
+  fPosX[indx]     = pos[0];
+  fPosY[indx]     = pos[1];
+  fPosZ[indx]     = pos[2];
+  fDirX[indx]     = dir[0];
+  fDirY[indx]     = dir[1];
+  fDirZ[indx]     = dir[2];
+  fEKin[indx]     = track.GetEKin();
+  fLogEKin[indx]  = track.GetLogEKin();
+  fCharge[indx]   = static_cast<signed char>(track.GetCharge());
+  fID[indx]       = track.GetID();
+  fParentID[indx] = track.GetParentID();
+  fMCIndex[indx]  = track.GetMCIndex();
 }
 
 
-void TrackStack::Copy(G4HepEmTrack& from, G4HepEmTrack& to) {
-  to.ReSet();
-  to.SetPosition(from.GetPosition());
-  to.SetDirection(from.GetDirection());
-  to.SetEKin(from.GetEKin(), from.GetLogEKin());
-  to.SetCharge(from.GetCharge());
-  to.SetSafety(from.GetSafety());
-  to.SetID(from.GetID());
-  to.SetParentID(from.GetParentID());
-  to.SetMCIndex(from.GetMCIndex());
-  to.SetOnBoundary(from.GetOnBoundary());
+void TrackStack::Read(int indx, G4HepEmTrack& track) const {
+  // NOTE: the track is expected to be re-set by the caller
+  track.SetPosition(fPosX[indx], fPosY[indx], fPosZ[indx]);
+  track.SetDirection(fDirX[indx], fDirY[indx], fDirZ[indx]);
+  track.SetEKin(fEKin[indx], fLogEKin[indx]);
+  track.SetCharge(fCharge[indx]);
+  track.SetID(fID[indx]);
+  track.SetParentID(fParentID[indx]);
+  track.SetMCIndex(fMCIndex[indx]);
 }
@@ -1,15 +1,155 @@
 
 #include "URandom.hh"
 
-URandom::URandom(int seed) {
-  fEngine.seed(seed);
-  fDist = new std::uniform_real_distribution<double>(0.0, 1.0);
+// the Philox4x32 multipliers and the Weyl sequence constants of the key schedule
+static const std::uint32_t kPhiloxM0 = 0xD2511F53U;
+static const std::uint32_t kPhiloxM1 = 0xCD9E8D57U;
+static const std::uint32_t kPhiloxW0 = 0x9E3779B9U;
+static const std::uint32_t kPhiloxW1 = 0xBB67AE85U;
+
+// one round of the Philox4x32 bijection (in place) with the given key
+static inline void PhiloxRound(std::uint32_t* ctr, std::uint32_t key0, std::uint32_t key1) {
+  const std::uint64_t prod0 = static_cast<std::uint64_t>(kPhiloxM0)*ctr[0];
+  const std::uint64_t prod1 = static_cast<std::uint64_t>(kPhiloxM1)*ctr[2];
+  const std::uint32_t x0 = static_cast<std::uint32_t>(prod1 >> 32) ^ ctr[1] ^ key0;
+  const std::uint32_t x2 = static_cast<std::uint32_t>(prod0 >> 32) ^ ctr[3] ^ key1;
+  ctr[1] = static_cast<std::uint32_t>(prod1);
+  ctr[3] = static_cast<std::uint32_t>(prod0);
+  ctr[0] = x0;
+  ctr[2] = x2;
+}
+
+// the upper 53 bits of the 64 bit integer to double on (0,1) (never 0 or 1)
+static inline double ToOpenUnit(std::uint32_t hi, std::uint32_t lo) {
+  const std::uint64_t u = (static_cast<std::uint64_t>(hi) << 32) | lo;
+  return (static_cast<double>(u >> 11) + 0.5)*(1.0/9007199254740992.0);
+}
+
+
+URandom::URandom(int seed, EngineType engine)
+: fEngineType(engine),
+  fKey{0, 0},
+  fStreamID(0),
+  fCounter(0),
+  fIndxInBuffer(kBufferSize),
+  fBufferPosition(0),
+  fDist(0.0, 1.0),
+  fMTSeed(seed) {
+  if (fEngineType == EngineType::kMersenneTwister) {
+    fMTEngine.reset(new std::mt19937_64());
+    fMTEngine->seed(fMTSeed);
+  } else {
+    const std::uint64_t key = SplitMix64(seed);
+    fKey[0] = static_cast<std::uint32_t>(key);
+    fKey[1] = static_cast<std::uint32_t>(key >> 32);
+  }
+}
+
+URandom::~URandom() {}
+
+void URandom::Refill() {
+  fBufferPosition += fIndxInBuffer;
+  fIndxInBuffer    = 0;
+  if (fEngineType == EngineType::kPhilox) {
+    Philox4x32Blocks(fCounter, kBufferSize/2, fBuffer);
+    fCounter += kBufferSize/2;
+    return;
+  }
+  for (int i = 0; i < kBufferSize; ++i) {
+    fBuffer[i] = fDist(*fMTEngine);
+  }
+}
+
+void URandom::flatArray(int size, double* vect) {
+  // the remaining numbers of the buffer first
+  int i = 0;
+  while (i < size && fIndxInBuffer < kBufferSize) {
+    vect[i++] = fBuffer[fIndxInBuffer++];
+  }
+  // then (the buffer is empty now if there are still numbers to fill) the
+  // full Philox blocks directly into the array
+  if (fEngineType == EngineType::kPhilox && i < size) {
+    const int numBlocks = (size - i)/2;
+    Philox4x32Blocks(fCounter, numBlocks, vect + i);
+    fCounter       += numBlocks;
+    fBufferPosition = 2*fCounter - kBufferSize;
+    i += 2*numBlocks;
+  }
+  // the rest through the buffer
+  for (; i < size; ++i) {
+    vect[i] = flat();
+  }
+}
+
+void URandom::SetSeed(std::uint64_t seed, std::uint64_t streamID) {
+  // drop the buffered numbers of the previous stream (the position is 0 then)
+  fIndxInBuffer   = kBufferSize;
+  fBufferPosition = -static_cast<std::uint64_t>(kBufferSize);
+  if (fEngineType == EngineType::kMersenneTwister) {
+    fMTSeed = SplitMix64(SplitMix64(seed) + streamID);
+    fMTEngine->seed(fMTSeed);
+    // NOTE: the distribution doesn't cache anything for doubles but reset anyway
+    fDist.reset();
+    return;
+  }
+  // the key is derived from the seed while the stream is selected by its ID
+  const std::uint64_t key = SplitMix64(seed);
+  fKey[0]   = static_cast<std::uint32_t>(key);
+  fKey[1]   = static_cast<std::uint32_t>(key >> 32);
+  fStreamID = streamID;
+  fCounter  = 0;
+}
+
+void URandom::SetPosition(std::uint64_t position) {
+  if (fEngineType == EngineType::kPhilox) {
+    // start the buffer at the block of the required number
+    fCounter        = position/2;
+    fBufferPosition = 2*fCounter - kBufferSize;
+    fIndxInBuffer   = kBufferSize;
+    Refill();
+    fIndxInBuffer   = static_cast<int>(position%2);
+    return;
+  }
+  fMTEngine->seed(fMTSeed);
+  fMTEngine->discard(position);
+  fBufferPosition = position - kBufferSize;
+  fIndxInBuffer   = kBufferSize;
+}
+
+std::uint64_t URandom::SplitMix64(std::uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x  = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x  = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
 }
 
-URandom::~URandom() {
-  delete fDist;
+void URandom::Philox4x32(const std::uint32_t* ctr, const std::uint32_t* key, std::uint32_t* out) {
+  std::uint32_t x[4] = { ctr[0], ctr[1], ctr[2], ctr[3] };
+  std::uint32_t key0 = key[0];
+  std::uint32_t key1 = key[1];
+  for (int ir = 0; ir < 10; ++ir) {
+    PhiloxRound(x, key0, key1);
+    key0 += kPhiloxW0;
+    key1 += kPhiloxW1;
+  }
+  out[0] = x[0]; out[1] = x[1]; out[2] = x[2]; out[3] = x[3];
 }
 
-double URandom::flat() {
-  return fDist->operator()(fEngine);
+void URandom::Philox4x32Blocks(std::uint64_t counter, int numBlocks, double* out) const {
+  // NOTE: the blocks are independent so this loop can be vectorised
+  const std::uint32_t stream0 = static_cast<std::uint32_t>(fStreamID);
+  const std::uint32_t stream1 = static_cast<std::uint32_t>(fStreamID >> 32);
+  for (int ib = 0; ib < numBlocks; ++ib) {
+    const std::uint64_t theCounter = counter + ib;
+    std::uint32_t x[4] = { static_cast<std::uint32_t>(theCounter), static_cast<std::uint32_t>(theCounter >> 32), stream0, stream1 };
+    std::uint32_t key0 = fKey[0];
+    std::uint32_t key1 = fKey[1];
+    for (int ir = 0; ir < 10; ++ir) {
+      PhiloxRound(x, key0, key1);
+      key0 += kPhiloxW0;
+      key1 += kPhiloxW1;
+    }
+    out[2*ib]   = ToOpenUnit(x[0], x[1]);
+    out[2*ib+1] = ToOpenUnit(x[2], x[3]);
+  }
 }